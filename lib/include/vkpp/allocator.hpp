@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp
+{
+	class Device;
+	class MemoryBlock;
+
+	/// Smallest node a memory block can be split into, and default size of a block
+	inline constexpr VkDeviceSize MEMORY_BLOCK_MIN_NODE_SIZE {256};
+	inline constexpr VkDeviceSize MEMORY_BLOCK_DEFAULT_SIZE {64 * 1024 * 1024};
+
+	/// Lightweight handle on a suballocation. `block` is nullptr for dedicated allocations
+	struct Allocation
+	{
+		VkDeviceMemory memory {VK_NULL_HANDLE};
+		VkDeviceSize offset {0};
+		VkDeviceSize size {0};
+		void *mapped {nullptr};
+		uint32_t memoryType {0};
+		vkpp::MemoryBlock *block {nullptr};
+	};
+
+	struct Buffer
+	{
+		VkBuffer buffer {VK_NULL_HANDLE};
+		VkDeviceSize size {0};
+		vkpp::Allocation allocation {};
+	};
+
+	struct Image
+	{
+		VkImage image {VK_NULL_HANDLE};
+		VkFormat format {VK_FORMAT_UNDEFINED};
+		VkExtent3D extent {0, 0, 0};
+		uint32_t mipLevels {1};
+		uint32_t arrayLayers {1};
+		vkpp::Allocation allocation {};
+	};
+
+	/// Snapshot of a block taken under the allocator's lock
+	struct MemoryBlockInfo
+	{
+		VkDeviceSize size;
+		VkDeviceSize used;
+		uint32_t allocationCount;
+		uint32_t memoryType;
+		bool linear;
+	};
+
+	struct AllocatorStatistics
+	{
+		uint32_t blockCount {0};
+		uint32_t dedicatedAllocationCount {0};
+		uint64_t allocationCount {0};
+		uint64_t deviceAllocationCount {0};
+		VkDeviceSize reservedBytes {0};
+		VkDeviceSize usedBytes {0};
+		VkDeviceSize requestedBytes {0};
+	};
+
+
+	/// A single VkDeviceMemory carved with a buddy allocator
+	class MemoryBlock
+	{
+		public:
+			MemoryBlock(vkpp::Device &device, uint32_t memoryType, VkDeviceSize size, bool hostVisible, bool linear);
+			~MemoryBlock();
+
+			std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment);
+			void free(VkDeviceSize offset);
+
+			inline VkDeviceMemory get() const noexcept {return m_memory;}
+			inline void *getMapped() const noexcept {return m_mapped;}
+			inline uint32_t getMemoryType() const noexcept {return m_memoryType;}
+			inline VkDeviceSize getSize() const noexcept {return m_size;}
+			inline VkDeviceSize getUsed() const noexcept {return m_used;}
+			inline bool isLinear() const noexcept {return m_linear;}
+			inline bool isEmpty() const noexcept {return m_allocatedOrders.empty();}
+			inline uint32_t getAllocationCount() const noexcept {return static_cast<uint32_t> (m_allocatedOrders.size());}
+
+		private:
+			static uint32_t s_getOrder(VkDeviceSize size);
+
+			vkpp::Device &m_device;
+			VkDeviceMemory m_memory;
+			void *m_mapped;
+			uint32_t m_memoryType;
+			VkDeviceSize m_size;
+			VkDeviceSize m_used;
+			bool m_linear;
+			std::vector<std::set<VkDeviceSize>> m_freeLists;
+			std::unordered_map<VkDeviceSize, uint32_t> m_allocatedOrders;
+	};
+
+
+	class Allocator
+	{
+		public:
+			Allocator(vkpp::Device &device, VkDeviceSize blockSize = vkpp::MEMORY_BLOCK_DEFAULT_SIZE);
+			~Allocator();
+
+			/// `linear` must be false for optimal-tiling images so they never share a block with buffers
+			vkpp::Allocation allocate(
+				const VkMemoryRequirements &requirements,
+				VkMemoryPropertyFlags required,
+				VkMemoryPropertyFlags preferred = 0,
+				bool linear = true
+			);
+			void free(vkpp::Allocation &allocation);
+			/// Suballocates in the fullest non empty block of `memoryType` that fits, never in `source` nor in a new
+			/// block, so that moving an allocation out of `source` compacts the pool
+			std::optional<vkpp::Allocation> allocateForRelocation(
+				const VkMemoryRequirements &requirements,
+				uint32_t memoryType,
+				bool linear,
+				const vkpp::MemoryBlock *source
+			);
+
+			vkpp::Buffer createBuffer(
+				VkDeviceSize size,
+				VkBufferUsageFlags usage,
+				VkMemoryPropertyFlags required,
+				VkMemoryPropertyFlags preferred = 0
+			);
+			void destroyBuffer(vkpp::Buffer &buffer);
+
+			vkpp::Image createImage(
+				const VkImageCreateInfo &createInfo,
+				VkMemoryPropertyFlags required,
+				VkMemoryPropertyFlags preferred = 0
+			);
+			void destroyImage(vkpp::Image &image);
+
+			uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0) const;
+			vkpp::AllocatorStatistics getStatistics();
+			vkpp::MemoryBlockInfo getBlockInfo(const vkpp::MemoryBlock &block);
+			/// Bytes of device memory the allocator holds in each heap, blocks and dedicated allocations alike
+			std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> getHeapUsage();
+			/// Bytes of the blocks left free in each heap : held from the driver, but reusable by the next allocations
+			std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> getHeapFreeBytes();
+
+			inline VkDeviceSize getBlockSize() const noexcept {return m_blockSize;}
+
+
+		private:
+			vkpp::Allocation s_allocateDedicated(VkDeviceSize size, uint32_t memoryType);
+
+			vkpp::Device &m_device;
+			const VkPhysicalDeviceMemoryProperties &m_memoryProperties;
+			VkDeviceSize m_blockSize;
+			std::mutex m_mutex;
+			/// One list of blocks per memory type and per linear / optimal resources
+			std::vector<std::vector<std::unique_ptr<vkpp::MemoryBlock>>> m_pools;
+			vkpp::AllocatorStatistics m_statistics;
+			std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_heapUsage;
+	};
+
+} // namespace vkpp
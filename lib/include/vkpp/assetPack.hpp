@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+#include "stagingRing.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	constexpr uint32_t ASSET_PACK_FILE_MAGIC {0x4b505056}; // "VPPK"
+	constexpr uint32_t ASSET_PACK_FILE_VERSION {1};
+	/// Payloads start on this boundary, a page : each one maps and reads in whole pages of its own
+	constexpr uint64_t ASSET_PACK_ALIGNMENT {4096};
+	constexpr uint32_t ASSET_PACK_MAX_NAME_SIZE {64};
+	constexpr uint32_t ASSET_PACK_MAX_MIP_LEVELS {16};
+
+	enum class AssetType : uint32_t
+	{
+		buffer,
+		image
+	};
+
+	/// The entries follow the header, the payloads follow the entries
+	struct AssetPackFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t reserved;
+		uint64_t fileSize;
+	};
+
+	/// An image's payload holds its mips from the most detailed one, each with its layers one after the other,
+	/// tightly packed in the layout vkCmdCopyBufferToImage reads. `mipOffsets` are relative to the payload
+	struct AssetPackEntry
+	{
+		char name[vkpp::ASSET_PACK_MAX_NAME_SIZE];
+		vkpp::AssetType type;
+		VkFormat format;
+		VkExtent3D extent;
+		uint32_t mipLevels;
+		uint32_t arrayLayers;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t mipOffsets[vkpp::ASSET_PACK_MAX_MIP_LEVELS];
+	};
+
+
+	/// Read-only mapping of a pack written by AssetPackWriter. Payloads are copied from the mapping straight into
+	/// the staging ring, so that each byte is touched once between the disk and the GPU, with no intermediate
+	/// buffer nor parsing. The uploads are flushed by the caller, and acquired through the ring's recordAcquires()
+	/// when it lives in another queue family. Thread safe once opened
+	class AssetPack
+	{
+		public:
+			AssetPack(vkpp::Device &device, const std::filesystem::path &path);
+			~AssetPack();
+
+			AssetPack(const vkpp::AssetPack &) = delete;
+			vkpp::AssetPack &operator=(const vkpp::AssetPack &) = delete;
+
+			/// nullptr when the pack holds no asset of that name
+			const vkpp::AssetPackEntry *find(std::string_view name) const;
+			std::span<const std::byte> getPayload(const vkpp::AssetPackEntry &entry) const;
+			std::span<const std::byte> getMip(const vkpp::AssetPackEntry &entry, uint32_t mipLevel) const;
+			/// Lets the OS read the payload ahead, in the background, of the load that will touch it
+			void prefetch(const vkpp::AssetPackEntry &entry) const;
+
+			/// Device local buffer of `usage`, its contents staged in `ring`
+			vkpp::Buffer loadBuffer(vkpp::StagingRing &ring, const vkpp::AssetPackEntry &entry, VkBufferUsageFlags usage);
+			/// Device local image of `usage`, its contents staged in `ring`. It is tracked in `finalLayout` right away,
+			/// as it is by the time the ring's submission completed
+			vkpp::Image loadImage(
+				vkpp::StagingRing &ring,
+				const vkpp::AssetPackEntry &entry,
+				VkImageUsageFlags usage,
+				VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			);
+
+			inline std::span<const vkpp::AssetPackEntry> getEntries() const noexcept {return m_entries;}
+			inline size_t getSize() const noexcept {return m_size;}
+
+
+		private:
+			void s_map(const std::filesystem::path &path);
+			void s_unmap() noexcept;
+			void s_validate(const std::filesystem::path &path);
+
+			vkpp::Device &m_device;
+			const std::byte *m_data;
+			size_t m_size;
+			/// File mapping object, Windows only
+			void *m_mapping;
+			std::span<const vkpp::AssetPackEntry> m_entries;
+			std::unordered_map<std::string_view, const vkpp::AssetPackEntry*> m_names;
+	};
+
+} // namespace vkpp
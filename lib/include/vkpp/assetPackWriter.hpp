@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "assetPack.hpp"
+
+
+namespace vkpp
+{
+	/// Builds an asset pack in memory and writes it in one go. Image mips are expected already transcoded to
+	/// `format`, most detailed first, each holding its layers one after the other. Depends on no Vulkan call, so
+	/// that offline tools only need the headers
+	class AssetPackWriter
+	{
+		public:
+			AssetPackWriter() = default;
+			~AssetPackWriter() = default;
+
+			void addBuffer(std::string_view name, std::vector<std::byte> data);
+			void addImage(std::string_view name, VkFormat format, VkExtent3D extent, uint32_t arrayLayers, std::vector<std::vector<std::byte>> mips);
+			/// Writes the pack next to its path then renames it over, so that a crash never leaves a torn file
+			void write(const std::filesystem::path &path) const;
+
+			inline size_t getAssetCount() const noexcept {return m_assets.size();}
+
+
+		private:
+			struct PendingAsset
+			{
+				vkpp::AssetPackEntry entry;
+				std::vector<std::vector<std::byte>> payloads;
+			};
+
+			vkpp::AssetPackEntry s_makeEntry(std::string_view name, vkpp::AssetType type) const;
+
+			std::vector<PendingAsset> m_assets;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp
+{
+	class Device;
+
+	using BindlessIndex = uint32_t;
+
+	constexpr vkpp::BindlessIndex BINDLESS_INVALID_INDEX {std::numeric_limits<vkpp::BindlessIndex>::max()};
+
+	/// Each type is an array of its own binding of the heap's set, in this order
+	enum class BindlessType
+	{
+		sampledImage,
+		storageBuffer,
+		sampler
+	};
+
+	constexpr uint32_t BINDLESS_TYPE_AMOUNT {3};
+
+	/// Clamped to the device's update after bind limits
+	struct BindlessHeapParameters
+	{
+		uint32_t sampledImageCount {65536};
+		uint32_t storageBufferCount {65536};
+		uint32_t samplerCount {1024};
+	};
+
+	/// Accumulated since the last call to BindlessHeap::resetStatistics()
+	struct BindlessStatistics
+	{
+		uint64_t allocatedCount;
+		uint64_t releasedCount;
+		/// Descriptors written, and the VkWriteDescriptorSet they were packed into
+		uint64_t descriptorWriteCount;
+		uint64_t writeCount;
+		uint64_t flushCount;
+	};
+
+	struct BindlessSlots
+	{
+		uint32_t capacity;
+		/// Slots below it were handed out at least once
+		uint32_t next;
+		std::vector<vkpp::BindlessIndex> free;
+		/// Per slot below `next`, whether it was released since it was last handed out
+		std::vector<bool> released;
+	};
+
+	struct BindlessDescriptor
+	{
+		VkDescriptorImageInfo image;
+		VkDescriptorBufferInfo buffer;
+	};
+
+	/// One descriptor set for the whole device, with an update after bind array per descriptor type. Resources get
+	/// an index that stays valid until released, shaders index the arrays with it, and the set is bound once per
+	/// command buffer instead of a set per draw. Writes are queued and sent in a single vkUpdateDescriptorSets by
+	/// flush(), which the frame loops call before submitting. Released indices are only reused once the frames
+	/// that may still read them retired. Thread safe
+	class BindlessHeap
+	{
+		public:
+			BindlessHeap(vkpp::Device &device, const vkpp::BindlessHeapParameters &parameters);
+			/// Waits for the device through its deletion queue
+			~BindlessHeap();
+
+			vkpp::BindlessIndex addSampledImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			vkpp::BindlessIndex addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+			vkpp::BindlessIndex addSampler(VkSampler sampler);
+			/// Points an index to another resource. The index must not be used by any pending submission : to swap
+			/// what frames in flight may be reading, add the new resource and release() the old index instead
+			void updateSampledImage(vkpp::BindlessIndex index, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			void updateStorageBuffer(vkpp::BindlessIndex index, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+			void updateSampler(vkpp::BindlessIndex index, VkSampler sampler);
+			/// The index may still be read by the frames in flight, it is recycled through the deletion queue. Throws
+			/// when the index was already released
+			void release(vkpp::BindlessType type, vkpp::BindlessIndex index);
+
+			/// Sends the queued writes, neighbouring indices of a type sharing a VkWriteDescriptorSet
+			void flush();
+			void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t set = 0) const;
+			void resetStatistics() noexcept;
+
+			inline VkDescriptorSetLayout getLayout() const noexcept {return m_layout;}
+			inline VkDescriptorSet getSet() const noexcept {return m_set;}
+			inline uint32_t getCapacity(vkpp::BindlessType type) const noexcept {return m_slots[static_cast<uint32_t> (type)].capacity;}
+			inline const vkpp::BindlessStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			vkpp::BindlessIndex s_allocate(vkpp::BindlessType type);
+			void s_write(vkpp::BindlessType type, vkpp::BindlessIndex index, const vkpp::BindlessDescriptor &descriptor);
+
+			vkpp::Device &m_device;
+			VkDescriptorSetLayout m_layout;
+			VkDescriptorPool m_pool;
+			VkDescriptorSet m_set;
+			std::mutex m_mutex;
+			std::array<vkpp::BindlessSlots, vkpp::BINDLESS_TYPE_AMOUNT> m_slots;
+			/// Keyed by type then index, so that neighbouring writes are next to each other
+			std::map<uint64_t, vkpp::BindlessDescriptor> m_pending;
+			vkpp::BindlessStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "queueType.hpp"
+#include "utils/threadPool.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	struct ThreadCommands
+	{
+		VkCommandPool pool;
+		std::vector<VkCommandBuffer> secondaries;
+		uint32_t used;
+	};
+
+	struct FrameCommands
+	{
+		VkCommandPool pool;
+		VkCommandBuffer primary;
+		std::vector<vkpp::ThreadCommands> threads;
+	};
+
+
+	/// Per frame in flight and per worker thread command pools. Pools are reset wholesale by beginFrame() and
+	/// their command buffers reused, so that recording a frame never allocates once warmed up
+	class CommandContext
+	{
+		public:
+			using RecordFunction = std::function<void(VkCommandBuffer, uint32_t)>;
+
+			CommandContext(
+				vkpp::Device &device,
+				vkpp::QueueType queue,
+				uint32_t framesInFlight,
+				uint32_t threadCount = std::thread::hardware_concurrency()
+			);
+			~CommandContext();
+
+			/// The frame slot's previous submission must have retired. Returns the begun primary command buffer
+			VkCommandBuffer beginFrame(uint32_t frameIndex);
+			/// Records `jobCount` secondary command buffers in parallel, then executes them in job order in the primary
+			void recordParallel(
+				uint32_t jobCount,
+				const vkpp::CommandContext::RecordFunction &record,
+				const VkCommandBufferInheritanceInfo *inheritance = nullptr
+			);
+			VkCommandBuffer endFrame();
+
+			inline vkpp::Device &getDevice() const noexcept {return m_device;}
+			inline uint32_t getThreadCount() const noexcept {return m_threadPool.getThreadCount();}
+			inline VkCommandBuffer getPrimary() const noexcept {return m_frames[m_currentFrame].primary;}
+
+
+		private:
+			VkCommandBuffer s_getSecondary(vkpp::ThreadCommands &thread);
+
+			vkpp::Device &m_device;
+			vkpp::QueueType m_queue;
+			std::vector<vkpp::FrameCommands> m_frames;
+			uint32_t m_currentFrame;
+			std::vector<VkCommandBuffer> m_secondaries;
+			vkpp::utils::ThreadPool m_threadPool;
+	};
+
+} // namespace vkpp
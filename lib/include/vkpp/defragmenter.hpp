@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	using DefragmentationHandle = uint64_t;
+
+	struct DefragmenterParameters
+	{
+		/// Bytes copied per record() at most, a single larger allocation still moves alone
+		VkDeviceSize maxBytesPerFrame {16 * 1024 * 1024};
+		/// Milliseconds record() spends choosing and recording moves at most
+		double maxTimePerFrame {0.5};
+		/// Blocks used above this ratio are left alone, they are the ones allocations move to
+		float maxBlockOccupancy {0.5f};
+	};
+
+	/// What the last record() did
+	struct DefragmentationFrame
+	{
+		uint32_t moveCount;
+		VkDeviceSize movedBytes;
+		/// Share of the allocator's reserved bytes no allocation uses, the moved resources' old copies included
+		float fragmentation;
+		double time;
+	};
+
+	/// Accumulated since the last call to Defragmenter::resetStatistics()
+	struct DefragmentationStatistics
+	{
+		uint64_t moveCount;
+		VkDeviceSize movedBytes;
+		/// record() calls that moved something
+		uint64_t passCount;
+		/// Moves abandoned, for lack of room in the pool's other blocks or for an image whose subresources aren't
+		/// all in the same layout
+		uint64_t failedMoveCount;
+	};
+
+	/// Either `buffer` or `image` is set. The create infos are what the resource is recreated with
+	struct MovableResource
+	{
+		vkpp::Buffer *buffer;
+		VkBufferUsageFlags bufferUsage;
+		vkpp::Image *image;
+		VkImageCreateInfo imageCreateInfo;
+		std::function<void()> onMoved;
+	};
+
+	/// Incremental compaction of the device's Allocator. Every record() picks the sparsest blocks whose allocations
+	/// are all registered, recreates those resources in the fullest blocks of the same pool, records the copies and
+	/// swaps the owners' vkpp::Buffer / vkpp::Image in place, until the frame's byte or time budget runs out. The
+	/// old resources are retired through the deletion queue and their emptied blocks freed by the allocator.
+	/// The copies are recorded in the frame's own graphics command buffer, ahead of its work : queue order then
+	/// keeps them after the frames still reading the old resources and before the ones using the new, where a
+	/// transfer queue would need ownership transfers and semaphores around every moved resource.
+	/// Owners repoint their views and descriptors from the onMoved callbacks, called right after the swap and
+	/// before record() returns. Registered resources must only be written by the GPU through command buffers
+	/// recorded after record(). Thread safe
+	class Defragmenter
+	{
+		public:
+			using MoveCallback = std::function<void()>;
+
+			Defragmenter(vkpp::Device &device, const vkpp::DefragmenterParameters &parameters = {});
+			~Defragmenter() = default;
+
+			/// `usage` is what the buffer was created with, it needs both transfer usages. `*buffer` must outlive the
+			/// registration
+			vkpp::DefragmentationHandle add(vkpp::Buffer *buffer, VkBufferUsageFlags usage, vkpp::Defragmenter::MoveCallback onMoved = {});
+			/// `createInfo` is what the image was created with, it needs both transfer usages and exclusive sharing.
+			/// `*image` must outlive the registration
+			vkpp::DefragmentationHandle add(vkpp::Image *image, const VkImageCreateInfo &createInfo, vkpp::Defragmenter::MoveCallback onMoved = {});
+			void remove(vkpp::DefragmentationHandle handle);
+
+			/// Records the frame's moves at the start of `commandBuffer`, to be submitted on the graphics queue
+			const vkpp::DefragmentationFrame &record(VkCommandBuffer commandBuffer);
+			void resetStatistics() noexcept;
+
+			inline const vkpp::DefragmentationFrame &getLastFrame() const noexcept {return m_lastFrame;}
+			inline const vkpp::DefragmentationStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			struct Move
+			{
+				vkpp::DefragmentationHandle handle;
+				vkpp::Buffer buffer;
+				vkpp::Image image;
+				VkImageLayout oldLayout;
+				/// What the new image is left in, its old layout unless the contents were undefined
+				VkImageLayout newLayout;
+			};
+
+			bool s_prepareBuffer(vkpp::MovableResource &resource, const vkpp::MemoryBlock *source, Move &move);
+			bool s_prepareImage(vkpp::MovableResource &resource, const vkpp::MemoryBlock *source, Move &move);
+			void s_recordCopies(VkCommandBuffer commandBuffer, const std::vector<Move> &moves);
+
+			vkpp::Device &m_device;
+			vkpp::DefragmenterParameters m_parameters;
+			std::mutex m_mutex;
+			std::unordered_map<vkpp::DefragmentationHandle, vkpp::MovableResource> m_resources;
+			vkpp::DefragmentationHandle m_nextHandle;
+			vkpp::DefragmentationFrame m_lastFrame;
+			vkpp::DefragmentationStatistics m_statistics;
+	};
+
+} // namespace vkpp
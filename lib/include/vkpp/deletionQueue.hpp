@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "scheduler.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	struct RetiredResource
+	{
+		std::function<void()> deleter;
+		/// Last frame that may use the resource
+		uint64_t frame;
+	};
+
+	struct RetiredTimelineResource
+	{
+		std::function<void()> deleter;
+		vkpp::TimelinePoint point;
+	};
+
+	/// Times are in milliseconds, accumulated since the last call to DeletionQueue::resetStatistics()
+	struct DeletionStatistics
+	{
+		uint64_t retiredCount;
+		uint64_t destroyedCount;
+		uint64_t maxPendingCount;
+		double collectTime;
+	};
+
+	/// Destroys resources once the GPU is done with them instead of waiting for the whole device. Resources are
+	/// retired with the frame being recorded, or with a scheduler point, and destroyed in bulk by collect(), which
+	/// the frame loops call from their beginFrame(). retire() may be called from any thread
+	class DeletionQueue
+	{
+		public:
+			using Deleter = std::function<void()>;
+
+			DeletionQueue(vkpp::Device &device);
+			/// Waits for the device and destroys everything still retired
+			~DeletionQueue();
+
+			void retire(vkpp::DeletionQueue::Deleter deleter);
+			void retire(vkpp::DeletionQueue::Deleter deleter, const vkpp::TimelinePoint &point);
+
+			/// Called by the frame loops once frame `frameNumber`'s slot is free again, which means that every frame
+			/// up to `frameNumber - framesInFlight` completed
+			void beginFrame(uint64_t frameNumber, uint32_t framesInFlight);
+			/// Destroys the resources the GPU is known to be done with. Never blocks on the GPU
+			void collect();
+			/// Waits for the device and destroys everything retired
+			void flush();
+			void resetStatistics() noexcept;
+
+			inline uint64_t getCurrentFrame() const noexcept {return m_currentFrame;}
+			inline const vkpp::DeletionStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			vkpp::Device &m_device;
+			std::mutex m_mutex;
+			/// Ordered by frame, as frames only go forward
+			std::deque<vkpp::RetiredResource> m_retired;
+			std::vector<vkpp::RetiredTimelineResource> m_retiredTimeline;
+			uint64_t m_currentFrame;
+			std::optional<uint64_t> m_completedFrame;
+			vkpp::DeletionStatistics m_statistics;
+	};
+
+} // namespace vkpp
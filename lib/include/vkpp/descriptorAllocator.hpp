@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp
+{
+	class Device;
+
+	/// Descriptors of a type a pool holds per set it holds
+	struct DescriptorPoolRatio
+	{
+		VkDescriptorType type;
+		float ratio;
+	};
+
+	struct DescriptorAllocatorParameters
+	{
+		std::vector<vkpp::DescriptorPoolRatio> ratios {
+			{VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+			{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+			{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f},
+			{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
+			{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+			{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+			{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+			{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
+			{VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f}
+		};
+		/// Sets of the first pool, each new pool doubles it up to `maxSetsPerPool`
+		uint32_t setsPerPool {256};
+		uint32_t maxSetsPerPool {8192};
+	};
+
+	/// Accumulated since the last call to DescriptorAllocator::resetStatistics()
+	struct DescriptorAllocatorStatistics
+	{
+		uint64_t allocatedCount;
+		/// vkResetDescriptorPool calls, one per pool a retired frame used
+		uint64_t resetCount;
+		uint64_t createdPoolCount;
+		/// Allocations that didn't fit the current pool and moved to another one
+		uint64_t overflowCount;
+	};
+
+	struct FrameDescriptorPools
+	{
+		/// The last one is the one allocated from
+		std::vector<VkDescriptorPool> pools;
+	};
+
+	/// Transient descriptor sets, valid for the frame they were allocated in only. Sets are allocated linearly from
+	/// a chain of pools per frame in flight, never freed one by one : beginFrame() resets the whole chain of the
+	/// retired frame and hands its pools back for reuse. Not thread safe, one per recording thread
+	class DescriptorAllocator
+	{
+		public:
+			DescriptorAllocator(
+				vkpp::Device &device,
+				uint32_t framesInFlight,
+				const vkpp::DescriptorAllocatorParameters &parameters = {}
+			);
+			~DescriptorAllocator();
+
+			/// The frame slot's previous submission must have retired
+			void beginFrame(uint32_t frameIndex);
+			VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+			/// One vkAllocateDescriptorSets for `count` sets
+			void allocate(const VkDescriptorSetLayout *layouts, uint32_t count, VkDescriptorSet *sets);
+			void resetStatistics() noexcept;
+
+			inline uint32_t getPoolCount() const noexcept {return m_poolCount;}
+			inline const vkpp::DescriptorAllocatorStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			VkDescriptorPool s_nextPool();
+
+			vkpp::Device &m_device;
+			vkpp::DescriptorAllocatorParameters m_parameters;
+			std::vector<vkpp::FrameDescriptorPools> m_frames;
+			uint32_t m_currentFrame;
+			/// Reset pools no frame uses
+			std::vector<VkDescriptorPool> m_freePools;
+			uint32_t m_nextPoolSize;
+			uint32_t m_poolCount;
+			vkpp::DescriptorAllocatorStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "pipelineBuilder.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	struct DescriptorBindingDescription
+	{
+		uint32_t binding;
+		VkDescriptorType type;
+		uint32_t count {1};
+		VkShaderStageFlags stages {VK_SHADER_STAGE_ALL};
+		/// Non zero flags need Vulkan 1.2 descriptor indexing
+		VkDescriptorBindingFlags flags {0};
+		/// Empty, or `count` samplers
+		std::vector<VkSampler> immutableSamplers {};
+
+		bool operator==(const vkpp::DescriptorBindingDescription &other) const noexcept = default;
+	};
+
+	struct DescriptorLayoutDescription
+	{
+		std::vector<vkpp::DescriptorBindingDescription> bindings {};
+		VkDescriptorSetLayoutCreateFlags flags {0};
+
+		uint64_t hash() const noexcept;
+		bool operator==(const vkpp::DescriptorLayoutDescription &other) const noexcept = default;
+	};
+
+	/// Accumulated since the last call to DescriptorLayoutCache::resetStatistics()
+	struct DescriptorLayoutCacheStatistics
+	{
+		uint64_t requestCount;
+		uint64_t createdCount;
+	};
+
+	/// Every descriptor set layout of the device, deduplicated by content : identical descriptions, whatever the
+	/// order of their bindings, get the same VkDescriptorSetLayout. The cache keeps ownership of the layouts.
+	/// Thread safe
+	class DescriptorLayoutCache
+	{
+		public:
+			DescriptorLayoutCache(vkpp::Device &device);
+			~DescriptorLayoutCache();
+
+			VkDescriptorSetLayout get(const vkpp::DescriptorLayoutDescription &description);
+			void resetStatistics() noexcept;
+
+			inline size_t getSize() const noexcept {return m_layouts.size();}
+			inline const vkpp::DescriptorLayoutCacheStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			VkDescriptorSetLayout s_create(const vkpp::DescriptorLayoutDescription &description);
+
+			vkpp::Device &m_device;
+			std::mutex m_mutex;
+			std::unordered_map<
+				vkpp::DescriptorLayoutDescription,
+				VkDescriptorSetLayout,
+				vkpp::DescriptionHasher<vkpp::DescriptorLayoutDescription>
+			> m_layouts;
+			vkpp::DescriptorLayoutCacheStatistics m_statistics;
+	};
+
+} // namespace vkpp
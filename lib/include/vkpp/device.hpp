@@ -4,7 +4,18 @@
 
 #include <vulkan/vulkan.h>
 
+#include "allocator.hpp"
+#include "bindlessHeap.hpp"
+#include "deletionQueue.hpp"
+#include "descriptorLayoutCache.hpp"
+#include "dispatch.hpp"
+#include "imageTracker.hpp"
+#include "memoryBudget.hpp"
 #include "physicalDevice.hpp"
+#include "pipelineCache.hpp"
+#include "residencyManager.hpp"
+#include "scheduler.hpp"
+#include "stagingRing.hpp"
 
 
 namespace vkpp
@@ -16,14 +27,54 @@ namespace vkpp
 			~Device();
 
 			inline VkDevice get() const noexcept {return m_device;}
+			inline const vkpp::DeviceDispatch &getDispatch() const noexcept {return m_dispatch;}
 			inline const std::map<vkpp::QueueType, VkQueue> &getQueues() const noexcept {return m_queues;}
+			inline VkQueue getQueue(vkpp::QueueType type) const {return m_queues.at(type);}
+			uint32_t getQueueFamily(vkpp::QueueType type) const;
+			bool isSameQueueFamily(vkpp::QueueType first, vkpp::QueueType second) const;
+			inline const vkpp::PhysicalDevice &getPhysicalDevice() const noexcept {return m_physicalDevice;}
+			inline vkpp::ImageTracker &getImageTracker() const noexcept {return *m_imageTracker;}
+			inline vkpp::Allocator &getAllocator() const noexcept {return *m_allocator;}
+			/// Whether VK_EXT_memory_budget is enabled, which also needs a Vulkan 1.1 instance
+			inline bool hasMemoryBudget() const noexcept {return m_memoryBudgetExtension;}
+			inline vkpp::MemoryBudget &getMemoryBudget() const noexcept {return *m_memoryBudget;}
+			inline vkpp::StagingRing &getStagingRing() const noexcept {return *m_stagingRing;}
+			inline vkpp::PipelineCache &getPipelineCache() const noexcept {return *m_pipelineCache;}
+			inline vkpp::DescriptorLayoutCache &getDescriptorLayoutCache() const noexcept {return *m_descriptorLayoutCache;}
+			/// Lowest of the instance's requested version and the device's own
+			inline uint32_t getApiVersion() const noexcept {return m_apiVersion;}
+			/// Timeline semaphores need Vulkan 1.2, earlier devices only get fences
+			inline bool hasScheduler() const noexcept {return m_apiVersion >= VK_API_VERSION_1_2;}
+			inline vkpp::Scheduler &getScheduler() const noexcept {return *m_scheduler;}
+			inline vkpp::DeletionQueue &getDeletionQueue() const noexcept {return *m_deletionQueue;}
+			inline vkpp::ResidencyManager &getResidencyManager() const noexcept {return *m_residencyManager;}
+			/// Descriptor indexing needs Vulkan 1.2 and a few of its optional features
+			inline bool hasBindless() const noexcept {return m_bindless;}
+			inline vkpp::BindlessHeap &getBindlessHeap() const noexcept {return *m_bindlessHeap;}
 
 		
 		private:
+			static float s_getQueuePriority(vkpp::QueueType type);
+
 			vkpp::Instance &m_instance;
 			vkpp::PhysicalDevice &m_physicalDevice;
 			VkDevice m_device;
+			vkpp::DeviceDispatch m_dispatch;
 			std::map<vkpp::QueueType, VkQueue> m_queues;
+			std::map<vkpp::QueueType, uint32_t> m_queueIndices;
+			vkpp::ImageTracker *m_imageTracker;
+			vkpp::Allocator *m_allocator;
+			vkpp::MemoryBudget *m_memoryBudget;
+			vkpp::StagingRing *m_stagingRing;
+			vkpp::PipelineCache *m_pipelineCache;
+			vkpp::DescriptorLayoutCache *m_descriptorLayoutCache;
+			vkpp::Scheduler *m_scheduler;
+			vkpp::DeletionQueue *m_deletionQueue;
+			vkpp::ResidencyManager *m_residencyManager;
+			vkpp::BindlessHeap *m_bindlessHeap;
+			uint32_t m_apiVersion;
+			bool m_bindless;
+			bool m_memoryBudgetExtension;
 	};
 
 
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+
+/// Functions loaded before any instance exists
+#define VKPP_GLOBAL_FUNCTIONS(X) \
+	X(vkCreateInstance) \
+	X(vkEnumerateInstanceExtensionProperties) \
+	X(vkEnumerateInstanceLayerProperties)
+
+#define VKPP_INSTANCE_FUNCTIONS(X) \
+	X(vkDestroyInstance) \
+	X(vkEnumeratePhysicalDevices) \
+	X(vkGetPhysicalDeviceProperties) \
+	X(vkGetPhysicalDeviceFeatures) \
+	X(vkGetPhysicalDeviceMemoryProperties) \
+	X(vkGetPhysicalDeviceQueueFamilyProperties) \
+	X(vkEnumerateDeviceExtensionProperties) \
+	X(vkCreateDevice) \
+	X(vkGetDeviceProcAddr)
+
+/// VK_KHR_surface, only loaded when the instance has a window
+#define VKPP_SURFACE_FUNCTIONS(X) \
+	X(vkDestroySurfaceKHR) \
+	X(vkGetPhysicalDeviceSurfaceSupportKHR) \
+	X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+	X(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+	X(vkGetPhysicalDeviceSurfacePresentModesKHR)
+
+/// Core since Vulkan 1.1, only loaded when the instance was created with it
+#define VKPP_INSTANCE_11_FUNCTIONS(X) \
+	X(vkGetPhysicalDeviceFeatures2) \
+	X(vkGetPhysicalDeviceProperties2) \
+	X(vkGetPhysicalDeviceMemoryProperties2)
+
+#define VKPP_DEVICE_FUNCTIONS(X) \
+	X(vkDestroyDevice) \
+	X(vkGetDeviceQueue) \
+	X(vkDeviceWaitIdle) \
+	X(vkQueueSubmit) \
+	X(vkAllocateMemory) \
+	X(vkFreeMemory) \
+	X(vkMapMemory) \
+	X(vkUnmapMemory) \
+	X(vkCreateBuffer) \
+	X(vkDestroyBuffer) \
+	X(vkCreateImage) \
+	X(vkDestroyImage) \
+	X(vkCreateImageView) \
+	X(vkDestroyImageView) \
+	X(vkGetBufferMemoryRequirements) \
+	X(vkGetImageMemoryRequirements) \
+	X(vkBindBufferMemory) \
+	X(vkBindImageMemory) \
+	X(vkCreateFence) \
+	X(vkDestroyFence) \
+	X(vkResetFences) \
+	X(vkWaitForFences) \
+	X(vkGetFenceStatus) \
+	X(vkCreateSemaphore) \
+	X(vkDestroySemaphore) \
+	X(vkCreateCommandPool) \
+	X(vkDestroyCommandPool) \
+	X(vkResetCommandPool) \
+	X(vkAllocateCommandBuffers) \
+	X(vkBeginCommandBuffer) \
+	X(vkEndCommandBuffer) \
+	X(vkCreatePipelineCache) \
+	X(vkDestroyPipelineCache) \
+	X(vkGetPipelineCacheData) \
+	X(vkMergePipelineCaches) \
+	X(vkCreateGraphicsPipelines) \
+	X(vkCreateComputePipelines) \
+	X(vkDestroyPipeline) \
+	X(vkCreateShaderModule) \
+	X(vkDestroyShaderModule) \
+	X(vkCreatePipelineLayout) \
+	X(vkDestroyPipelineLayout) \
+	X(vkCmdPipelineBarrier) \
+	X(vkCmdCopyBuffer) \
+	X(vkCmdCopyImage) \
+	X(vkCmdCopyBufferToImage) \
+	X(vkCmdCopyImageToBuffer) \
+	X(vkCmdClearColorImage) \
+	X(vkCmdExecuteCommands) \
+	X(vkCmdSetViewport) \
+	X(vkCmdSetScissor) \
+	X(vkCreateQueryPool) \
+	X(vkDestroyQueryPool) \
+	X(vkGetQueryPoolResults) \
+	X(vkCmdResetQueryPool) \
+	X(vkCmdWriteTimestamp) \
+	X(vkCreateDescriptorSetLayout) \
+	X(vkDestroyDescriptorSetLayout) \
+	X(vkCreateDescriptorPool) \
+	X(vkDestroyDescriptorPool) \
+	X(vkResetDescriptorPool) \
+	X(vkAllocateDescriptorSets) \
+	X(vkFreeDescriptorSets) \
+	X(vkUpdateDescriptorSets) \
+	X(vkCmdBindDescriptorSets)
+
+/// VK_KHR_swapchain, only loaded when the device was created with it
+#define VKPP_SWAPCHAIN_FUNCTIONS(X) \
+	X(vkQueuePresentKHR) \
+	X(vkCreateSwapchainKHR) \
+	X(vkDestroySwapchainKHR) \
+	X(vkGetSwapchainImagesKHR) \
+	X(vkAcquireNextImageKHR)
+
+/// Core since Vulkan 1.2, only loaded when the device was created with it
+#define VKPP_DEVICE_12_FUNCTIONS(X) \
+	X(vkGetSemaphoreCounterValue) \
+	X(vkWaitSemaphores)
+
+#define VKPP_DECLARE_FUNCTION(name) PFN_##name name {nullptr};
+
+
+namespace vkpp
+{
+	/// Global and instance level functions, fetched through vkGetInstanceProcAddr. Calls through them skip the
+	/// loader's exported trampolines
+	struct InstanceDispatch
+	{
+		PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr {nullptr};
+		VKPP_GLOBAL_FUNCTIONS(VKPP_DECLARE_FUNCTION)
+		VKPP_INSTANCE_FUNCTIONS(VKPP_DECLARE_FUNCTION)
+		VKPP_SURFACE_FUNCTIONS(VKPP_DECLARE_FUNCTION)
+		VKPP_INSTANCE_11_FUNCTIONS(VKPP_DECLARE_FUNCTION)
+
+		/// Resolves vkGetInstanceProcAddr, from libvulkan loaded at runtime when built with VKPP_DYNAMIC_VULKAN,
+		/// and the global functions
+		void loadGlobal();
+		/// `apiVersion` is the version the instance was created for, functions above it are left null, as are the
+		/// surface ones without `surface`
+		void loadInstance(VkInstance instance, uint32_t apiVersion, bool surface);
+	};
+
+	/// Device level functions, fetched through vkGetDeviceProcAddr so that they call straight into the driver
+	struct DeviceDispatch
+	{
+		VKPP_DEVICE_FUNCTIONS(VKPP_DECLARE_FUNCTION)
+		VKPP_SWAPCHAIN_FUNCTIONS(VKPP_DECLARE_FUNCTION)
+		VKPP_DEVICE_12_FUNCTIONS(VKPP_DECLARE_FUNCTION)
+
+		/// `apiVersion` is the version the device was created for, functions above it are left null, as are the
+		/// swap chain ones without `swapchain`
+		void load(const vkpp::InstanceDispatch &instanceDispatch, VkDevice device, uint32_t apiVersion, bool swapchain);
+	};
+
+} // namespace vkpp
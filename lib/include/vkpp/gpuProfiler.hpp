@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "queueType.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	constexpr uint32_t PROFILER_INVALID_SCOPE {UINT32_MAX};
+
+	struct GpuScope
+	{
+		std::string name;
+		uint32_t depth;
+		uint32_t beginQuery;
+		uint32_t endQuery;
+	};
+
+	/// Times are in milliseconds, `start` being relative to the first timestamp the profiler read back
+	struct GpuTiming
+	{
+		std::string name;
+		uint64_t frame;
+		uint32_t depth;
+		double start;
+		double duration;
+	};
+
+	struct ProfilerFrame
+	{
+		VkQueryPool pool;
+		uint64_t number;
+		uint32_t queryCount;
+		std::vector<vkpp::GpuScope> scopes;
+	};
+
+
+	/// Timestamp queries with one pool per frame in flight. Results are only read back once the frame slot is
+	/// reused, when its previous submission is known to be retired, so reading never stalls. Every call is a
+	/// no-op when the queue family can't write timestamps. Not thread safe : scopes must be recorded in the
+	/// command buffer given to beginFrame() or one submitted with it
+	class GpuProfiler
+	{
+		public:
+			GpuProfiler(
+				vkpp::Device &device,
+				uint32_t framesInFlight,
+				uint32_t maxScopes = 256,
+				vkpp::QueueType queue = vkpp::QueueType::graphics,
+				uint32_t historyFrames = 1000
+			);
+			~GpuProfiler();
+
+			/// Reads back the results of the slot's previous frame, then resets its queries in `commandBuffer`
+			void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber);
+			uint32_t beginScope(
+				VkCommandBuffer commandBuffer,
+				const std::string &name,
+				VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+			);
+			void endScope(
+				VkCommandBuffer commandBuffer,
+				uint32_t scope,
+				VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+			);
+
+			/// Writes the timings of the history as a Chrome trace event file (chrome://tracing, Perfetto)
+			void exportChromeTrace(const std::filesystem::path &path) const;
+			void clearHistory() noexcept;
+
+			inline bool isEnabled() const noexcept {return m_enabled;}
+			/// Timings of the most recent frame read back
+			inline const std::vector<vkpp::GpuTiming> &getLastResults() const noexcept {return m_lastResults;}
+			/// Timings of the last `historyFrames` frames read back, oldest first
+			inline const std::deque<vkpp::GpuTiming> &getHistory() const noexcept {return m_history;}
+
+
+		private:
+			void s_readBack(vkpp::ProfilerFrame &frame);
+
+			vkpp::Device &m_device;
+			bool m_enabled;
+			uint32_t m_maxScopes;
+			uint32_t m_historyFrames;
+			double m_timestampPeriod;
+			uint64_t m_timestampMask;
+			std::vector<vkpp::ProfilerFrame> m_frames;
+			uint32_t m_currentFrame;
+			uint32_t m_depth;
+			std::vector<uint64_t> m_queryResults;
+			uint64_t m_origin;
+			/// Ticks from the first timestamp read back to m_origin
+			uint64_t m_originTicks;
+			bool m_hasOrigin;
+			std::vector<vkpp::GpuTiming> m_lastResults;
+			std::deque<vkpp::GpuTiming> m_history;
+			/// Timings each frame of the history holds, to drop the oldest frame as a whole
+			std::deque<size_t> m_historySizes;
+	};
+
+
+	/// Times the commands recorded in `commandBuffer` during its lifetime
+	class ScopedMarker
+	{
+		public:
+			ScopedMarker(vkpp::GpuProfiler &profiler, VkCommandBuffer commandBuffer, const std::string &name);
+			~ScopedMarker();
+
+			ScopedMarker(const vkpp::ScopedMarker &) = delete;
+			vkpp::ScopedMarker &operator=(const vkpp::ScopedMarker &) = delete;
+
+		private:
+			vkpp::GpuProfiler &m_profiler;
+			VkCommandBuffer m_commandBuffer;
+			uint32_t m_scope;
+	};
+
+} // namespace vkpp
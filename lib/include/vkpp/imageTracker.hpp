@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "resourceAccess.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+	class ImageTracker;
+
+	struct ImageRange
+	{
+		uint32_t baseMipLevel {0};
+		uint32_t mipLevelCount {VK_REMAINING_MIP_LEVELS};
+		uint32_t baseArrayLayer {0};
+		uint32_t arrayLayerCount {VK_REMAINING_ARRAY_LAYERS};
+	};
+
+	/// Subresources are stored layer major : subresource (mip, layer) is at layer * mipLevels + mip
+	struct TrackedImage
+	{
+		VkImageAspectFlags aspect;
+		uint32_t mipLevels;
+		uint32_t arrayLayers;
+		std::vector<vkpp::AccessState> states;
+	};
+
+	struct LocalSubresource
+	{
+		bool used;
+		/// What the command buffer expects the subresource to be in, resolved against the global state at submit
+		vkpp::AccessRequest firstUse;
+		vkpp::AccessState state;
+	};
+
+	struct LocalImage
+	{
+		VkImageAspectFlags aspect;
+		uint32_t mipLevels;
+		uint32_t arrayLayers;
+		std::vector<vkpp::LocalSubresource> subresources;
+	};
+
+	/// Barriers emitted, and those the tracking found redundant, accumulated until resetStatistics()
+	struct ImageTrackerStatistics
+	{
+		uint64_t barrierCount;
+		uint64_t skippedCount;
+		uint64_t pipelineBarrierCount;
+	};
+
+	/// State of one command buffer's images. Only the first use of a subresource can't be decided while recording,
+	/// as earlier command buffers may still be recorded on other threads : it is left to ImageTracker::resolve(), and
+	/// every later use gets its barrier from the local state. One per command buffer and thread
+	class LocalImageTracker
+	{
+		public:
+			LocalImageTracker(vkpp::ImageTracker &tracker);
+
+			/// Queues the barriers the use needs, recorded by the next flush()
+			void use(VkImage image, vkpp::ResourceUsage usage, bool write, const vkpp::ImageRange &range = {});
+			void use(VkImage image, const vkpp::AccessRequest &request, const vkpp::ImageRange &range = {});
+			/// Records every queued barrier in a single vkCmdPipelineBarrier
+			void flush(VkCommandBuffer commandBuffer);
+			/// Forgets everything, for the command buffer's next recording
+			void reset();
+
+			inline const std::unordered_map<VkImage, vkpp::LocalImage> &getImages() const noexcept {return m_images;}
+			inline const vkpp::ImageTrackerStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			vkpp::ImageTracker &m_tracker;
+			std::unordered_map<VkImage, vkpp::LocalImage> m_images;
+			std::vector<VkImageMemoryBarrier> m_barriers;
+			VkPipelineStageFlags m_srcStages;
+			VkPipelineStageFlags m_dstStages;
+			vkpp::ImageTrackerStatistics m_statistics;
+	};
+
+	/// Global state of every image of the device, per subresource. Allocator images and swap chain images register
+	/// themselves. Thread safe
+	class ImageTracker
+	{
+		public:
+			ImageTracker(vkpp::Device &device);
+
+			void add(VkImage image, VkFormat format, uint32_t mipLevels, uint32_t arrayLayers, VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+			void remove(VkImage image);
+
+			/// Records in `commandBuffer` the barriers bringing the images from their global state to what `local`
+			/// expected at its first uses, then moves the global state to where `local` left it. `commandBuffer` must
+			/// be submitted right before `local`'s, and command buffers resolved in submission order. Returns the
+			/// number of barriers recorded, the fix-up command buffer can be skipped when it is 0
+			uint32_t resolve(const vkpp::LocalImageTracker &local, VkCommandBuffer commandBuffer);
+			/// A swap chain image handed back by the presentation engine is only safe to use after the stages its
+			/// acquire semaphore is waited at
+			void acquire(VkImage image, VkPipelineStageFlags waitStages);
+			vkpp::AccessState getState(VkImage image, uint32_t mipLevel = 0, uint32_t arrayLayer = 0);
+			vkpp::LocalImage makeLocal(VkImage image);
+			void resetStatistics() noexcept;
+
+			inline vkpp::Device &getDevice() const noexcept {return m_device;}
+			inline const vkpp::ImageTrackerStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			vkpp::Device &m_device;
+			std::mutex m_mutex;
+			std::unordered_map<VkImage, vkpp::TrackedImage> m_images;
+			vkpp::ImageTrackerStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -7,6 +7,8 @@
 #include <vulkan/vulkan.h>
 
 #include "device.hpp"
+#include "dispatch.hpp"
+#include "offscreenTargets.hpp"
 #include "physicalDevice.hpp"
 #include "swapChain.hpp"
 #include "utils/version.hpp"
@@ -24,6 +26,7 @@ namespace vkpp
 
 	struct InstanceParameter
 	{
+		/// nullptr runs headless : no surface nor swap chain, frames are rendered to Instance::getOffscreenTargets()
 		SDL_Window *window;
 		std::string appName;
 		std::string engineName {""};
@@ -32,6 +35,34 @@ namespace vkpp
 		vkpp::VulkanVersion vulkanVersion {vkpp::VulkanVersion::v10};
 		std::vector<const char *> instanceExtensions {};
 		std::vector<const char *> deviceExtensions {};
+		/// Queries the physical devices on a thread each, which shortens startup on multi GPU machines
+		bool parallelDeviceQueries {true};
+		uint32_t framesInFlight {2};
+		VkDeviceSize stagingRingSize {16 * 1024 * 1024};
+		/// Empty keeps the pipeline cache in memory only
+		std::string pipelineCachePath {""};
+		VkExtent2D offscreenExtent {1920, 1080};
+		VkFormat offscreenFormat {VK_FORMAT_R8G8B8A8_UNORM};
+		/// Lets OffscreenTargets::endFrame() read frames back to host memory, see vkpp::Readback
+		bool offscreenReadback {true};
+		/// Sizes of Device::getBindlessHeap(), when the device supports descriptor indexing
+		vkpp::BindlessHeapParameters bindlessHeap {};
+		/// Eviction policy of Device::getResidencyManager()
+		vkpp::ResidencyParameters residency {};
+	};
+
+
+	/// Milliseconds each step of Instance's construction took
+	struct StartupTimings
+	{
+		double extensionCheck;
+		double instanceCreation;
+		double surfaceCreation;
+		double physicalDeviceSelection;
+		double deviceCreation;
+		/// Swap chain, or offscreen targets when headless
+		double presentationSetup;
+		double total;
 	};
 
 
@@ -42,16 +73,24 @@ namespace vkpp
 			~Instance();
 
 			inline VkInstance get() const noexcept {return m_instance;}
+			inline const vkpp::InstanceDispatch &getDispatch() const noexcept {return m_dispatch;}
 			inline VkSurfaceKHR getSurface() const noexcept {return m_surface;}
 			inline const vkpp::InstanceParameter &getParameters() const noexcept {return m_parameter;}
 			inline const vkpp::PhysicalDevice &getPhysicalDevice() const noexcept {return *m_physicalDevice;}
+			inline vkpp::PhysicalDevice &getPhysicalDevice() noexcept {return *m_physicalDevice;}
 			inline const vkpp::Device &getDevice() const noexcept {return *m_device;}
+			inline vkpp::Device &getDevice() noexcept {return *m_device;}
+			inline vkpp::SwapChain &getSwapChain() noexcept {return *m_swapChain;}
+			inline vkpp::OffscreenTargets &getOffscreenTargets() noexcept {return *m_offscreenTargets;}
+			inline bool isHeadless() const noexcept {return m_parameter.window == nullptr;}
+			inline const vkpp::StartupTimings &getStartupTimings() const noexcept {return m_startupTimings;}
 
 		private:
-			static std::vector<const char *> s_checkExtensions(const vkpp::InstanceParameter &parameter);
-			static bool s_checkValidationLayers(const std::vector<const char*> &layers);
+			static std::vector<const char *> s_checkExtensions(const vkpp::InstanceDispatch &dispatch, const vkpp::InstanceParameter &parameter);
+			static bool s_checkValidationLayers(const vkpp::InstanceDispatch &dispatch, const std::vector<const char*> &layers);
 
 			static void s_createInstance(
+				const vkpp::InstanceDispatch &dispatch,
 				VkInstance &instance,
 				const vkpp::InstanceParameter &parameter,
 				const std::vector<const char *> &extensions,
@@ -60,11 +99,14 @@ namespace vkpp
 			);
 
 			const vkpp::InstanceParameter &m_parameter;
+			vkpp::InstanceDispatch m_dispatch;
 			VkInstance m_instance;
 			VkSurfaceKHR m_surface;
 			vkpp::PhysicalDevice *m_physicalDevice;
 			vkpp::Device *m_device;
 			vkpp::SwapChain *m_swapChain;
+			vkpp::OffscreenTargets *m_offscreenTargets;
+			vkpp::StartupTimings m_startupTimings;
 	};
 
 } // namespace vkpp
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp
+{
+	class Device;
+
+	struct HeapBudget
+	{
+		VkDeviceSize size;
+		/// What the process may use before the OS starts paging the heap out
+		VkDeviceSize budget;
+		VkDeviceSize usage;
+		VkMemoryHeapFlags flags;
+	};
+
+	/// Accumulated since the last call to MemoryBudget::resetStatistics()
+	struct MemoryBudgetStatistics
+	{
+		uint64_t updateCount;
+		/// Updates that found at least one heap over its budget
+		uint64_t overBudgetCount;
+		/// Highest usage over budget ratio any heap reached
+		float peakUsageRatio;
+	};
+
+	/// Per heap memory usage and budget, refreshed once per frame by update(). Backed by VK_EXT_memory_budget when
+	/// the device has it, which accounts for every allocation of the process and for what the OS grants it. Without
+	/// it, the usage is what the device's Allocator holds and the budget a fixed share of the heap. Not thread safe
+	class MemoryBudget
+	{
+		public:
+			/// Share of a heap considered usable when the driver doesn't report a budget
+			static constexpr float FALLBACK_BUDGET_RATIO {0.8f};
+
+			MemoryBudget(vkpp::Device &device);
+			~MemoryBudget() = default;
+
+			void update();
+			void resetStatistics() noexcept;
+
+			/// Usage over budget, above 1 once the heap is overcommitted
+			float getUsageRatio(uint32_t heap) const noexcept;
+
+			inline uint32_t getHeapCount() const noexcept {return m_heapCount;}
+			inline const vkpp::HeapBudget &getHeap(uint32_t heap) const noexcept {return m_heaps[heap];}
+			/// Whether the figures come from VK_EXT_memory_budget
+			inline bool isDriverReported() const noexcept {return m_driverReported;}
+			inline const vkpp::MemoryBudgetStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			vkpp::Device &m_device;
+			bool m_driverReported;
+			uint32_t m_heapCount;
+			std::array<vkpp::HeapBudget, VK_MAX_MEMORY_HEAPS> m_heaps;
+			vkpp::MemoryBudgetStatistics m_statistics;
+	};
+
+} // namespace vkpp
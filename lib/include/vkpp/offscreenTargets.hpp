@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+#include "readback.hpp"
+#include "swapChain.hpp"
+
+
+namespace vkpp
+{
+	class Instance;
+
+	/// Headless replacement of the swap chain : a ring of color targets, one per frame in flight, with the same
+	/// beginFrame() / endFrame() loop. Frames must leave their image in FrameContext::finalLayout
+	class OffscreenTargets
+	{
+		public:
+			OffscreenTargets(vkpp::Instance &instance);
+			~OffscreenTargets();
+
+			/// Waits until the frame slot is free again
+			const vkpp::FrameContext &beginFrame();
+			/// Submits `commandBuffers` on the graphics queue. With a `readback` callback and readback enabled, the
+			/// frame is then copied to host memory and handed to the callback, see vkpp::Readback
+			void endFrame(const std::vector<VkCommandBuffer> &commandBuffers = {}, vkpp::Readback::Callback readback = {});
+			void resetStatistics() noexcept;
+
+			inline VkExtent2D getExtent() const noexcept {return m_extent;}
+			inline VkFormat getFormat() const noexcept {return m_format;}
+			/// nullptr when InstanceParameter::offscreenReadback is false
+			inline vkpp::Readback *getReadback() const noexcept {return m_readback;}
+			inline uint32_t getFramesInFlight() const noexcept {return static_cast<uint32_t> (m_frames.size());}
+			inline uint64_t getFrameNumber() const noexcept {return m_frameNumber;}
+			inline const vkpp::FrameContext &getCurrentFrame() const noexcept {return m_frames[m_currentFrame];}
+			inline const vkpp::FrameStatistics &getStatistics() const noexcept {return m_statistics;}
+
+
+		private:
+			vkpp::Instance &m_instance;
+			VkExtent2D m_extent;
+			VkFormat m_format;
+			std::vector<vkpp::Image> m_images;
+			std::vector<vkpp::FrameContext> m_frames;
+			vkpp::Readback *m_readback;
+			uint32_t m_currentFrame;
+			uint64_t m_frameNumber;
+			VkFence m_lastSubmitted;
+			std::chrono::steady_clock::time_point m_lastBeginFrame;
+			vkpp::FrameStatistics m_statistics;
+	};
+
+} // namespace vkpp
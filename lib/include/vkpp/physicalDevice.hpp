@@ -2,6 +2,9 @@
 
 #include <map>
 #include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
@@ -16,6 +19,8 @@ namespace vkpp
 	{
 		std::optional<uint32_t> index;
 		std::optional<uint32_t> count;
+		/// 0 when the family can't write timestamps
+		uint32_t timestampValidBits {0};
 	};
 
 	class QueueFamilyIndices
@@ -29,7 +34,8 @@ namespace vkpp
 
 			const vkpp::QueueInfos &get(vkpp::QueueType type) const;
 			const vkpp::QueueFamilyIndices::Map &get() const noexcept;
-			bool hasEverything() const noexcept;
+			/// Headless devices don't need a present queue
+			bool hasEverything(bool presentRequired = true) const noexcept;
 
 		private:
 			vkpp::QueueFamilyIndices::Map m_queues;
@@ -42,25 +48,58 @@ namespace vkpp
 		std::vector<VkPresentModeKHR> presentModes;
 	};
 
+	/// Everything selecting and creating a device needs, queried once per physical device
+	struct DeviceSnapshot
+	{
+		VkPhysicalDevice device;
+		VkPhysicalDeviceProperties properties;
+		VkPhysicalDeviceFeatures features;
+		/// Zeroed when the instance or the device is older than Vulkan 1.2
+		VkPhysicalDeviceVulkan12Features features12;
+		VkPhysicalDeviceVulkan12Properties properties12;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		std::unordered_set<std::string> extensions;
+		vkpp::QueueFamilyIndices queues;
+		/// Empty for headless instances
+		vkpp::SwapChainInfos swapChainInfos;
+		/// Milliseconds spent querying it
+		double queryTime;
+	};
+
 	class PhysicalDevice
 	{
 		public:
 			PhysicalDevice(vkpp::Instance &instance);
 			~PhysicalDevice();
 
+			/// Surface capabilities change with the window, so they must be queried again before a swap chain rebuild
+			void refreshSurfaceCapabilities();
+
 			inline VkPhysicalDevice get() const noexcept {return m_device;}
 			inline vkpp::Instance &getInstance() noexcept {return m_instance;}
+			inline const vkpp::Instance &getInstance() const noexcept {return m_instance;}
 			inline const vkpp::QueueFamilyIndices &getQueues() const noexcept {return m_queues;}
 			inline const vkpp::SwapChainInfos &getSwapChainInfos() const noexcept {return m_swapChainInfos;}
 			inline const VkPhysicalDeviceProperties &getProperties() const noexcept {return m_properties;}
 			inline const VkPhysicalDeviceFeatures &getFeatures() const noexcept {return m_features;}
+			/// Zeroed when the instance or the device is older than Vulkan 1.2
+			inline const VkPhysicalDeviceVulkan12Features &getFeatures12() const noexcept {return m_features12;}
+			inline const VkPhysicalDeviceVulkan12Properties &getProperties12() const noexcept {return m_properties12;}
+			inline const VkPhysicalDeviceMemoryProperties &getMemoryProperties() const noexcept {return m_memoryProperties;}
 			inline const std::vector<const char *> &getExtensions() const noexcept {return m_extensions;}
+			inline bool isExtensionSupported(const std::string &extension) const {return m_supportedExtensions.contains(extension);}
+			/// Milliseconds spent enumerating and querying every physical device, and picking one
+			inline double getSelectionTime() const noexcept {return m_selectionTime;}
+			/// Whether a device local memory type is host visible over more than the legacy 256 MiB window, which
+			/// makes host written data worth placing in VRAM
+			bool hasResizableBar() const noexcept;
 
 		private:
-			int s_scoreGPU(VkPhysicalDevice device, vkpp::Instance &instance, const std::vector<const char *> &extensions);
-			vkpp::QueueFamilyIndices s_getQueueFamiliesIndices(VkPhysicalDevice device);
-			vkpp::SwapChainInfos s_getSwapChainInfos(VkPhysicalDevice device, VkSurfaceKHR surface);
-			bool s_isValidGPU(VkPhysicalDevice device, vkpp::Instance &instance, const std::vector<const char *> &extensions);
+			vkpp::DeviceSnapshot s_takeSnapshot(VkPhysicalDevice device) const;
+			int s_scoreGPU(const vkpp::DeviceSnapshot &snapshot) const;
+			vkpp::QueueFamilyIndices s_getQueueFamiliesIndices(VkPhysicalDevice device) const;
+			vkpp::SwapChainInfos s_getSwapChainInfos(VkPhysicalDevice device, VkSurfaceKHR surface) const;
+			bool s_isValidGPU(const vkpp::DeviceSnapshot &snapshot) const;
 
 			vkpp::Instance &m_instance;
 			VkPhysicalDevice m_device;
@@ -68,7 +107,12 @@ namespace vkpp
 			vkpp::SwapChainInfos m_swapChainInfos;
 			VkPhysicalDeviceProperties m_properties;
 			VkPhysicalDeviceFeatures m_features;
+			VkPhysicalDeviceVulkan12Features m_features12;
+			VkPhysicalDeviceVulkan12Properties m_properties12;
+			VkPhysicalDeviceMemoryProperties m_memoryProperties;
 			std::vector<const char *> m_extensions;
+			std::unordered_set<std::string> m_supportedExtensions;
+			double m_selectionTime;
 	};
 
 } // namespace vkpp
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "utils/threadPool.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	/// Bucket i counts compilations of [2^(i-1), 2^i) ms, bucket 0 those under a millisecond
+	constexpr uint32_t PIPELINE_COMPILE_HISTOGRAM_BUCKETS {16};
+
+	struct ShaderStageDescription
+	{
+		VkShaderStageFlagBits stage;
+		VkShaderModule module;
+		std::string entryPoint {"main"};
+
+		bool operator==(const vkpp::ShaderStageDescription &other) const noexcept = default;
+	};
+
+	/// Owns every state a graphics pipeline is created from, so that requests can be queued, hashed and compared
+	struct GraphicsPipelineDescription
+	{
+		std::vector<vkpp::ShaderStageDescription> stages {};
+		std::vector<VkVertexInputBindingDescription> vertexBindings {};
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes {};
+		VkPrimitiveTopology topology {VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
+		VkPolygonMode polygonMode {VK_POLYGON_MODE_FILL};
+		VkCullModeFlags cullMode {VK_CULL_MODE_BACK_BIT};
+		VkFrontFace frontFace {VK_FRONT_FACE_COUNTER_CLOCKWISE};
+		VkSampleCountFlagBits samples {VK_SAMPLE_COUNT_1_BIT};
+		bool depthTest {false};
+		bool depthWrite {false};
+		VkCompareOp depthCompare {VK_COMPARE_OP_LESS_OR_EQUAL};
+		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments {};
+		std::vector<VkDynamicState> dynamicStates {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+		VkPipelineLayout layout {VK_NULL_HANDLE};
+		VkRenderPass renderPass {VK_NULL_HANDLE};
+		uint32_t subpass {0};
+
+		uint64_t hash() const noexcept;
+		bool operator==(const vkpp::GraphicsPipelineDescription &other) const noexcept;
+	};
+
+	struct ComputePipelineDescription
+	{
+		vkpp::ShaderStageDescription stage {VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE};
+		VkPipelineLayout layout {VK_NULL_HANDLE};
+
+		uint64_t hash() const noexcept;
+		bool operator==(const vkpp::ComputePipelineDescription &other) const noexcept = default;
+	};
+
+	template <class T>
+	struct DescriptionHasher
+	{
+		inline size_t operator()(const T &description) const noexcept {return static_cast<size_t> (description.hash());}
+	};
+
+
+	struct PipelineBuilderStatistics
+	{
+		uint64_t requestCount {0};
+		uint64_t deduplicatedCount {0};
+		uint64_t compiledCount {0};
+		uint64_t failedCount {0};
+		double compileTime {0.0};
+		std::array<uint64_t, vkpp::PIPELINE_COMPILE_HISTOGRAM_BUCKETS> histogram {};
+	};
+
+
+	/// Shared handle on a pipeline being compiled. Never blocks unless get() is called before isReady()
+	class PipelineHandle
+	{
+		public:
+			PipelineHandle() = default;
+			PipelineHandle(std::shared_future<VkPipeline> future);
+
+			bool isReady() const;
+			/// Blocks until compiled, rethrows the compilation error if any
+			VkPipeline get() const;
+			/// VK_NULL_HANDLE while compiling
+			VkPipeline tryGet() const;
+
+			inline bool isValid() const noexcept {return m_future.valid();}
+
+		private:
+			std::shared_future<VkPipeline> m_future;
+	};
+
+
+	/// Compiles pipelines on a work-stealing pool. Identical descriptions share a single compilation, and the
+	/// builder keeps ownership of every pipeline it created. Each worker compiles into its own pipeline cache,
+	/// merged into the device one by mergeCaches() and on destruction
+	class PipelineBuilder
+	{
+		public:
+			PipelineBuilder(vkpp::Device &device, uint32_t threadCount = std::thread::hardware_concurrency());
+			~PipelineBuilder();
+
+			vkpp::PipelineHandle build(const vkpp::GraphicsPipelineDescription &description);
+			vkpp::PipelineHandle build(const vkpp::ComputePipelineDescription &description);
+			/// Waits for every queued compilation, then folds the worker caches into the device cache. build() blocks
+			/// meanwhile
+			void mergeCaches();
+
+			vkpp::PipelineBuilderStatistics getStatistics() const;
+
+
+		private:
+			VkPipeline s_compile(uint32_t worker, const vkpp::GraphicsPipelineDescription &description);
+			VkPipeline s_compile(uint32_t worker, const vkpp::ComputePipelineDescription &description);
+			void s_record(double milliseconds, bool failed);
+
+			template <class T>
+			vkpp::PipelineHandle s_build(
+				std::unordered_map<T, std::shared_future<VkPipeline>, vkpp::DescriptionHasher<T>> &pipelines,
+				const T &description
+			);
+
+			vkpp::Device &m_device;
+			vkpp::utils::ThreadPool m_threadPool;
+			std::vector<VkPipelineCache> m_workerCaches;
+			std::unordered_map<
+				vkpp::GraphicsPipelineDescription,
+				std::shared_future<VkPipeline>,
+				vkpp::DescriptionHasher<vkpp::GraphicsPipelineDescription>
+			> m_graphicsPipelines;
+			std::unordered_map<
+				vkpp::ComputePipelineDescription,
+				std::shared_future<VkPipeline>,
+				vkpp::DescriptionHasher<vkpp::ComputePipelineDescription>
+			> m_computePipelines;
+			mutable std::mutex m_mutex;
+			/// Compilations submitted and not yet finished with their worker cache
+			uint32_t m_compilingCount;
+			std::condition_variable m_compiled;
+			vkpp::PipelineBuilderStatistics m_statistics;
+	};
+
+} // namespace vkpp
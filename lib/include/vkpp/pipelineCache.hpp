@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp
+{
+	class Device;
+
+	constexpr uint32_t PIPELINE_CACHE_FILE_MAGIC {0x43505056}; // "VPPC"
+	constexpr uint32_t PIPELINE_CACHE_FILE_VERSION {1};
+
+	/// Prefixed to the driver blob on disk. The driver's own header lacks the driver version, which is the
+	/// usual reason a cache goes stale
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+
+	/// VkPipelineCache persisted to a file. An empty path keeps the cache in memory only
+	class PipelineCache
+	{
+		public:
+			PipelineCache(vkpp::Device &device, const std::filesystem::path &path);
+			~PipelineCache();
+
+			/// Writes the cache next to its path then renames it over, so that a crash never leaves a torn file
+			void save();
+			/// Empty cache for a worker thread to compile into without contending on the main one
+			VkPipelineCache createWorkerCache();
+			/// Merges the worker caches into the main one and destroys them
+			void merge(const std::vector<VkPipelineCache> &workerCaches);
+
+			inline VkPipelineCache get() const noexcept {return m_cache;}
+			/// Whether a valid cache file was loaded at creation
+			inline bool isWarm() const noexcept {return m_warm;}
+			inline size_t getLoadedSize() const noexcept {return m_loadedSize;}
+
+
+		private:
+			std::vector<char> s_load();
+			bool s_isValid(const vkpp::PipelineCacheFileHeader &header) const;
+
+			vkpp::Device &m_device;
+			std::filesystem::path m_path;
+			VkPipelineCache m_cache;
+			bool m_warm;
+			size_t m_loadedSize;
+			std::mutex m_mutex;
+	};
+
+} // namespace vkpp
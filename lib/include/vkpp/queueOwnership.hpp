@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "queueType.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	/// Describes a resource moving from a queue to another. `src*` is the last use on the source queue and `dst*`
+	/// the first use on the destination one. The release and the acquire must be separated by a semaphore
+	struct QueueOwnershipTransfer
+	{
+		vkpp::QueueType source;
+		vkpp::QueueType destination;
+		VkPipelineStageFlags srcStage;
+		VkAccessFlags srcAccess;
+		VkPipelineStageFlags dstStage;
+		VkAccessFlags dstAccess;
+	};
+
+	void releaseBufferOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkBuffer buffer,
+		const vkpp::QueueOwnershipTransfer &transfer,
+		VkDeviceSize offset = 0,
+		VkDeviceSize size = VK_WHOLE_SIZE
+	);
+
+	void acquireBufferOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkBuffer buffer,
+		const vkpp::QueueOwnershipTransfer &transfer,
+		VkDeviceSize offset = 0,
+		VkDeviceSize size = VK_WHOLE_SIZE
+	);
+
+	void releaseImageOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkImage image,
+		const VkImageSubresourceRange &range,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		const vkpp::QueueOwnershipTransfer &transfer
+	);
+
+	void acquireImageOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkImage image,
+		const VkImageSubresourceRange &range,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		const vkpp::QueueOwnershipTransfer &transfer
+	);
+
+} // namespace vkpp
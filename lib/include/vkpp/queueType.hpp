@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 
 
 namespace vkpp
@@ -7,9 +8,11 @@ namespace vkpp
 	enum class QueueType
 	{
 		graphics,
-		present
+		present,
+		transfer,
+		compute
 	};
 
-	inline uint32_t QUEUE_TYPE_AMOUNT {2};
+	inline uint32_t QUEUE_TYPE_AMOUNT {4};
 
 } // namespace vkpp
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+#include "queueType.hpp"
+#include "utils/threadPool.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	/// `data` points straight into the mapped readback buffer and is only valid during the callback
+	struct ReadbackResult
+	{
+		uint64_t id;
+		uint64_t frame;
+		const void *data;
+		VkDeviceSize size;
+		VkExtent2D extent;
+		VkFormat format;
+		/// Milliseconds between the request and the copy being seen complete
+		double latency;
+	};
+
+	/// Times are in milliseconds
+	struct ReadbackStatistics
+	{
+		uint64_t requestCount {0};
+		uint64_t completedCount {0};
+		uint64_t droppedCount {0};
+		uint64_t readBytes {0};
+		double totalLatency {0.0};
+		double maxLatency {0.0};
+		/// Time between the first request and the last completion, for sustained frames per second
+		double activeTime {0.0};
+	};
+
+	enum class ReadbackSlotState
+	{
+		free,
+		copying,
+		delivering
+	};
+
+	struct ReadbackSlot
+	{
+		vkpp::Buffer buffer {};
+		VkCommandPool pool {VK_NULL_HANDLE};
+		VkCommandBuffer commandBuffer {VK_NULL_HANDLE};
+		VkFence fence {VK_NULL_HANDLE};
+		std::atomic<vkpp::ReadbackSlotState> state {vkpp::ReadbackSlotState::free};
+		vkpp::ReadbackResult result {};
+		std::function<void(const vkpp::ReadbackResult&)> callback {};
+		std::chrono::steady_clock::time_point requestTime {};
+	};
+
+
+	/// Copies images into a pool of persistently mapped host-cached buffers and hands the mapped memory to a
+	/// callback run on a worker thread, so that neither the copy nor the callback ever block the caller. The
+	/// copy is submitted on `queue` after everything submitted there before, the image must be left in
+	/// TRANSFER_SRC_OPTIMAL by that work. Requests made while every buffer is busy are dropped
+	class Readback
+	{
+		public:
+			using Callback = std::function<void(const vkpp::ReadbackResult&)>;
+
+			Readback(
+				vkpp::Device &device,
+				uint32_t slotCount = 4,
+				uint32_t workerCount = 1,
+				vkpp::QueueType queue = vkpp::QueueType::graphics
+			);
+			~Readback();
+
+			/// Returns the request id, or 0 when it was dropped
+			uint64_t request(VkImage image, VkExtent2D extent, VkFormat format, uint64_t frame, vkpp::Readback::Callback callback);
+			/// Hands completed copies to their callback. Never blocks
+			void poll();
+			/// Blocks until every request was delivered
+			void flush();
+			void resetStatistics();
+
+			vkpp::ReadbackStatistics getStatistics() const;
+
+			/// Callback writing RGBA8 / BGRA8 frames as RGBA PAM files named `<prefix><frame>.pam`, straight from the mapped
+			/// memory. Throws on any other format
+			static vkpp::Readback::Callback writeToFile(const std::filesystem::path &prefix);
+			static VkDeviceSize getTexelSize(VkFormat format);
+
+
+		private:
+			void s_record(vkpp::ReadbackSlot &slot, VkImage image, VkExtent2D extent);
+			void s_prepareSlot(vkpp::ReadbackSlot &slot, VkDeviceSize size);
+
+			vkpp::Device &m_device;
+			vkpp::QueueType m_queue;
+			std::vector<vkpp::ReadbackSlot> m_slots;
+			uint64_t m_nextRequest;
+			std::chrono::steady_clock::time_point m_firstRequest;
+			mutable std::mutex m_mutex;
+			vkpp::ReadbackStatistics m_statistics;
+			vkpp::utils::ThreadPool m_workers;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+#include "resourceAccess.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+	class RenderGraph;
+
+	using RenderGraphResource = uint32_t;
+
+	enum class BarrierMode
+	{
+		/// Only the hazards between passes, merged into one vkCmdPipelineBarrier per pass
+		merged,
+		/// A full barrier per resource access, as a reference for the merged mode
+		naive
+	};
+
+	struct RenderGraphImageDescription
+	{
+		VkFormat format;
+		VkExtent3D extent;
+		uint32_t mipLevels {1};
+		uint32_t arrayLayers {1};
+	};
+
+	struct RenderGraphBufferDescription
+	{
+		VkDeviceSize size;
+	};
+
+	struct RenderGraphAccess
+	{
+		vkpp::RenderGraphResource resource;
+		vkpp::ResourceUsage usage;
+		bool write;
+	};
+
+	struct RenderGraphResourceDeclaration
+	{
+		std::string name;
+		bool image;
+		bool imported;
+		bool output;
+		vkpp::RenderGraphImageDescription imageDescription;
+		vkpp::RenderGraphBufferDescription bufferDescription;
+		/// Imported resources only, transient ones start undefined and end however their last pass left them
+		VkImageLayout initialLayout;
+		VkImageLayout finalLayout;
+		VkImage importedImage;
+		VkBuffer importedBuffer;
+	};
+
+	class RenderGraphPassBuilder
+	{
+		public:
+			void read(vkpp::RenderGraphResource resource, vkpp::ResourceUsage usage);
+			void write(vkpp::RenderGraphResource resource, vkpp::ResourceUsage usage);
+			/// Keeps the pass even when nothing reads what it writes
+			void setSideEffects() noexcept;
+
+		private:
+			friend class vkpp::RenderGraph;
+
+			RenderGraphPassBuilder(vkpp::RenderGraph &graph, uint32_t pass);
+
+			vkpp::RenderGraph &m_graph;
+			uint32_t m_pass;
+	};
+
+	struct RenderGraphPass
+	{
+		using Execute = std::function<void(VkCommandBuffer, const vkpp::RenderGraph&)>;
+
+		std::string name;
+		std::vector<vkpp::RenderGraphAccess> accesses;
+		bool sideEffects;
+		vkpp::RenderGraphPass::Execute execute;
+	};
+
+	/// Barriers recorded in one vkCmdPipelineBarrier, ranges of CompiledRenderGraph's barrier arrays
+	struct BarrierBatch
+	{
+		VkPipelineStageFlags srcStages;
+		VkPipelineStageFlags dstStages;
+		uint32_t firstMemoryBarrier;
+		uint32_t memoryBarrierCount;
+		uint32_t firstImageBarrier;
+		uint32_t imageBarrierCount;
+	};
+
+	struct CompiledRenderPass
+	{
+		uint32_t pass;
+		/// Barriers recorded before the pass, a single one in the merged mode
+		uint32_t firstBatch;
+		uint32_t batchCount;
+	};
+
+	struct TransientMemory
+	{
+		vkpp::Allocation allocation;
+		VkMemoryRequirements requirements;
+		bool linear;
+	};
+
+	struct CompiledRenderGraph
+	{
+		/// What the graph was compiled from, compared on hash hits
+		std::vector<uint32_t> topology;
+		/// Frame of the device's deletion queue that last executed the graph
+		uint64_t lastUsedFrame;
+		std::vector<vkpp::CompiledRenderPass> passes;
+		std::vector<vkpp::BarrierBatch> batches;
+		/// Recorded after the last pass, to leave the imported images in their final layout
+		uint32_t firstFinalBatch;
+		uint32_t finalBatchCount;
+		std::vector<VkMemoryBarrier> memoryBarriers;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		/// Resource of each image barrier, to patch the imported images in before executing
+		std::vector<vkpp::RenderGraphResource> imageBarrierResources;
+		/// Indexed by resource, VK_NULL_HANDLE for the imported ones and the transient ones no kept pass uses
+		std::vector<VkImage> images;
+		std::vector<VkBuffer> buffers;
+		std::vector<vkpp::TransientMemory> memories;
+		VkDeviceSize transientBytes;
+		VkDeviceSize allocatedBytes;
+		uint32_t culledPassCount;
+	};
+
+	/// Per execute(), except the compile and cache counters which accumulate until resetStatistics()
+	struct RenderGraphStatistics
+	{
+		uint32_t passCount;
+		uint32_t culledPassCount;
+		uint32_t pipelineBarrierCount;
+		uint32_t memoryBarrierCount;
+		uint32_t imageBarrierCount;
+		/// Transient memory the resources would need without aliasing, and what they actually got
+		VkDeviceSize transientBytes;
+		VkDeviceSize allocatedBytes;
+		uint64_t compileCount;
+		uint64_t cacheHitCount;
+	};
+
+	/// Passes declare the resources they read and write, and compile() derives the barriers between them, culls the
+	/// passes nothing uses, and packs the transient resources whose lifetimes don't overlap onto the same memory.
+	/// Compilations are cached by topology : redeclaring the same graph every frame, or keeping it declared and only
+	/// swapping its imported images with setImported(), executes without recompiling nor allocating. Compilations
+	/// no execute() used for `maxUnusedFrames` frames, like the ones of a swap chain's previous extent, are dropped
+	/// along with their transient resources. Passes run in declaration order
+	class RenderGraph
+	{
+		public:
+			RenderGraph(vkpp::Device &device, vkpp::BarrierMode mode = vkpp::BarrierMode::merged, uint32_t maxUnusedFrames = 8);
+			~RenderGraph();
+
+			/// Clears the declaration, compiled graphs stay cached
+			void reset();
+
+			vkpp::RenderGraphResource createImage(const std::string &name, const vkpp::RenderGraphImageDescription &description);
+			vkpp::RenderGraphResource createBuffer(const std::string &name, const vkpp::RenderGraphBufferDescription &description);
+			vkpp::RenderGraphResource importImage(
+				const std::string &name,
+				VkImage image,
+				const vkpp::RenderGraphImageDescription &description,
+				VkImageLayout initialLayout,
+				VkImageLayout finalLayout
+			);
+			vkpp::RenderGraphResource importBuffer(const std::string &name, VkBuffer buffer, VkDeviceSize size);
+			/// Swaps the handle of an imported resource, e.g. for the frame's swap chain image, without recompiling
+			void setImported(vkpp::RenderGraphResource resource, VkImage image);
+			void setImported(vkpp::RenderGraphResource resource, VkBuffer buffer);
+			/// Keeps the passes writing `resource`, imported resources always are
+			void setOutput(vkpp::RenderGraphResource resource);
+
+			void addPass(
+				const std::string &name,
+				const std::function<void(vkpp::RenderGraphPassBuilder&)> &setup,
+				vkpp::RenderGraphPass::Execute execute
+			);
+
+			/// Only compiles when the topology isn't cached yet
+			void compile();
+			/// Compiles if needed, then records the passes and their barriers
+			void execute(VkCommandBuffer commandBuffer);
+			/// Transient resources are destroyed through the device's deletion queue
+			void clearCache();
+			void resetStatistics() noexcept;
+
+			VkImage getImage(vkpp::RenderGraphResource resource) const;
+			VkBuffer getBuffer(vkpp::RenderGraphResource resource) const;
+			inline vkpp::BarrierMode getMode() const noexcept {return m_mode;}
+			inline const vkpp::RenderGraphStatistics &getStatistics() const noexcept {return m_statistics;}
+
+
+		private:
+			friend class vkpp::RenderGraphPassBuilder;
+
+			/// Handles and names are left out, so that a graph redeclared every frame around new images hits the cache
+			std::vector<uint32_t> s_getTopology() const;
+			void s_evictUnused();
+			void s_compile(vkpp::CompiledRenderGraph &compiled);
+			std::vector<bool> s_cull() const;
+			/// Returns, for every transient resource, the one using its memory right before it
+			std::vector<vkpp::RenderGraphResource> s_allocateTransients(vkpp::CompiledRenderGraph &compiled, const std::vector<bool> &kept);
+			void s_computeBarriers(
+				vkpp::CompiledRenderGraph &compiled,
+				const std::vector<bool> &kept,
+				const std::vector<vkpp::RenderGraphResource> &aliasPredecessors
+			) const;
+			void s_destroyTransients(vkpp::CompiledRenderGraph &compiled);
+
+			vkpp::Device &m_device;
+			vkpp::BarrierMode m_mode;
+			uint32_t m_maxUnusedFrames;
+			std::vector<vkpp::RenderGraphResourceDeclaration> m_resources;
+			std::vector<vkpp::RenderGraphPass> m_passes;
+			std::unordered_map<uint64_t, vkpp::CompiledRenderGraph> m_cache;
+			vkpp::CompiledRenderGraph *m_compiled;
+			bool m_dirty;
+			vkpp::RenderGraphStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	using ResidencyHandle = uint64_t;
+
+	struct ResidencyParameters
+	{
+		/// Usage over budget ratio of a heap above which its least recently used resources get evicted
+		float evictionThreshold {0.9f};
+		/// Ratio evictions bring the heap back to, lower than the threshold so that it doesn't evict every frame
+		float evictionTarget {0.8f};
+		/// Frames a resource must have gone unused before it may be evicted
+		uint32_t minimumIdleFrames {4};
+	};
+
+	/// Accumulated since the last call to ResidencyManager::resetStatistics()
+	struct ResidencyStatistics
+	{
+		uint64_t evictedCount;
+		VkDeviceSize evictedBytes;
+		/// Frames that crossed the threshold of at least one heap
+		uint64_t pressureFrameCount;
+		/// Frames that stayed above the target of a heap for lack of idle resources to evict
+		uint64_t starvedFrameCount;
+	};
+
+	struct ResidentResource
+	{
+		vkpp::ResidencyHandle handle;
+		VkDeviceSize size;
+		uint64_t lastUsedFrame;
+		std::function<void()> evictor;
+	};
+
+	struct PendingEviction
+	{
+		uint64_t frame;
+		uint32_t heap;
+		VkDeviceSize size;
+	};
+
+	/// LRU eviction of streamable resources, driven by the device's MemoryBudget. Resources are registered with an
+	/// evictor, which frees or demotes them, and touched by the frames that use them. beginFrame(), called by the
+	/// frame loops, evicts the least recently used idle resources of the heaps above the threshold until they are
+	/// back to the target. Evictors run once their resource is unregistered, outside of any lock, and usually hand
+	/// the resource to the deletion queue : the bytes they free are subtracted from the reported usage until the
+	/// frames that may use the resource have retired, and from then on count as free space of the allocator's
+	/// blocks, which the driver still reports as used. add(), touch() and remove() may be called from any thread
+	class ResidencyManager
+	{
+		public:
+			using Evictor = std::function<void()>;
+
+			ResidencyManager(vkpp::Device &device, const vkpp::ResidencyParameters &parameters = {});
+			/// Drops the registered resources without evicting them
+			~ResidencyManager() = default;
+
+			vkpp::ResidencyHandle add(const vkpp::Allocation &allocation, vkpp::ResidencyManager::Evictor evictor);
+			vkpp::ResidencyHandle add(uint32_t heap, VkDeviceSize size, vkpp::ResidencyManager::Evictor evictor);
+			/// Marks the resource as used by the frame being recorded. False for unknown handles, which includes the
+			/// evicted resources : the caller reloads them
+			bool touch(vkpp::ResidencyHandle handle);
+			/// Unregisters the resource without evicting it, unknown handles are ignored as they may have been evicted
+			void remove(vkpp::ResidencyHandle handle);
+
+			/// Updates the device's memory budget then evicts. Called once frame `frameNumber`'s slot is free again
+			void beginFrame(uint64_t frameNumber, uint32_t framesInFlight);
+			void resetStatistics() noexcept;
+
+			VkDeviceSize getResidentBytes(uint32_t heap);
+
+			inline const vkpp::ResidencyParameters &getParameters() const noexcept {return m_parameters;}
+			inline const vkpp::ResidencyStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			struct Location
+			{
+				uint32_t heap;
+				std::list<vkpp::ResidentResource>::iterator resource;
+			};
+
+			vkpp::Device &m_device;
+			vkpp::ResidencyParameters m_parameters;
+			std::mutex m_mutex;
+			/// Least recently used first, one list per heap
+			std::array<std::list<vkpp::ResidentResource>, VK_MAX_MEMORY_HEAPS> m_resources;
+			std::unordered_map<vkpp::ResidencyHandle, Location> m_locations;
+			std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_residentBytes;
+			/// Evicted bytes the budget may still count, ordered by frame
+			std::deque<vkpp::PendingEviction> m_pending;
+			vkpp::ResidencyHandle m_nextHandle;
+			uint64_t m_currentFrame;
+			vkpp::ResidencyStatistics m_statistics;
+	};
+
+} // namespace vkpp
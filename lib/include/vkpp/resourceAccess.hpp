@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp
+{
+	/// How a command uses a resource, which gives the stages, accesses and image layout it needs
+	enum class ResourceUsage
+	{
+		colorAttachment,
+		depthAttachment,
+		sampled,
+		storage,
+		transferSource,
+		transferDestination,
+		uniform,
+		vertex,
+		index,
+		indirect,
+		/// Leaves a swap chain image to the presentation engine
+		present
+	};
+
+	struct UsageAccess
+	{
+		VkPipelineStageFlags stages;
+		VkAccessFlags readAccess;
+		VkAccessFlags writeAccess;
+		/// VK_IMAGE_LAYOUT_UNDEFINED for buffer only usages
+		VkImageLayout layout;
+		VkImageUsageFlags imageUsage;
+		VkBufferUsageFlags bufferUsage;
+	};
+
+	/// What a command asks of a resource, its accesses merged
+	struct AccessRequest
+	{
+		VkPipelineStageFlags stages;
+		VkAccessFlags readAccess;
+		VkAccessFlags writeAccess;
+		VkImageLayout layout;
+	};
+
+	/// What the barriers issued so far guarantee about a resource
+	struct AccessState
+	{
+		VkPipelineStageFlags writeStages;
+		VkAccessFlags writeAccess;
+		VkPipelineStageFlags readStages;
+		/// Stages and accesses the last write was already made visible to
+		VkPipelineStageFlags visibleStages;
+		VkAccessFlags visibleAccess;
+		VkImageLayout layout;
+	};
+
+	struct AccessBarrier
+	{
+		VkPipelineStageFlags srcStages;
+		VkAccessFlags srcAccess;
+		VkPipelineStageFlags dstStages;
+		VkAccessFlags dstAccess;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+	};
+
+	vkpp::UsageAccess getUsageAccess(vkpp::ResourceUsage usage);
+	vkpp::AccessRequest getAccessRequest(vkpp::ResourceUsage usage, bool write);
+	/// Returns true and fills `barrier` when `request` has to wait on what `state` describes, then moves `state` past
+	/// the request. Reads after reads, and reads of a write already made visible to them, need no barrier
+	bool transitionAccess(vkpp::AccessState &state, const vkpp::AccessRequest &request, bool image, vkpp::AccessBarrier &barrier);
+	/// State right after a barrier brought a resource to `request`, whatever it was in before
+	vkpp::AccessState getStateAfter(const vkpp::AccessRequest &request, bool image);
+	VkImageAspectFlags getImageAspect(VkFormat format);
+
+} // namespace vkpp
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "queueType.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	/// A value of a queue's timeline, reached once everything submitted on that queue up to it completed
+	struct TimelinePoint
+	{
+		vkpp::QueueType queue;
+		uint64_t value;
+	};
+
+	struct TimelineWait
+	{
+		vkpp::TimelinePoint point;
+		VkPipelineStageFlags stage;
+	};
+
+	struct ScheduledSubmit
+	{
+		std::vector<VkCommandBuffer> commandBuffers {};
+		std::vector<vkpp::TimelineWait> waits {};
+		/// Binary semaphores, for the swap chain which can't use timelines
+		std::vector<VkSemaphore> waitSemaphores {};
+		std::vector<VkPipelineStageFlags> waitStages {};
+		std::vector<VkSemaphore> signalSemaphores {};
+	};
+
+	/// Times are in milliseconds, accumulated since the last call to Scheduler::resetStatistics()
+	struct SchedulerStatistics
+	{
+		uint64_t submitCount;
+		/// vkQueueSubmit calls, every one carrying all the submits pending on its queue
+		uint64_t batchCount;
+		/// Waits dropped because their point was already known to be reached, or implied by a higher one
+		uint64_t skippedWaitCount;
+		uint64_t hostWaitCount;
+		double hostWaitTime;
+	};
+
+	struct Timeline
+	{
+		VkSemaphore semaphore;
+		/// Last value handed out by Scheduler::submit()
+		uint64_t lastValue;
+		/// Last value given to vkQueueSubmit
+		uint64_t submittedValue;
+		/// Last value the GPU was seen reaching
+		uint64_t completedValue;
+		std::vector<vkpp::ScheduledSubmit> pending;
+		bool flushing;
+	};
+
+	/// Gives every queue a timeline semaphore signaled by each of its submits with a monotonic value. Submits are
+	/// queued until flushed, then sent in one vkQueueSubmit per queue, and can wait on other queues' points instead
+	/// of binary semaphores. Requires Vulkan 1.2, see Device::hasScheduler(). Not thread safe, like the queues
+	class Scheduler
+	{
+		public:
+			Scheduler(vkpp::Device &device);
+			~Scheduler();
+
+			/// Queues `submit` on `queue` and returns the point it signals, which can be waited on right away
+			vkpp::TimelinePoint submit(vkpp::QueueType queue, vkpp::ScheduledSubmit submit);
+			/// Sends everything pending, queues being flushed after those they wait on
+			void flush();
+			/// `fence` is signaled with the batch, for the frame loops which pace themselves on fences
+			void flush(vkpp::QueueType queue, VkFence fence = VK_NULL_HANDLE);
+
+			/// Never blocks
+			bool isComplete(const vkpp::TimelinePoint &point);
+			/// Flushes the points' queues when needed. Returns false on timeout
+			bool wait(const vkpp::TimelinePoint &point, uint64_t timeout = std::numeric_limits<uint64_t>::max());
+			bool wait(const std::vector<vkpp::TimelinePoint> &points, bool waitAll = true, uint64_t timeout = std::numeric_limits<uint64_t>::max());
+			/// Flushes and waits for every queue's last point
+			void waitIdle();
+
+			uint64_t getCompletedValue(vkpp::QueueType queue);
+			void resetStatistics() noexcept;
+
+			inline VkSemaphore getSemaphore(vkpp::QueueType queue) const {return m_timelines.at(queue).semaphore;}
+			inline uint64_t getLastValue(vkpp::QueueType queue) const {return m_timelines.at(queue).lastValue;}
+			inline const vkpp::SchedulerStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			vkpp::Timeline &s_getTimeline(vkpp::QueueType queue);
+
+			vkpp::Device &m_device;
+			std::map<vkpp::QueueType, vkpp::Timeline> m_timelines;
+			vkpp::SchedulerStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp
+{
+	constexpr uint32_t SHADER_REFLECTION_FILE_MAGIC {0x52505056}; // "VPPR"
+	constexpr uint32_t SHADER_REFLECTION_FILE_VERSION {2};
+
+	/// Prefixed to a serialized reflection. `codeHash` ties it to the SPIR-V it was parsed from
+	struct ShaderReflectionFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t codeHash;
+		uint32_t stage;
+		uint32_t entryPointSize;
+		uint32_t bindingCount;
+		uint32_t pushConstantCount;
+		uint32_t vertexInputCount;
+		uint32_t reserved;
+	};
+
+	struct ReflectedBinding
+	{
+		uint32_t set;
+		uint32_t binding;
+		VkDescriptorType type;
+		/// 0 for a runtime sized array
+		uint32_t count;
+	};
+
+	struct ReflectedVertexInput
+	{
+		uint32_t location;
+		/// VK_FORMAT_UNDEFINED for the types a single vertex attribute can't hold, 64 bits and matrices
+		VkFormat format;
+	};
+
+	/// What a shader module's entry point expects from its pipeline layout and vertex input state
+	struct ShaderReflection
+	{
+		VkShaderStageFlagBits stage;
+		std::string entryPoint;
+		std::vector<vkpp::ReflectedBinding> bindings;
+		/// The push constant block's range, if the entry point has one
+		std::vector<VkPushConstantRange> pushConstants;
+		/// Vertex shaders only, builtins excluded
+		std::vector<vkpp::ReflectedVertexInput> vertexInputs;
+	};
+
+
+	/// Walks the SPIR-V once, reading only the instructions layouts depend on : entry points, decorations, types,
+	/// constants and global variables. Vertex inputs are taken from the entry point's interface only. Throws on code
+	/// that isn't SPIR-V, and on modules with several entry points, whose globals can't be told apart per stage
+	vkpp::ShaderReflection reflectSpirv(std::span<const uint32_t> code);
+
+	/// Writes next to the path then renames over, so that a crash never leaves a torn file
+	void saveShaderReflection(const std::filesystem::path &path, const vkpp::ShaderReflection &reflection, uint64_t codeHash);
+	/// Empty when the file is missing, corrupted or stale
+	std::optional<vkpp::ShaderReflection> loadShaderReflection(const std::filesystem::path &path, uint64_t codeHash);
+
+} // namespace vkpp
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "pipelineBuilder.hpp"
+#include "shaderReflection.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	struct Shader
+	{
+		VkShaderModule module;
+		/// Hash of the SPIR-V, the key modules are deduplicated by
+		uint64_t hash;
+		vkpp::ShaderReflection reflection;
+
+		inline vkpp::ShaderStageDescription getStage() const {return {reflection.stage, module, reflection.entryPoint};}
+	};
+
+	struct PipelineLayoutDescription
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts {};
+		std::vector<VkPushConstantRange> pushConstants {};
+
+		uint64_t hash() const noexcept;
+		bool operator==(const vkpp::PipelineLayoutDescription &other) const noexcept;
+	};
+
+	/// What the stages of a pipeline were reflected into. The set layouts belong to the device's
+	/// DescriptorLayoutCache, the pipeline layout to the registry
+	struct ShaderLayout
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		VkPipelineLayout pipelineLayout;
+	};
+
+	/// Accumulated since the last call to ShaderRegistry::resetStatistics()
+	struct ShaderRegistryStatistics
+	{
+		uint64_t moduleRequestCount;
+		uint64_t moduleCreatedCount;
+		/// Reflections read back from disk rather than parsed
+		uint64_t reflectionLoadCount;
+		uint64_t reflectionParseCount;
+		uint64_t layoutRequestCount;
+		uint64_t pipelineLayoutCreatedCount;
+	};
+
+	/// SPIR-V shader modules, deduplicated by content : the same code is never turned into two VkShaderModule.
+	/// Every module is reflected, and the reflection saved next to its file, so that later runs skip the parsing.
+	/// getLayout() merges the reflections of a pipeline's stages into set layouts, deduplicated by the device's
+	/// DescriptorLayoutCache, and a pipeline layout, deduplicated by the registry. The registry keeps ownership of
+	/// the modules and pipeline layouts. Thread safe
+	class ShaderRegistry
+	{
+		public:
+			ShaderRegistry(vkpp::Device &device);
+			~ShaderRegistry();
+
+			/// The reflection is read from `path` + ".reflect" when it matches the code, parsed and written there otherwise
+			const vkpp::Shader &load(const std::filesystem::path &path);
+			const vkpp::Shader &load(std::span<const uint32_t> code);
+			/// Sets no shader uses below the highest one get an empty layout
+			vkpp::ShaderLayout getLayout(std::span<const vkpp::Shader* const> shaders);
+			/// For sets whose layout is owned elsewhere, like the bindless heap's : reflection can't size runtime
+			/// arrays, nor tell which bindings are partially bound or updated after bind
+			void setExternalLayout(uint32_t set, VkDescriptorSetLayout layout);
+			void resetStatistics() noexcept;
+
+			size_t getModuleCount() const;
+			vkpp::ShaderRegistryStatistics getStatistics() const;
+
+
+		private:
+			const vkpp::Shader &s_load(std::span<const uint32_t> code, const std::filesystem::path &reflectionPath);
+			VkPipelineLayout s_getPipelineLayout(vkpp::PipelineLayoutDescription description);
+
+			vkpp::Device &m_device;
+			mutable std::mutex m_mutex;
+			std::unordered_map<uint64_t, vkpp::Shader> m_shaders;
+			std::unordered_map<uint32_t, VkDescriptorSetLayout> m_externalLayouts;
+			std::unordered_map<
+				vkpp::PipelineLayoutDescription,
+				VkPipelineLayout,
+				vkpp::DescriptionHasher<vkpp::PipelineLayoutDescription>
+			> m_pipelineLayouts;
+			vkpp::ShaderRegistryStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+#include "queueType.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	struct StagingStatistics
+	{
+		uint64_t uploadCount {0};
+		uint64_t uploadedBytes {0};
+		uint64_t flushCount {0};
+		uint64_t stallCount {0};
+	};
+
+	/// The layouts apply to the subresource range of the region only. The first copy of a range in a submission
+	/// gives the layout it is in, the last one the layout it is left in
+	struct StagingImageCopy
+	{
+		VkImageLayout oldLayout;
+		VkImageLayout finalLayout;
+		/// More copies of the range follow in a later submission : it is left in TRANSFER_DST_OPTIMAL on the ring's queue
+		bool pending;
+		VkBufferImageCopy region;
+	};
+
+	struct StagingSubmission
+	{
+		uint64_t id;
+		VkCommandPool pool;
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+		VkDeviceSize consumedBytes;
+		std::vector<VkBufferMemoryBarrier> bufferAcquires;
+		std::vector<VkImageMemoryBarrier> imageAcquires;
+	};
+
+
+	/// Persistently mapped ring buffer packing many small uploads into batched copies. Ring space is reclaimed
+	/// once the submission that consumed it completed. When the ring queue lives in another family than the
+	/// consumer queue, destinations are released by the ring and must be acquired through recordAcquires()
+	class StagingRing
+	{
+		public:
+			StagingRing(
+				vkpp::Device &device,
+				VkDeviceSize size,
+				vkpp::QueueType queue = vkpp::QueueType::transfer,
+				vkpp::QueueType consumer = vkpp::QueueType::graphics
+			);
+			~StagingRing();
+
+			void upload(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size);
+			void upload(
+				VkImage image,
+				const VkImageSubresourceLayers &subresource,
+				VkOffset3D offset,
+				VkExtent3D extent,
+				const void *data,
+				VkDeviceSize size,
+				VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED
+			);
+			/// Uploads whole mip levels, `mips[i]` holding the layers of level i one after the other, tightly packed,
+			/// `extent` being the one of level 0. Layers larger than a quarter of the ring go in bands of whole texel
+			/// block rows. A layer whose bands span several submissions stays on the ring's queue until its last band,
+			/// and is released with `finalLayout` along with it
+			void upload(
+				VkImage image,
+				VkFormat format,
+				VkExtent3D extent,
+				uint32_t arrayLayers,
+				std::span<const std::span<const std::byte>> mips,
+				VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			);
+
+			/// Records every pending copy in a single command buffer and submits it. Returns the submission id
+			uint64_t flush();
+			/// Reclaims the ring space of completed submissions and returns the last completed id
+			uint64_t poll();
+			void wait(uint64_t submission);
+			/// Records the acquire half of the ownership transfers of every completed submission
+			void recordAcquires(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+			inline uint64_t getLastSubmission() const noexcept {return m_nextSubmission - 1;}
+			inline VkDeviceSize getSize() const noexcept {return m_buffer.size;}
+			inline const vkpp::StagingStatistics &getStatistics() const noexcept {return m_statistics;}
+
+
+		private:
+			VkDeviceSize s_reserve(VkDeviceSize size, VkDeviceSize alignment);
+			uint64_t s_flush();
+			uint64_t s_poll();
+			void s_waitOldest();
+			vkpp::StagingSubmission s_getSubmission();
+
+			vkpp::Device &m_device;
+			vkpp::QueueType m_queue;
+			vkpp::QueueType m_consumer;
+			vkpp::Buffer m_buffer;
+			VkDeviceSize m_alignment;
+			VkDeviceSize m_head;
+			VkDeviceSize m_used;
+			VkDeviceSize m_pendingBytes;
+			std::map<VkBuffer, std::vector<VkBufferCopy>> m_bufferCopies;
+			std::map<VkImage, std::vector<vkpp::StagingImageCopy>> m_imageCopies;
+			std::deque<vkpp::StagingSubmission> m_inFlight;
+			std::vector<vkpp::StagingSubmission> m_freeSubmissions;
+			std::vector<VkBufferMemoryBarrier> m_bufferAcquires;
+			std::vector<VkImageMemoryBarrier> m_imageAcquires;
+			uint64_t m_nextSubmission;
+			uint64_t m_completedSubmission;
+			std::mutex m_mutex;
+			vkpp::StagingStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <vector>
 
 #include <vulkan/vulkan.h>
@@ -9,6 +11,33 @@ namespace vkpp
 {
 	class Instance;
 
+	struct FrameContext
+	{
+		uint32_t index;
+		uint64_t number;
+		uint32_t imageIndex;
+		VkImage image;
+		/// Layout the image must be left in by the frame's command buffers
+		VkImageLayout finalLayout;
+		VkSemaphore imageAvailable;
+		VkSemaphore renderFinished;
+		VkFence inFlight;
+	};
+
+	/// Times are in milliseconds, accumulated since the last call to SwapChain::resetStatistics()
+	struct FrameStatistics
+	{
+		uint64_t frameCount;
+		/// Sum of the frameCount - 1 intervals between consecutive beginFrame(), the first frame has none
+		double cpuFrameTime;
+		double fenceWaitTime;
+		/// Frames whose submission found the GPU already done with everything submitted before
+		uint64_t gpuStarvedFrames;
+		uint64_t recreateCount;
+		/// Time between the last recreation request and the first frame presented on the rebuilt swap chain
+		double lastRecreateLatency;
+	};
+
 	class SwapChain
 	{
 		public:
@@ -16,19 +45,49 @@ namespace vkpp
 			~SwapChain();
 
 			void recreate();
+			/// Schedules a rebuild at the next beginFrame(), so that a burst of resize events only rebuilds once
+			void requestRecreate() noexcept;
+
+			/// Waits until the frame slot is free again and acquires the next swap chain image
+			const vkpp::FrameContext &beginFrame();
+			/// Submits `commandBuffers` on the graphics queue, then presents the frame acquired by beginFrame()
+			void endFrame(const std::vector<VkCommandBuffer> &commandBuffers = {});
+
+			void setFramesInFlight(uint32_t framesInFlight);
+			void resetStatistics() noexcept;
 
 			inline VkSwapchainKHR get() const noexcept {return m_swapChain;}
 			inline const std::vector<VkImage> &getImages() const noexcept {return m_images;}
+			inline uint32_t getFramesInFlight() const noexcept {return static_cast<uint32_t> (m_frames.size());}
+			inline uint64_t getFrameNumber() const noexcept {return m_frameNumber;}
+			inline const vkpp::FrameContext &getCurrentFrame() const noexcept {return m_frames[m_currentFrame];}
+			inline const vkpp::FrameStatistics &getStatistics() const noexcept {return m_statistics;}
+
 
-		
 		private:
 			VkSurfaceFormatKHR s_chooseFormat(const std::vector<VkSurfaceFormatKHR> &formats);
 			VkPresentModeKHR s_choosePresentMode(const std::vector<VkPresentModeKHR> &presentModes);
 			VkExtent2D s_chooseExtent(vkpp::Instance &instance, const VkSurfaceCapabilitiesKHR &capabilities);
 
+			void s_createFrames(uint32_t framesInFlight);
+			void s_destroyFrames();
+			void s_createImageSemaphores();
+			void s_destroyImageSemaphores();
+
 			vkpp::Instance &m_instance;
 			VkSwapchainKHR m_swapChain;
 			std::vector<VkImage> m_images;
+			std::vector<vkpp::FrameContext> m_frames;
+			std::vector<VkSemaphore> m_renderFinished;
+			std::vector<VkFence> m_imagesInFlight;
+			bool m_recreateRequested;
+			bool m_measureRecreateLatency;
+			std::chrono::steady_clock::time_point m_recreateRequestTime;
+			uint32_t m_currentFrame;
+			uint64_t m_frameNumber;
+			VkFence m_lastSubmitted;
+			std::chrono::steady_clock::time_point m_lastBeginFrame;
+			vkpp::FrameStatistics m_statistics;
 	};
 
 } // namespace vkpp
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+#include "bindlessHeap.hpp"
+#include "stagingRing.hpp"
+#include "utils/threadPool.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	using StreamedTextureHandle = uint64_t;
+
+	struct TextureStreamerParameters
+	{
+		/// Mip levels this size or smaller make the tail, loaded as soon as the texture is added
+		uint32_t tailSize {64};
+		uint32_t workerCount {2};
+		/// Loads running on the workers at once
+		uint32_t maxConcurrentLoads {4};
+		/// Bytes handed to the staging ring per update() at most, a single larger texture still goes alone
+		VkDeviceSize maxUploadBytesPerFrame {32 * 1024 * 1024};
+		/// Size of the streamer's own staging ring, mips larger than a quarter of it are uploaded in bands of block rows
+		VkDeviceSize stagingSize {32 * 1024 * 1024};
+	};
+
+	/// `loader` runs on a worker thread and returns mip level `mipLevel` tightly packed, rows after rows
+	struct StreamedTextureDescription
+	{
+		VkFormat format;
+		VkExtent2D extent;
+		uint32_t mipLevels;
+		std::function<std::vector<std::byte>(uint32_t mipLevel)> loader;
+	};
+
+	struct StreamedTexture
+	{
+		vkpp::StreamedTextureDescription description;
+		vkpp::Image image;
+		VkImageView view;
+		/// BINDLESS_INVALID_INDEX until the tail is resident, a new index after every swap
+		vkpp::BindlessIndex index;
+		/// Most detailed mip level resident, `mipLevels` while nothing is
+		uint32_t residentMip;
+		/// Most detailed mip level the renderer asked for
+		uint32_t requestedMip;
+		/// Priority of the texture's entry in the queue, when `queued`
+		float priority;
+		bool queued;
+		bool loading;
+		bool removed;
+	};
+
+	struct StreamingRequest
+	{
+		float priority;
+		vkpp::StreamedTextureHandle handle;
+
+		inline bool operator<(const vkpp::StreamingRequest &other) const noexcept {return priority < other.priority;}
+	};
+
+	/// Mips [firstMip, mipLevels) of a texture, read by a worker. No mips when the loader threw
+	struct LoadedMips
+	{
+		vkpp::StreamedTextureHandle handle;
+		uint32_t firstMip;
+		std::vector<std::vector<std::byte>> mips;
+	};
+
+	/// An image the staging ring is filling, swapped in once `submission` completed
+	struct StreamingUpload
+	{
+		vkpp::StreamedTextureHandle handle;
+		uint32_t firstMip;
+		vkpp::Image image;
+		uint64_t submission;
+	};
+
+	/// Times are in milliseconds. Accumulated since the last call to TextureStreamer::resetStatistics(), but for
+	/// the resident bytes which are current
+	struct TextureStreamerStatistics
+	{
+		uint64_t loadCount;
+		uint64_t failedLoadCount;
+		VkDeviceSize loadedBytes;
+		uint64_t swapCount;
+		/// Device memory of the streamer's images, those being uploaded included and those being retired excluded
+		VkDeviceSize residentBytes;
+		VkDeviceSize peakResidentBytes;
+		double loadTime;
+		/// Longest time between a texture being added or asked for more detail and that detail being swapped in
+		double maxLatency;
+	};
+
+	/// Textures that start with their mip tail only and get their detailed mips as the renderer asks for them.
+	/// request() feeds a priority queue, update() hands the most urgent requests to worker threads loading the mips
+	/// from wherever the texture's loader reads them, uploads what they loaded through a staging ring of its own on
+	/// the transfer queue, and swaps the finished images in : the new image gets a bindless index of its own, which
+	/// the frame loops' BindlessHeap::flush() makes valid for the next frame, while the old image and index are
+	/// retired once the frames sampling them are. Renderers fetch getBindlessIndex() every frame. A new image holds every mip from the most detailed one down, all of them uploaded, as the
+	/// lower mips are at most a third of the bytes and copying them from the old image would need an ownership
+	/// transfer. When the transfer queue lives in another family, the images are only swapped in by the update()
+	/// given a graphics command buffer, which acquires them before their index is published.
+	/// Needs the device's bindless heap. add(), request() and remove() may be called from any thread
+	class TextureStreamer
+	{
+		public:
+			TextureStreamer(vkpp::Device &device, const vkpp::TextureStreamerParameters &parameters = {});
+			/// Waits for the loads and uploads in flight, the images are retired through the deletion queue
+			~TextureStreamer();
+
+			/// Queues the tail's load at the highest priority
+			vkpp::StreamedTextureHandle add(vkpp::StreamedTextureDescription description);
+			/// Asks for `mipLevel` and every smaller mip to become resident, the highest priorities loading first
+			void request(vkpp::StreamedTextureHandle handle, uint32_t mipLevel, float priority);
+			void remove(vkpp::StreamedTextureHandle handle);
+			/// Called once per frame, before recording the frame's draws. Doesn't swap the uploads that need acquiring
+			void update();
+			/// Same, but records the acquires of the swapped images into `commandBuffer`, a graphics command buffer
+			/// submitted before the next frame's
+			void update(VkCommandBuffer commandBuffer);
+			/// Blocks until every queued request is resident, for loading screens and eager loading
+			void flush();
+			void resetStatistics() noexcept;
+
+			vkpp::BindlessIndex getBindlessIndex(vkpp::StreamedTextureHandle handle);
+			uint32_t getResidentMip(vkpp::StreamedTextureHandle handle);
+
+			inline vkpp::StagingRing &getStagingRing() noexcept {return m_stagingRing;}
+			inline const vkpp::TextureStreamerStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			void s_dispatchLoads();
+			void s_upload(vkpp::LoadedMips &loaded);
+			void s_swap(vkpp::StreamingUpload &upload);
+			void s_retire(const vkpp::Image &image, VkImageView view);
+			void s_erase(vkpp::StreamedTextureHandle handle);
+			/// Acquires and swaps the completed uploads through a submission of its own, for flush()
+			void s_updateImmediate();
+
+			vkpp::Device &m_device;
+			vkpp::TextureStreamerParameters m_parameters;
+			vkpp::StagingRing m_stagingRing;
+			/// Whether the uploads change queue family, the rest is only created then
+			bool m_acquires;
+			VkCommandPool m_acquirePool;
+			VkCommandBuffer m_acquireCommandBuffer;
+			VkFence m_acquireFence;
+			std::mutex m_mutex;
+			std::unordered_map<vkpp::StreamedTextureHandle, vkpp::StreamedTexture> m_textures;
+			std::priority_queue<vkpp::StreamingRequest> m_requests;
+			std::vector<vkpp::LoadedMips> m_loaded;
+			std::vector<vkpp::StreamingUpload> m_uploads;
+			std::unordered_map<vkpp::StreamedTextureHandle, std::chrono::steady_clock::time_point> m_requestTimes;
+			vkpp::StreamedTextureHandle m_nextHandle;
+			uint32_t m_loadingCount;
+			vkpp::TextureStreamerStatistics m_statistics;
+			vkpp::utils::ThreadPool m_workers;
+	};
+
+} // namespace vkpp
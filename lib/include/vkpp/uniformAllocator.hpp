@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "allocator.hpp"
+
+
+namespace vkpp
+{
+	class Device;
+
+	/// `offset` is relative to the whole buffer, ready to be given as a dynamic offset
+	struct UniformAllocation
+	{
+		VkBuffer buffer;
+		uint32_t offset;
+		void *data;
+	};
+
+	/// Accumulated since the last call to UniformAllocator::resetStatistics(), a frame being counted when the
+	/// next one begins
+	struct UniformAllocatorStatistics
+	{
+		uint64_t allocationCount;
+		VkDeviceSize allocatedBytes;
+		/// Most bytes a single frame used, alignment included
+		VkDeviceSize peakFrameBytes;
+	};
+
+	/// Per frame constants bump allocated from a single persistently mapped buffer, split in a region per frame in
+	/// flight. Allocating is an atomic add on the frame's head, writing a memcpy : no Vulkan call happens between
+	/// beginFrame() calls, so one descriptor with a dynamic offset serves every draw of every frame. The buffer is
+	/// placed in device local memory when the device exposes it to the host through resizable BAR. allocate() and
+	/// push() may be called from any thread
+	class UniformAllocator
+	{
+		public:
+			UniformAllocator(
+				vkpp::Device &device,
+				uint32_t framesInFlight,
+				VkDeviceSize frameSize,
+				VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+			);
+			~UniformAllocator();
+
+			/// The frame slot's previous submission must have retired, its region is reused from the start
+			void beginFrame(uint32_t frameIndex);
+			/// Throws when the frame's region is full
+			vkpp::UniformAllocation allocate(VkDeviceSize size);
+			vkpp::UniformAllocation push(const void *data, VkDeviceSize size);
+			void resetStatistics() noexcept;
+
+			template <class T>
+			inline vkpp::UniformAllocation push(const T &value) {return this->push(&value, sizeof(T));}
+
+			inline VkBuffer getBuffer() const noexcept {return m_buffer.buffer;}
+			inline VkDeviceSize getAlignment() const noexcept {return m_alignment;}
+			inline VkDeviceSize getFrameSize() const noexcept {return m_frameSize;}
+			inline bool isDeviceLocal() const noexcept {return m_deviceLocal;}
+			inline const vkpp::UniformAllocatorStatistics &getStatistics() const noexcept {return m_statistics;}
+
+		private:
+			vkpp::Device &m_device;
+			VkDeviceSize m_alignment;
+			VkDeviceSize m_frameSize;
+			uint32_t m_framesInFlight;
+			vkpp::Buffer m_buffer;
+			bool m_deviceLocal;
+			VkDeviceSize m_frameOffset;
+			std::atomic<VkDeviceSize> m_head;
+			std::atomic<uint64_t> m_allocationCount;
+			vkpp::UniformAllocatorStatistics m_statistics;
+	};
+
+} // namespace vkpp
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+
+namespace vkpp::utils
+{
+	/// Texels per block of `format`, 1x1 for the uncompressed ones. Copies to a block compressed image start and
+	/// end on whole blocks, but at the image's edges
+	inline VkExtent2D getBlockExtent(VkFormat format) noexcept
+	{
+		// BC, ETC2 and EAC are all 4x4
+		if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK)
+			return {4, 4};
+
+		// ASTC comes in UNORM and SRGB pairs per extent
+		if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+		{
+			constexpr VkExtent2D ASTC_EXTENTS[] {
+				{4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8},
+				{10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12}
+			};
+
+			return ASTC_EXTENTS[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+		}
+
+		return {1, 1};
+	}
+
+} // namespace vkpp::utils
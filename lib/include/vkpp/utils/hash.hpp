@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+
+namespace vkpp::utils
+{
+	constexpr uint64_t FNV_OFFSET_BASIS {14695981039346656037ull};
+	constexpr uint64_t FNV_PRIME {1099511628211ull};
+
+	/// 64 bits FNV-1a, chainable through `seed`
+	inline uint64_t hash(const void *data, size_t size, uint64_t seed = vkpp::utils::FNV_OFFSET_BASIS) noexcept
+	{
+		const unsigned char *bytes {static_cast<const unsigned char*> (data)};
+
+		for (size_t i {0}; i < size; i++)
+		{
+			seed ^= bytes[i];
+			seed *= vkpp::utils::FNV_PRIME;
+		}
+
+		return seed;
+	}
+
+
+	template <class T>
+	inline void hashCombine(uint64_t &seed, const T &value) noexcept
+	{
+		seed ^= static_cast<uint64_t> (std::hash<T> {} (value)) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+	}
+
+} // namespace vkpp::utils
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace vkpp::utils
+{
+	struct WorkQueue
+	{
+		std::deque<std::function<void(uint32_t)>> jobs;
+		std::mutex mutex;
+	};
+
+
+	/// Work-stealing pool : every worker owns a deque it pops from the back, and steals from the front of the
+	/// others' once its own is empty. Jobs submitted from a worker land in that worker's deque
+	class ThreadPool
+	{
+		public:
+			/// Jobs receive the index of the worker running them, in [0, getThreadCount())
+			using Job = std::function<void(uint32_t)>;
+
+			ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+			~ThreadPool();
+
+			void submit(vkpp::utils::ThreadPool::Job job);
+			/// Blocks until every submitted job ran, and rethrows the first exception a job threw. Must not be
+			/// called from a job
+			void wait();
+
+			inline uint32_t getThreadCount() const noexcept {return static_cast<uint32_t> (m_threads.size());}
+			inline uint64_t getStealCount() const noexcept {return m_stealCount;}
+
+		private:
+			void s_work(uint32_t index);
+			bool s_pop(uint32_t index, vkpp::utils::ThreadPool::Job &job);
+
+			std::vector<std::thread> m_threads;
+			std::vector<std::unique_ptr<vkpp::utils::WorkQueue>> m_queues;
+			std::atomic<uint32_t> m_nextQueue;
+			std::atomic<uint64_t> m_queued;
+			std::atomic<uint64_t> m_pending;
+			std::atomic<uint64_t> m_stealCount;
+			std::mutex m_mutex;
+			std::condition_variable m_jobAvailable;
+			std::condition_variable m_idle;
+			bool m_stop;
+			std::exception_ptr m_exception;
+	};
+
+} // namespace vkpp::utils
@@ -1 +1,23 @@
-#include "instance.hpp"
\ No newline at end of file
+#include "instance.hpp"
+#include "queueOwnership.hpp"
+#include "commandContext.hpp"
+#include "pipelineBuilder.hpp"
+#include "gpuProfiler.hpp"
+#include "readback.hpp"
+#include "scheduler.hpp"
+#include "deletionQueue.hpp"
+#include "resourceAccess.hpp"
+#include "imageTracker.hpp"
+#include "renderGraph.hpp"
+#include "bindlessHeap.hpp"
+#include "descriptorLayoutCache.hpp"
+#include "descriptorAllocator.hpp"
+#include "uniformAllocator.hpp"
+#include "memoryBudget.hpp"
+#include "residencyManager.hpp"
+#include "defragmenter.hpp"
+#include "textureStreamer.hpp"
+#include "assetPack.hpp"
+#include "assetPackWriter.hpp"
+#include "shaderReflection.hpp"
+#include "shaderRegistry.hpp"
\ No newline at end of file
@@ -0,0 +1,520 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "allocator.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	MemoryBlock::MemoryBlock(vkpp::Device &device, uint32_t memoryType, VkDeviceSize size, bool hostVisible, bool linear) :
+		m_device {device},
+		m_memory {VK_NULL_HANDLE},
+		m_mapped {nullptr},
+		m_memoryType {memoryType},
+		m_size {size},
+		m_used {0},
+		m_linear {linear},
+		m_freeLists {},
+		m_allocatedOrders {}
+	{
+		VkMemoryAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = m_size;
+		allocateInfo.memoryTypeIndex = m_memoryType;
+
+		if (m_device.getDispatch().vkAllocateMemory(m_device.get(), &allocateInfo, nullptr, &m_memory) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't allocate a memory block of " + std::to_string(m_size) + " bytes");
+
+		if (hostVisible && m_device.getDispatch().vkMapMemory(m_device.get(), m_memory, 0, VK_WHOLE_SIZE, 0, &m_mapped) != VK_SUCCESS)
+		{
+			m_device.getDispatch().vkFreeMemory(m_device.get(), m_memory, nullptr);
+			throw std::runtime_error("VKPP : Can't map a memory block");
+		}
+
+		uint32_t maxOrder {s_getOrder(m_size)};
+		m_freeLists.resize(maxOrder + 1);
+		m_freeLists[maxOrder].insert(0);
+	}
+
+
+
+	MemoryBlock::~MemoryBlock()
+	{
+		if (m_mapped != nullptr)
+			m_device.getDispatch().vkUnmapMemory(m_device.get(), m_memory);
+
+		m_device.getDispatch().vkFreeMemory(m_device.get(), m_memory, nullptr);
+	}
+
+
+
+	std::optional<VkDeviceSize> MemoryBlock::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		// buddy nodes are aligned on their own size, so a big enough node is always well aligned
+		uint32_t order {s_getOrder(std::max(size, alignment))};
+		if (order >= m_freeLists.size())
+			return std::nullopt;
+
+		uint32_t available {order};
+		while (available < m_freeLists.size() && m_freeLists[available].empty())
+			++available;
+
+		if (available == m_freeLists.size())
+			return std::nullopt;
+
+		VkDeviceSize offset {*m_freeLists[available].begin()};
+		m_freeLists[available].erase(m_freeLists[available].begin());
+
+		while (available > order)
+		{
+			--available;
+			m_freeLists[available].insert(offset + (vkpp::MEMORY_BLOCK_MIN_NODE_SIZE << available));
+		}
+
+		m_allocatedOrders[offset] = order;
+		m_used += vkpp::MEMORY_BLOCK_MIN_NODE_SIZE << order;
+		return offset;
+	}
+
+
+
+	void MemoryBlock::free(VkDeviceSize offset)
+	{
+		auto it {m_allocatedOrders.find(offset)};
+		if (it == m_allocatedOrders.end())
+			throw std::runtime_error("VKPP : Can't free offset " + std::to_string(offset) + " that isn't allocated in this block");
+
+		uint32_t order {it->second};
+		m_allocatedOrders.erase(it);
+		m_used -= vkpp::MEMORY_BLOCK_MIN_NODE_SIZE << order;
+
+		while (order + 1 < m_freeLists.size())
+		{
+			VkDeviceSize buddy {offset ^ (vkpp::MEMORY_BLOCK_MIN_NODE_SIZE << order)};
+			auto buddyIt {m_freeLists[order].find(buddy)};
+			if (buddyIt == m_freeLists[order].end())
+				break;
+
+			m_freeLists[order].erase(buddyIt);
+			offset = std::min(offset, buddy);
+			++order;
+		}
+
+		m_freeLists[order].insert(offset);
+	}
+
+
+
+	uint32_t MemoryBlock::s_getOrder(VkDeviceSize size)
+	{
+		VkDeviceSize nodes {(size + vkpp::MEMORY_BLOCK_MIN_NODE_SIZE - 1) / vkpp::MEMORY_BLOCK_MIN_NODE_SIZE};
+		return static_cast<uint32_t> (std::bit_width(std::bit_ceil(std::max<VkDeviceSize> (nodes, 1))) - 1);
+	}
+
+
+
+	Allocator::Allocator(vkpp::Device &device, VkDeviceSize blockSize) :
+		m_device {device},
+		m_memoryProperties {device.getPhysicalDevice().getMemoryProperties()},
+		m_blockSize {std::bit_ceil(std::max(blockSize, vkpp::MEMORY_BLOCK_MIN_NODE_SIZE))},
+		m_mutex {},
+		m_pools {},
+		m_statistics {},
+		m_heapUsage {}
+	{
+		m_pools.resize(m_memoryProperties.memoryTypeCount * 2);
+	}
+
+
+
+	Allocator::~Allocator()
+	{
+		m_pools.clear();
+	}
+
+
+
+	vkpp::Allocation Allocator::allocate(
+		const VkMemoryRequirements &requirements,
+		VkMemoryPropertyFlags required,
+		VkMemoryPropertyFlags preferred,
+		bool linear
+	)
+	{
+		uint32_t memoryType {this->findMemoryType(requirements.memoryTypeBits, required, preferred)};
+		const VkMemoryType &type {m_memoryProperties.memoryTypes[memoryType]};
+		bool hostVisible {(type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0};
+
+		// never let a block take more than an eighth of its heap
+		VkDeviceSize heapSize {m_memoryProperties.memoryHeaps[type.heapIndex].size};
+		VkDeviceSize blockSize {std::min(m_blockSize, std::bit_floor(std::max<VkDeviceSize> (heapSize / 8, vkpp::MEMORY_BLOCK_MIN_NODE_SIZE)))};
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		if (requirements.size > blockSize / 2)
+			return s_allocateDedicated(requirements.size, memoryType);
+
+		auto &pool {m_pools[memoryType * 2 + (linear ? 1 : 0)]};
+		vkpp::MemoryBlock *block {nullptr};
+		std::optional<VkDeviceSize> offset {};
+
+		for (auto &it : pool)
+		{
+			offset = it->allocate(requirements.size, requirements.alignment);
+			if (!offset.has_value())
+				continue;
+
+			block = it.get();
+			break;
+		}
+
+		if (block == nullptr)
+		{
+			pool.push_back(std::make_unique<vkpp::MemoryBlock> (m_device, memoryType, blockSize, hostVisible, linear));
+			++m_statistics.deviceAllocationCount;
+			m_heapUsage[type.heapIndex] += blockSize;
+
+			block = pool.back().get();
+			offset = block->allocate(requirements.size, requirements.alignment);
+			if (!offset.has_value())
+				throw std::runtime_error("VKPP : Can't suballocate " + std::to_string(requirements.size) + " bytes in a new memory block");
+		}
+
+		++m_statistics.allocationCount;
+		m_statistics.requestedBytes += requirements.size;
+
+		vkpp::Allocation allocation {};
+		allocation.memory = block->get();
+		allocation.offset = offset.value();
+		allocation.size = requirements.size;
+		allocation.memoryType = memoryType;
+		allocation.block = block;
+		if (hostVisible)
+			allocation.mapped = static_cast<std::byte*> (block->getMapped()) + offset.value();
+
+		return allocation;
+	}
+
+
+
+	void Allocator::free(vkpp::Allocation &allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+			return;
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		--m_statistics.allocationCount;
+		m_statistics.requestedBytes -= allocation.size;
+
+		if (allocation.block == nullptr)
+		{
+			if (allocation.mapped != nullptr)
+				m_device.getDispatch().vkUnmapMemory(m_device.get(), allocation.memory);
+
+			m_device.getDispatch().vkFreeMemory(m_device.get(), allocation.memory, nullptr);
+			--m_statistics.dedicatedAllocationCount;
+			m_statistics.reservedBytes -= allocation.size;
+			m_statistics.usedBytes -= allocation.size;
+			m_heapUsage[m_memoryProperties.memoryTypes[allocation.memoryType].heapIndex] -= allocation.size;
+			allocation = {};
+			return;
+		}
+
+		vkpp::MemoryBlock *block {allocation.block};
+		block->free(allocation.offset);
+		allocation = {};
+
+		if (!block->isEmpty())
+			return;
+
+		// keep a single empty block per pool around so that alloc / free patterns don't thrash vkAllocateMemory
+		auto &pool {m_pools[block->getMemoryType() * 2 + (block->isLinear() ? 1 : 0)]};
+		uint32_t emptyBlocks {0};
+		for (auto &it : pool)
+		{
+			if (it->isEmpty())
+				++emptyBlocks;
+		}
+
+		if (emptyBlocks > 1)
+		{
+			m_heapUsage[m_memoryProperties.memoryTypes[block->getMemoryType()].heapIndex] -= block->getSize();
+			std::erase_if(pool, [block](const auto &it) {return it.get() == block;});
+		}
+	}
+
+
+
+	std::optional<vkpp::Allocation> Allocator::allocateForRelocation(
+		const VkMemoryRequirements &requirements,
+		uint32_t memoryType,
+		bool linear,
+		const vkpp::MemoryBlock *source
+	)
+	{
+		if ((requirements.memoryTypeBits & (1u << memoryType)) == 0)
+			return std::nullopt;
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		// the spare empty block would only swap places with `source`
+		std::vector<vkpp::MemoryBlock*> blocks {};
+		for (auto &block : m_pools[memoryType * 2 + (linear ? 1 : 0)])
+		{
+			if (block.get() != source && !block->isEmpty())
+				blocks.push_back(block.get());
+		}
+
+		std::sort(blocks.begin(), blocks.end(), [](const vkpp::MemoryBlock *first, const vkpp::MemoryBlock *second) {
+			return first->getUsed() > second->getUsed();
+		});
+
+		for (auto block : blocks)
+		{
+			std::optional<VkDeviceSize> offset {block->allocate(requirements.size, requirements.alignment)};
+			if (!offset.has_value())
+				continue;
+
+			++m_statistics.allocationCount;
+			m_statistics.requestedBytes += requirements.size;
+
+			vkpp::Allocation allocation {};
+			allocation.memory = block->get();
+			allocation.offset = offset.value();
+			allocation.size = requirements.size;
+			allocation.memoryType = memoryType;
+			allocation.block = block;
+			if (block->getMapped() != nullptr)
+				allocation.mapped = static_cast<std::byte*> (block->getMapped()) + offset.value();
+
+			return allocation;
+		}
+
+		return std::nullopt;
+	}
+
+
+
+	vkpp::Buffer Allocator::createBuffer(
+		VkDeviceSize size,
+		VkBufferUsageFlags usage,
+		VkMemoryPropertyFlags required,
+		VkMemoryPropertyFlags preferred
+	)
+	{
+		vkpp::Buffer buffer {};
+		buffer.size = size;
+
+		VkBufferCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		createInfo.size = size;
+		createInfo.usage = usage;
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (m_device.getDispatch().vkCreateBuffer(m_device.get(), &createInfo, nullptr, &buffer.buffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create a buffer of " + std::to_string(size) + " bytes");
+
+		VkMemoryRequirements requirements {};
+		m_device.getDispatch().vkGetBufferMemoryRequirements(m_device.get(), buffer.buffer, &requirements);
+
+		try
+		{
+			buffer.allocation = this->allocate(requirements, required, preferred, true);
+		}
+
+		catch (...)
+		{
+			m_device.getDispatch().vkDestroyBuffer(m_device.get(), buffer.buffer, nullptr);
+			throw;
+		}
+
+		if (m_device.getDispatch().vkBindBufferMemory(m_device.get(), buffer.buffer, buffer.allocation.memory, buffer.allocation.offset) != VK_SUCCESS)
+		{
+			this->destroyBuffer(buffer);
+			throw std::runtime_error("VKPP : Can't bind memory to a buffer");
+		}
+
+		return buffer;
+	}
+
+
+
+	void Allocator::destroyBuffer(vkpp::Buffer &buffer)
+	{
+		if (buffer.buffer != VK_NULL_HANDLE)
+			m_device.getDispatch().vkDestroyBuffer(m_device.get(), buffer.buffer, nullptr);
+
+		this->free(buffer.allocation);
+		buffer = {};
+	}
+
+
+
+	vkpp::Image Allocator::createImage(
+		const VkImageCreateInfo &createInfo,
+		VkMemoryPropertyFlags required,
+		VkMemoryPropertyFlags preferred
+	)
+	{
+		vkpp::Image image {};
+		image.format = createInfo.format;
+		image.extent = createInfo.extent;
+		image.mipLevels = createInfo.mipLevels;
+		image.arrayLayers = createInfo.arrayLayers;
+
+		if (m_device.getDispatch().vkCreateImage(m_device.get(), &createInfo, nullptr, &image.image) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create an image");
+
+		VkMemoryRequirements requirements {};
+		m_device.getDispatch().vkGetImageMemoryRequirements(m_device.get(), image.image, &requirements);
+
+		try
+		{
+			image.allocation = this->allocate(requirements, required, preferred, createInfo.tiling == VK_IMAGE_TILING_LINEAR);
+		}
+
+		catch (...)
+		{
+			m_device.getDispatch().vkDestroyImage(m_device.get(), image.image, nullptr);
+			throw;
+		}
+
+		if (m_device.getDispatch().vkBindImageMemory(m_device.get(), image.image, image.allocation.memory, image.allocation.offset) != VK_SUCCESS)
+		{
+			m_device.getDispatch().vkDestroyImage(m_device.get(), image.image, nullptr);
+			this->free(image.allocation);
+			throw std::runtime_error("VKPP : Can't bind memory to an image");
+		}
+
+		m_device.getImageTracker().add(image.image, image.format, image.mipLevels, image.arrayLayers, createInfo.initialLayout);
+		return image;
+	}
+
+
+
+	void Allocator::destroyImage(vkpp::Image &image)
+	{
+		if (image.image != VK_NULL_HANDLE)
+		{
+			m_device.getImageTracker().remove(image.image);
+			m_device.getDispatch().vkDestroyImage(m_device.get(), image.image, nullptr);
+		}
+
+		this->free(image.allocation);
+		image = {};
+	}
+
+
+
+	uint32_t Allocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+	{
+		for (VkMemoryPropertyFlags flags : {required | preferred, required})
+		{
+			for (uint32_t i {0}; i < m_memoryProperties.memoryTypeCount; i++)
+			{
+				if ((typeBits & (1u << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+					return i;
+			}
+		}
+
+		throw std::runtime_error("VKPP : Can't find a memory type with properties " + std::to_string(required));
+	}
+
+
+
+	vkpp::AllocatorStatistics Allocator::getStatistics()
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		vkpp::AllocatorStatistics statistics {m_statistics};
+		statistics.blockCount = 0;
+
+		for (auto &pool : m_pools)
+		{
+			for (auto &block : pool)
+			{
+				++statistics.blockCount;
+				statistics.reservedBytes += block->getSize();
+				statistics.usedBytes += block->getUsed();
+			}
+		}
+
+		return statistics;
+	}
+
+
+
+	vkpp::MemoryBlockInfo Allocator::getBlockInfo(const vkpp::MemoryBlock &block)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return {block.getSize(), block.getUsed(), block.getAllocationCount(), block.getMemoryType(), block.isLinear()};
+	}
+
+
+
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> Allocator::getHeapUsage()
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return m_heapUsage;
+	}
+
+
+
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> Allocator::getHeapFreeBytes()
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> freeBytes {};
+
+		for (const auto &pool : m_pools)
+		{
+			for (const auto &block : pool)
+				freeBytes[m_memoryProperties.memoryTypes[block->getMemoryType()].heapIndex] += block->getSize() - block->getUsed();
+		}
+
+		return freeBytes;
+	}
+
+
+
+	vkpp::Allocation Allocator::s_allocateDedicated(VkDeviceSize size, uint32_t memoryType)
+	{
+		vkpp::Allocation allocation {};
+		allocation.size = size;
+		allocation.memoryType = memoryType;
+
+		VkMemoryAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = size;
+		allocateInfo.memoryTypeIndex = memoryType;
+
+		if (m_device.getDispatch().vkAllocateMemory(m_device.get(), &allocateInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't allocate a dedicated memory of " + std::to_string(size) + " bytes");
+
+		if (m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			if (m_device.getDispatch().vkMapMemory(m_device.get(), allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mapped) != VK_SUCCESS)
+			{
+				m_device.getDispatch().vkFreeMemory(m_device.get(), allocation.memory, nullptr);
+				throw std::runtime_error("VKPP : Can't map a dedicated memory");
+			}
+		}
+
+		++m_statistics.allocationCount;
+		++m_statistics.dedicatedAllocationCount;
+		++m_statistics.deviceAllocationCount;
+		m_statistics.requestedBytes += size;
+		m_statistics.reservedBytes += size;
+		m_statistics.usedBytes += size;
+		m_heapUsage[m_memoryProperties.memoryTypes[memoryType].heapIndex] += size;
+		return allocation;
+	}
+
+
+
+} // namespace vkpp
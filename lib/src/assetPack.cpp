@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef VKPP_PLATEFORM_WINDOWS
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "assetPack.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	AssetPack::AssetPack(vkpp::Device &device, const std::filesystem::path &path) :
+		m_device {device},
+		m_data {nullptr},
+		m_size {0},
+		m_mapping {nullptr},
+		m_entries {},
+		m_names {}
+	{
+		s_map(path);
+
+		try
+		{
+			s_validate(path);
+		}
+
+		catch (...)
+		{
+			s_unmap();
+			throw;
+		}
+	}
+
+
+
+	AssetPack::~AssetPack()
+	{
+		s_unmap();
+	}
+
+
+
+	const vkpp::AssetPackEntry *AssetPack::find(std::string_view name) const
+	{
+		auto found {m_names.find(name)};
+		return found == m_names.end() ? nullptr : found->second;
+	}
+
+
+
+	std::span<const std::byte> AssetPack::getPayload(const vkpp::AssetPackEntry &entry) const
+	{
+		return {m_data + entry.offset, static_cast<size_t> (entry.size)};
+	}
+
+
+
+	std::span<const std::byte> AssetPack::getMip(const vkpp::AssetPackEntry &entry, uint32_t mipLevel) const
+	{
+		if (mipLevel >= entry.mipLevels)
+			throw std::runtime_error("VKPP : Asset " + std::string(entry.name) + " has no mip level " + std::to_string(mipLevel));
+
+		uint64_t end {mipLevel + 1 == entry.mipLevels ? entry.size : entry.mipOffsets[mipLevel + 1]};
+		return {m_data + entry.offset + entry.mipOffsets[mipLevel], static_cast<size_t> (end - entry.mipOffsets[mipLevel])};
+	}
+
+
+
+	void AssetPack::prefetch(const vkpp::AssetPackEntry &entry) const
+	{
+		#ifdef VKPP_PLATEFORM_WINDOWS
+			WIN32_MEMORY_RANGE_ENTRY range {const_cast<std::byte*> (m_data + entry.offset), static_cast<SIZE_T> (entry.size)};
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		#else
+			// payloads start on a page, as madvise() wants
+			madvise(const_cast<std::byte*> (m_data + entry.offset), static_cast<size_t> (entry.size), MADV_WILLNEED);
+		#endif
+	}
+
+
+
+	vkpp::Buffer AssetPack::loadBuffer(vkpp::StagingRing &ring, const vkpp::AssetPackEntry &entry, VkBufferUsageFlags usage)
+	{
+		if (entry.type != vkpp::AssetType::buffer)
+			throw std::runtime_error("VKPP : Can't load asset " + std::string(entry.name) + " as a buffer, it is an image");
+
+		vkpp::Buffer buffer {m_device.getAllocator().createBuffer(
+			entry.size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		)};
+
+		// in slices, so that a large payload never waits for the whole ring to drain
+		VkDeviceSize sliceSize {std::max<VkDeviceSize> (ring.getSize() / 4, 1)};
+		std::span<const std::byte> payload {getPayload(entry)};
+
+		for (VkDeviceSize offset {0}; offset < entry.size; offset += sliceSize)
+			ring.upload(buffer.buffer, offset, payload.data() + offset, std::min(sliceSize, entry.size - offset));
+
+		return buffer;
+	}
+
+
+
+	vkpp::Image AssetPack::loadImage(vkpp::StagingRing &ring, const vkpp::AssetPackEntry &entry, VkImageUsageFlags usage, VkImageLayout finalLayout)
+	{
+		if (entry.type != vkpp::AssetType::image)
+			throw std::runtime_error("VKPP : Can't load asset " + std::string(entry.name) + " as an image, it is a buffer");
+
+		VkImageCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		createInfo.imageType = entry.extent.depth > 1 ? VK_IMAGE_TYPE_3D : (entry.extent.height > 1 ? VK_IMAGE_TYPE_2D : VK_IMAGE_TYPE_1D);
+		createInfo.format = entry.format;
+		createInfo.extent = entry.extent;
+		createInfo.mipLevels = entry.mipLevels;
+		createInfo.arrayLayers = entry.arrayLayers;
+		createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		createInfo.usage = usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		vkpp::Image image {m_device.getAllocator().createImage(createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)};
+
+		std::vector<std::span<const std::byte>> mips {};
+		for (uint32_t mip {0}; mip < entry.mipLevels; mip++)
+			mips.push_back(getMip(entry, mip));
+
+		ring.upload(image.image, entry.format, entry.extent, entry.arrayLayers, mips, finalLayout);
+
+		m_device.getImageTracker().remove(image.image);
+		m_device.getImageTracker().add(image.image, image.format, image.mipLevels, image.arrayLayers, finalLayout);
+		return image;
+	}
+
+
+
+	void AssetPack::s_map(const std::filesystem::path &path)
+	{
+		#ifdef VKPP_PLATEFORM_WINDOWS
+			HANDLE file {CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+			if (file == INVALID_HANDLE_VALUE)
+				throw std::runtime_error("VKPP : Can't open asset pack " + path.string());
+
+			LARGE_INTEGER size {};
+			GetFileSizeEx(file, &size);
+			m_size = static_cast<size_t> (size.QuadPart);
+
+			// the mapping keeps the file open
+			m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (m_mapping == nullptr)
+				throw std::runtime_error("VKPP : Can't map asset pack " + path.string());
+
+			m_data = static_cast<const std::byte*> (MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (m_data == nullptr)
+			{
+				CloseHandle(m_mapping);
+				throw std::runtime_error("VKPP : Can't map asset pack " + path.string());
+			}
+		#else
+			int file {open(path.c_str(), O_RDONLY)};
+			if (file < 0)
+				throw std::runtime_error("VKPP : Can't open asset pack " + path.string());
+
+			struct stat status {};
+			if (fstat(file, &status) != 0 || status.st_size == 0)
+			{
+				close(file);
+				throw std::runtime_error("VKPP : Can't map asset pack " + path.string() + ", it is empty or unreadable");
+			}
+
+			m_size = static_cast<size_t> (status.st_size);
+
+			// the mapping keeps the file open
+			void *data {mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0)};
+			close(file);
+			if (data == MAP_FAILED)
+				throw std::runtime_error("VKPP : Can't map asset pack " + path.string());
+
+			m_data = static_cast<const std::byte*> (data);
+		#endif
+	}
+
+
+
+	void AssetPack::s_unmap() noexcept
+	{
+		if (m_data == nullptr)
+			return;
+
+		#ifdef VKPP_PLATEFORM_WINDOWS
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+		#else
+			munmap(const_cast<std::byte*> (m_data), m_size);
+		#endif
+
+		m_data = nullptr;
+		m_mapping = nullptr;
+	}
+
+
+
+	void AssetPack::s_validate(const std::filesystem::path &path)
+	{
+		vkpp::AssetPackFileHeader header {};
+		if (m_size < sizeof(header))
+			throw std::runtime_error("VKPP : Asset pack " + path.string() + " is truncated");
+
+		std::memcpy(&header, m_data, sizeof(header));
+		if (header.magic != vkpp::ASSET_PACK_FILE_MAGIC || header.version != vkpp::ASSET_PACK_FILE_VERSION)
+			throw std::runtime_error("VKPP : " + path.string() + " isn't an asset pack of version " + std::to_string(vkpp::ASSET_PACK_FILE_VERSION));
+
+		if (header.fileSize != m_size || sizeof(header) + uint64_t {header.entryCount} * sizeof(vkpp::AssetPackEntry) > m_size)
+			throw std::runtime_error("VKPP : Asset pack " + path.string() + " is truncated");
+
+		// the header keeps the entries 8 bytes aligned in a page aligned mapping
+		m_entries = {reinterpret_cast<const vkpp::AssetPackEntry*> (m_data + sizeof(header)), header.entryCount};
+		m_names.reserve(m_entries.size());
+
+		for (const auto &entry : m_entries)
+		{
+			std::string_view name {entry.name, strnlen(entry.name, vkpp::ASSET_PACK_MAX_NAME_SIZE)};
+			if (name.size() == vkpp::ASSET_PACK_MAX_NAME_SIZE || entry.offset > m_size || entry.size > m_size - entry.offset)
+				throw std::runtime_error("VKPP : Asset pack " + path.string() + " has a corrupted entry");
+
+			if (entry.type == vkpp::AssetType::image)
+			{
+				if (entry.mipLevels == 0 || entry.mipLevels > vkpp::ASSET_PACK_MAX_MIP_LEVELS || entry.arrayLayers == 0)
+					throw std::runtime_error("VKPP : Asset pack " + path.string() + " has a corrupted image " + std::string(name));
+
+				for (uint32_t mip {0}; mip < entry.mipLevels; mip++)
+				{
+					uint64_t end {mip + 1 == entry.mipLevels ? entry.size : entry.mipOffsets[mip + 1]};
+					if (entry.mipOffsets[mip] > end || end > entry.size || (end - entry.mipOffsets[mip]) % entry.arrayLayers != 0)
+						throw std::runtime_error("VKPP : Asset pack " + path.string() + " has a corrupted image " + std::string(name));
+				}
+			}
+
+			if (!m_names.try_emplace(name, &entry).second)
+				throw std::runtime_error("VKPP : Asset pack " + path.string() + " holds asset " + std::string(name) + " twice");
+		}
+	}
+
+
+
+} // namespace vkpp
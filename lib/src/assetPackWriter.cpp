@@ -0,0 +1,128 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "assetPackWriter.hpp"
+
+
+
+namespace vkpp
+{
+	void AssetPackWriter::addBuffer(std::string_view name, std::vector<std::byte> data)
+	{
+		if (data.empty())
+			throw std::runtime_error("VKPP : Can't pack buffer " + std::string(name) + ", it is empty");
+
+		PendingAsset asset {s_makeEntry(name, vkpp::AssetType::buffer), {}};
+		asset.entry.size = data.size();
+		asset.payloads.push_back(std::move(data));
+		m_assets.push_back(std::move(asset));
+	}
+
+
+
+	void AssetPackWriter::addImage(std::string_view name, VkFormat format, VkExtent3D extent, uint32_t arrayLayers, std::vector<std::vector<std::byte>> mips)
+	{
+		if (mips.empty() || mips.size() > vkpp::ASSET_PACK_MAX_MIP_LEVELS || arrayLayers == 0)
+			throw std::runtime_error("VKPP : Can't pack image " + std::string(name) + " of " + std::to_string(mips.size()) + " mip levels");
+
+		PendingAsset asset {s_makeEntry(name, vkpp::AssetType::image), {}};
+		asset.entry.format = format;
+		asset.entry.extent = extent;
+		asset.entry.mipLevels = static_cast<uint32_t> (mips.size());
+		asset.entry.arrayLayers = arrayLayers;
+
+		for (uint32_t mip {0}; mip < mips.size(); mip++)
+		{
+			if (mips[mip].empty() || mips[mip].size() % arrayLayers != 0)
+				throw std::runtime_error("VKPP : Can't pack mip " + std::to_string(mip) + " of image " + std::string(name) + ", its size isn't a whole number of layers");
+
+			asset.entry.mipOffsets[mip] = asset.entry.size;
+			asset.entry.size += mips[mip].size();
+		}
+
+		asset.payloads = std::move(mips);
+		m_assets.push_back(std::move(asset));
+	}
+
+
+
+	void AssetPackWriter::write(const std::filesystem::path &path) const
+	{
+		vkpp::AssetPackFileHeader header {};
+		header.magic = vkpp::ASSET_PACK_FILE_MAGIC;
+		header.version = vkpp::ASSET_PACK_FILE_VERSION;
+		header.entryCount = static_cast<uint32_t> (m_assets.size());
+
+		std::vector<vkpp::AssetPackEntry> entries {};
+		entries.reserve(m_assets.size());
+
+		uint64_t offset {sizeof(header) + m_assets.size() * sizeof(vkpp::AssetPackEntry)};
+		for (const auto &asset : m_assets)
+		{
+			offset = (offset + vkpp::ASSET_PACK_ALIGNMENT - 1) / vkpp::ASSET_PACK_ALIGNMENT * vkpp::ASSET_PACK_ALIGNMENT;
+			entries.push_back(asset.entry);
+			entries.back().offset = offset;
+			offset += asset.entry.size;
+		}
+
+		header.fileSize = offset;
+
+		std::filesystem::path temporary {path};
+		temporary += ".tmp";
+
+		{
+			std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+			file.write(reinterpret_cast<const char*> (&header), sizeof(header));
+			file.write(reinterpret_cast<const char*> (entries.data()), static_cast<std::streamsize> (entries.size() * sizeof(vkpp::AssetPackEntry)));
+
+			std::vector<char> padding (vkpp::ASSET_PACK_ALIGNMENT, 0);
+			uint64_t written {sizeof(header) + entries.size() * sizeof(vkpp::AssetPackEntry)};
+
+			for (size_t i {0}; i < m_assets.size(); i++)
+			{
+				file.write(padding.data(), static_cast<std::streamsize> (entries[i].offset - written));
+				for (const auto &payload : m_assets[i].payloads)
+					file.write(reinterpret_cast<const char*> (payload.data()), static_cast<std::streamsize> (payload.size()));
+
+				written = entries[i].offset + entries[i].size;
+			}
+
+			if (!file)
+				throw std::runtime_error("VKPP : Can't write asset pack to " + temporary.string());
+		}
+
+		std::error_code error {};
+		std::filesystem::rename(temporary, path, error);
+		if (error)
+			throw std::runtime_error("VKPP : Can't replace asset pack " + path.string() + " : " + error.message());
+	}
+
+
+
+	vkpp::AssetPackEntry AssetPackWriter::s_makeEntry(std::string_view name, vkpp::AssetType type) const
+	{
+		if (name.empty() || name.size() >= vkpp::ASSET_PACK_MAX_NAME_SIZE)
+			throw std::runtime_error("VKPP : Can't pack asset " + std::string(name) + ", its name must be 1 to " + std::to_string(vkpp::ASSET_PACK_MAX_NAME_SIZE - 1) + " characters");
+
+		for (const auto &asset : m_assets)
+		{
+			if (name == asset.entry.name)
+				throw std::runtime_error("VKPP : Can't pack asset " + std::string(name) + " twice");
+		}
+
+		vkpp::AssetPackEntry entry {};
+		std::memcpy(entry.name, name.data(), name.size());
+		entry.type = type;
+		entry.format = VK_FORMAT_UNDEFINED;
+		entry.mipLevels = 1;
+		entry.arrayLayers = 1;
+		return entry;
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "bindlessHeap.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	namespace
+	{
+		VkDescriptorType getDescriptorType(vkpp::BindlessType type)
+		{
+			switch (type)
+			{
+				case vkpp::BindlessType::sampledImage:
+					return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+
+				case vkpp::BindlessType::storageBuffer:
+					return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+				case vkpp::BindlessType::sampler:
+					return VK_DESCRIPTOR_TYPE_SAMPLER;
+			}
+
+			return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+
+
+		uint64_t getPendingKey(vkpp::BindlessType type, vkpp::BindlessIndex index)
+		{
+			return (static_cast<uint64_t> (type) << 32) | index;
+		}
+	}
+
+
+
+	BindlessHeap::BindlessHeap(vkpp::Device &device, const vkpp::BindlessHeapParameters &parameters) :
+		m_device {device},
+		m_layout {VK_NULL_HANDLE},
+		m_pool {VK_NULL_HANDLE},
+		m_set {VK_NULL_HANDLE},
+		m_mutex {},
+		m_slots {},
+		m_pending {},
+		m_statistics {}
+	{
+		if (!m_device.hasBindless())
+			throw std::runtime_error("VKPP : Can't create a bindless heap on a device without descriptor indexing");
+
+		const VkPhysicalDeviceVulkan12Properties &limits {m_device.getPhysicalDevice().getProperties12()};
+		m_slots[static_cast<uint32_t> (vkpp::BindlessType::sampledImage)].capacity = std::min({
+			parameters.sampledImageCount,
+			limits.maxDescriptorSetUpdateAfterBindSampledImages,
+			limits.maxPerStageDescriptorUpdateAfterBindSampledImages
+		});
+		m_slots[static_cast<uint32_t> (vkpp::BindlessType::storageBuffer)].capacity = std::min({
+			parameters.storageBufferCount,
+			limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+			limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+		});
+		m_slots[static_cast<uint32_t> (vkpp::BindlessType::sampler)].capacity = std::min({
+			parameters.samplerCount,
+			limits.maxDescriptorSetUpdateAfterBindSamplers,
+			limits.maxPerStageDescriptorUpdateAfterBindSamplers
+		});
+
+		// partially bound, as most of the arrays is never written, and updatable while bound so that a frame in
+		// flight doesn't block writing the slots it doesn't use
+		VkDescriptorBindingFlags bindingFlag {
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+			| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+			| VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+		};
+
+		vkpp::DescriptorLayoutDescription layoutDescription {};
+		layoutDescription.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		std::vector<VkDescriptorPoolSize> poolSizes {};
+
+		for (uint32_t i {0}; i < vkpp::BINDLESS_TYPE_AMOUNT; i++)
+		{
+			VkDescriptorType descriptorType {getDescriptorType(static_cast<vkpp::BindlessType> (i))};
+			layoutDescription.bindings.push_back({i, descriptorType, m_slots[i].capacity, VK_SHADER_STAGE_ALL, bindingFlag});
+
+			if (m_slots[i].capacity != 0)
+				poolSizes.push_back({descriptorType, m_slots[i].capacity});
+		}
+
+		m_layout = m_device.getDescriptorLayoutCache().get(layoutDescription);
+
+		VkDescriptorPoolCreateInfo poolCreateInfo {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolCreateInfo.maxSets = 1;
+		poolCreateInfo.poolSizeCount = static_cast<uint32_t> (poolSizes.size());
+		poolCreateInfo.pPoolSizes = poolSizes.data();
+
+		if (m_device.getDispatch().vkCreateDescriptorPool(m_device.get(), &poolCreateInfo, nullptr, &m_pool) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create the bindless descriptor pool");
+
+		VkDescriptorSetAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = m_pool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &m_layout;
+
+		if (m_device.getDispatch().vkAllocateDescriptorSets(m_device.get(), &allocateInfo, &m_set) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't allocate the bindless descriptor set");
+	}
+
+
+
+	BindlessHeap::~BindlessHeap()
+	{
+		// the retired indices point back to the heap
+		m_device.getDeletionQueue().flush();
+
+		m_device.getDispatch().vkDestroyDescriptorPool(m_device.get(), m_pool, nullptr);
+	}
+
+
+
+	vkpp::BindlessIndex BindlessHeap::addSampledImage(VkImageView view, VkImageLayout layout)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		vkpp::BindlessIndex index {s_allocate(vkpp::BindlessType::sampledImage)};
+		s_write(vkpp::BindlessType::sampledImage, index, {{VK_NULL_HANDLE, view, layout}, {}});
+		return index;
+	}
+
+
+
+	vkpp::BindlessIndex BindlessHeap::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		vkpp::BindlessIndex index {s_allocate(vkpp::BindlessType::storageBuffer)};
+		s_write(vkpp::BindlessType::storageBuffer, index, {{}, {buffer, offset, range}});
+		return index;
+	}
+
+
+
+	vkpp::BindlessIndex BindlessHeap::addSampler(VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		vkpp::BindlessIndex index {s_allocate(vkpp::BindlessType::sampler)};
+		s_write(vkpp::BindlessType::sampler, index, {{sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED}, {}});
+		return index;
+	}
+
+
+
+	void BindlessHeap::updateSampledImage(vkpp::BindlessIndex index, VkImageView view, VkImageLayout layout)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		s_write(vkpp::BindlessType::sampledImage, index, {{VK_NULL_HANDLE, view, layout}, {}});
+	}
+
+
+
+	void BindlessHeap::updateStorageBuffer(vkpp::BindlessIndex index, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		s_write(vkpp::BindlessType::storageBuffer, index, {{}, {buffer, offset, range}});
+	}
+
+
+
+	void BindlessHeap::updateSampler(vkpp::BindlessIndex index, VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		s_write(vkpp::BindlessType::sampler, index, {{sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED}, {}});
+	}
+
+
+
+	void BindlessHeap::release(vkpp::BindlessType type, vkpp::BindlessIndex index)
+	{
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			vkpp::BindlessSlots &slots {m_slots[static_cast<uint32_t> (type)]};
+			if (index >= slots.next)
+				throw std::runtime_error("VKPP : Can't release bindless index " + std::to_string(index) + ", it was never allocated");
+
+			// a second release would queue the index twice on the free list, and hand it out twice
+			if (slots.released[index])
+				throw std::runtime_error("VKPP : Can't release bindless index " + std::to_string(index) + ", it was already released");
+
+			slots.released[index] = true;
+
+			// the resource behind it may be destroyed before the next flush
+			m_pending.erase(getPendingKey(type, index));
+			++m_statistics.releasedCount;
+		}
+
+		// outside the lock, as the deletion queue may run the deleter right away on another thread
+		m_device.getDeletionQueue().retire([this, type, index] {
+			std::lock_guard<std::mutex> lock {m_mutex};
+			m_slots[static_cast<uint32_t> (type)].free.push_back(index);
+		});
+	}
+
+
+
+	void BindlessHeap::flush()
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		if (m_pending.empty())
+			return;
+
+		// reserved up front, the writes point into them
+		std::vector<VkDescriptorImageInfo> imageInfos {};
+		std::vector<VkDescriptorBufferInfo> bufferInfos {};
+		imageInfos.reserve(m_pending.size());
+		bufferInfos.reserve(m_pending.size());
+
+		std::vector<VkWriteDescriptorSet> writes {};
+
+		for (const auto &[key, descriptor] : m_pending)
+		{
+			uint32_t binding {static_cast<uint32_t> (key >> 32)};
+			vkpp::BindlessIndex index {static_cast<vkpp::BindlessIndex> (key)};
+			bool buffer {binding == static_cast<uint32_t> (vkpp::BindlessType::storageBuffer)};
+
+			if (writes.empty() || writes.back().dstBinding != binding || writes.back().dstArrayElement + writes.back().descriptorCount != index)
+			{
+				VkWriteDescriptorSet write {};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = m_set;
+				write.dstBinding = binding;
+				write.dstArrayElement = index;
+				write.descriptorCount = 0;
+				write.descriptorType = getDescriptorType(static_cast<vkpp::BindlessType> (binding));
+				write.pImageInfo = buffer ? nullptr : imageInfos.data() + imageInfos.size();
+				write.pBufferInfo = buffer ? bufferInfos.data() + bufferInfos.size() : nullptr;
+				writes.push_back(write);
+			}
+
+			++writes.back().descriptorCount;
+
+			if (buffer)
+				bufferInfos.push_back(descriptor.buffer);
+			else
+				imageInfos.push_back(descriptor.image);
+		}
+
+		m_device.getDispatch().vkUpdateDescriptorSets(m_device.get(), static_cast<uint32_t> (writes.size()), writes.data(), 0, nullptr);
+
+		m_statistics.descriptorWriteCount += m_pending.size();
+		m_statistics.writeCount += writes.size();
+		++m_statistics.flushCount;
+		m_pending.clear();
+	}
+
+
+
+	void BindlessHeap::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t set) const
+	{
+		m_device.getDispatch().vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, set, 1, &m_set, 0, nullptr);
+	}
+
+
+
+	void BindlessHeap::resetStatistics() noexcept
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_statistics = {};
+	}
+
+
+
+	vkpp::BindlessIndex BindlessHeap::s_allocate(vkpp::BindlessType type)
+	{
+		vkpp::BindlessSlots &slots {m_slots[static_cast<uint32_t> (type)]};
+		++m_statistics.allocatedCount;
+
+		if (!slots.free.empty())
+		{
+			vkpp::BindlessIndex index {slots.free.back()};
+			slots.free.pop_back();
+			slots.released[index] = false;
+			return index;
+		}
+
+		if (slots.next >= slots.capacity)
+			throw std::runtime_error("VKPP : Bindless heap is full, " + std::to_string(slots.capacity) + " descriptors of that type at most");
+
+		slots.released.push_back(false);
+		return slots.next++;
+	}
+
+
+
+	void BindlessHeap::s_write(vkpp::BindlessType type, vkpp::BindlessIndex index, const vkpp::BindlessDescriptor &descriptor)
+	{
+		if (index >= m_slots[static_cast<uint32_t> (type)].next)
+			throw std::runtime_error("VKPP : Can't write bindless index " + std::to_string(index) + ", it was never allocated");
+
+		// a slot written twice before a flush only sends its last descriptor
+		m_pending[getPendingKey(type, index)] = descriptor;
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "commandContext.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	CommandContext::CommandContext(vkpp::Device &device, vkpp::QueueType queue, uint32_t framesInFlight, uint32_t threadCount) :
+		m_device {device},
+		m_queue {queue},
+		m_frames {},
+		m_currentFrame {0},
+		m_secondaries {},
+		m_threadPool {threadCount}
+	{
+		VkCommandPoolCreateInfo poolCreateInfo {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolCreateInfo.queueFamilyIndex = m_device.getQueueFamily(m_queue);
+
+		m_frames.resize(framesInFlight);
+
+		for (auto &frame : m_frames)
+		{
+			if (m_device.getDispatch().vkCreateCommandPool(m_device.get(), &poolCreateInfo, nullptr, &frame.pool) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create a frame command pool");
+
+			VkCommandBufferAllocateInfo allocateInfo {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.commandPool = frame.pool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandBufferCount = 1;
+
+			if (m_device.getDispatch().vkAllocateCommandBuffers(m_device.get(), &allocateInfo, &frame.primary) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't allocate a frame primary command buffer");
+
+			// command pools are externally synchronized, so every worker records from its own
+			frame.threads.resize(m_threadPool.getThreadCount());
+
+			for (auto &thread : frame.threads)
+			{
+				thread.used = 0;
+				if (m_device.getDispatch().vkCreateCommandPool(m_device.get(), &poolCreateInfo, nullptr, &thread.pool) != VK_SUCCESS)
+					throw std::runtime_error("VKPP : Can't create a thread command pool");
+			}
+		}
+	}
+
+
+
+	CommandContext::~CommandContext()
+	{
+		for (auto &frame : m_frames)
+		{
+			for (auto &thread : frame.threads)
+				m_device.getDispatch().vkDestroyCommandPool(m_device.get(), thread.pool, nullptr);
+
+			m_device.getDispatch().vkDestroyCommandPool(m_device.get(), frame.pool, nullptr);
+		}
+	}
+
+
+
+	VkCommandBuffer CommandContext::beginFrame(uint32_t frameIndex)
+	{
+		if (frameIndex >= m_frames.size())
+			throw std::runtime_error("VKPP : Command context has no frame " + std::to_string(frameIndex));
+
+		m_currentFrame = frameIndex;
+		vkpp::FrameCommands &frame {m_frames[m_currentFrame]};
+
+		if (m_device.getDispatch().vkResetCommandPool(m_device.get(), frame.pool, 0) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't reset frame command pool");
+
+		for (auto &thread : frame.threads)
+		{
+			if (thread.used == 0)
+				continue;
+
+			if (m_device.getDispatch().vkResetCommandPool(m_device.get(), thread.pool, 0) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't reset thread command pool");
+
+			thread.used = 0;
+		}
+
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (m_device.getDispatch().vkBeginCommandBuffer(frame.primary, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't begin frame primary command buffer");
+
+		return frame.primary;
+	}
+
+
+
+	void CommandContext::recordParallel(
+		uint32_t jobCount,
+		const vkpp::CommandContext::RecordFunction &record,
+		const VkCommandBufferInheritanceInfo *inheritance
+	)
+	{
+		if (jobCount == 0)
+			return;
+
+		vkpp::FrameCommands &frame {m_frames[m_currentFrame]};
+		m_secondaries.assign(jobCount, VK_NULL_HANDLE);
+
+		VkCommandBufferInheritanceInfo defaultInheritance {};
+		defaultInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = inheritance != nullptr ? inheritance : &defaultInheritance;
+
+		if (inheritance != nullptr && inheritance->renderPass != VK_NULL_HANDLE)
+			beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+
+		for (uint32_t job {0}; job < jobCount; job++)
+		{
+			m_threadPool.submit([this, &frame, &record, &beginInfo, job](uint32_t threadIndex) {
+				VkCommandBuffer commandBuffer {s_getSecondary(frame.threads[threadIndex])};
+
+				if (m_device.getDispatch().vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+					throw std::runtime_error("VKPP : Can't begin secondary command buffer of job " + std::to_string(job));
+
+				record(commandBuffer, job);
+
+				if (m_device.getDispatch().vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+					throw std::runtime_error("VKPP : Can't end secondary command buffer of job " + std::to_string(job));
+
+				// every job writes its own slot, the execution order only depends on the job index
+				m_secondaries[job] = commandBuffer;
+			});
+		}
+
+		m_threadPool.wait();
+
+		m_device.getDispatch().vkCmdExecuteCommands(frame.primary, jobCount, m_secondaries.data());
+	}
+
+
+
+	VkCommandBuffer CommandContext::endFrame()
+	{
+		VkCommandBuffer primary {m_frames[m_currentFrame].primary};
+
+		if (m_device.getDispatch().vkEndCommandBuffer(primary) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't end frame primary command buffer");
+
+		return primary;
+	}
+
+
+
+	VkCommandBuffer CommandContext::s_getSecondary(vkpp::ThreadCommands &thread)
+	{
+		if (thread.used < thread.secondaries.size())
+			return thread.secondaries[thread.used++];
+
+		VkCommandBufferAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = thread.pool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocateInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkAllocateCommandBuffers(m_device.get(), &allocateInfo, &commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't allocate a secondary command buffer");
+
+		thread.secondaries.push_back(commandBuffer);
+		++thread.used;
+		return commandBuffer;
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "defragmenter.hpp"
+#include "device.hpp"
+#include "resourceAccess.hpp"
+
+
+
+namespace vkpp
+{
+	Defragmenter::Defragmenter(vkpp::Device &device, const vkpp::DefragmenterParameters &parameters) :
+		m_device {device},
+		m_parameters {parameters},
+		m_mutex {},
+		m_resources {},
+		m_nextHandle {1},
+		m_lastFrame {},
+		m_statistics {}
+	{
+
+	}
+
+
+
+	vkpp::DefragmentationHandle Defragmenter::add(vkpp::Buffer *buffer, VkBufferUsageFlags usage, vkpp::Defragmenter::MoveCallback onMoved)
+	{
+		VkBufferUsageFlags transfer {VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+		if ((usage & transfer) != transfer)
+			throw std::runtime_error("VKPP : Can't defragment a buffer without both transfer usages");
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+		vkpp::DefragmentationHandle handle {m_nextHandle++};
+		m_resources[handle] = {buffer, usage, nullptr, {}, std::move(onMoved)};
+		return handle;
+	}
+
+
+
+	vkpp::DefragmentationHandle Defragmenter::add(vkpp::Image *image, const VkImageCreateInfo &createInfo, vkpp::Defragmenter::MoveCallback onMoved)
+	{
+		VkImageUsageFlags transfer {VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+		if ((createInfo.usage & transfer) != transfer)
+			throw std::runtime_error("VKPP : Can't defragment an image without both transfer usages");
+
+		if (createInfo.sharingMode != VK_SHARING_MODE_EXCLUSIVE)
+			throw std::runtime_error("VKPP : Can't defragment an image shared between queue families");
+
+		// kept past the caller's scope, so nothing it points to can be
+		VkImageCreateInfo storedCreateInfo {createInfo};
+		storedCreateInfo.pNext = nullptr;
+		storedCreateInfo.queueFamilyIndexCount = 0;
+		storedCreateInfo.pQueueFamilyIndices = nullptr;
+		storedCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+		vkpp::DefragmentationHandle handle {m_nextHandle++};
+		m_resources[handle] = {nullptr, 0, image, storedCreateInfo, std::move(onMoved)};
+		return handle;
+	}
+
+
+
+	void Defragmenter::remove(vkpp::DefragmentationHandle handle)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_resources.erase(handle);
+	}
+
+
+
+	const vkpp::DefragmentationFrame &Defragmenter::record(VkCommandBuffer commandBuffer)
+	{
+		auto start {std::chrono::steady_clock::now()};
+		auto elapsed = [&start] {return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();};
+
+		vkpp::Allocator &allocator {m_device.getAllocator()};
+		std::vector<vkpp::Defragmenter::MoveCallback> callbacks {};
+
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			m_lastFrame = {};
+
+			std::unordered_map<const vkpp::MemoryBlock*, std::vector<vkpp::DefragmentationHandle>> blocks {};
+			for (const auto &[handle, resource] : m_resources)
+			{
+				const vkpp::Allocation &allocation {resource.buffer != nullptr ? resource.buffer->allocation : resource.image->allocation};
+
+				// dedicated allocations have a memory of their own, nothing to compact
+				if (allocation.block != nullptr)
+					blocks[allocation.block].push_back(handle);
+			}
+
+			// a block keeping a single allocation nobody registered can't be emptied, moving the others is wasted
+			std::vector<std::pair<float, const vkpp::MemoryBlock*>> candidates {};
+			for (const auto &[block, handles] : blocks)
+			{
+				vkpp::MemoryBlockInfo info {allocator.getBlockInfo(*block)};
+				float occupancy {static_cast<float> (static_cast<double> (info.used) / static_cast<double> (info.size))};
+
+				if (info.allocationCount == handles.size() && occupancy <= m_parameters.maxBlockOccupancy)
+					candidates.push_back({occupancy, block});
+			}
+
+			std::sort(candidates.begin(), candidates.end(), [](const auto &first, const auto &second) {
+				return first.first < second.first;
+			});
+
+			std::vector<Move> moves {};
+			VkDeviceSize movedBytes {0};
+			bool exhausted {false};
+
+			for (const auto &candidate : candidates)
+			{
+				for (auto handle : blocks[candidate.second])
+				{
+					vkpp::MovableResource &resource {m_resources[handle]};
+					VkDeviceSize size {resource.buffer != nullptr ? resource.buffer->allocation.size : resource.image->allocation.size};
+
+					if (!moves.empty() && (movedBytes + size > m_parameters.maxBytesPerFrame || elapsed() > m_parameters.maxTimePerFrame))
+					{
+						exhausted = true;
+						break;
+					}
+
+					Move move {handle, {}, {}, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED};
+					bool prepared {resource.buffer != nullptr
+						? s_prepareBuffer(resource, candidate.second, move)
+						: s_prepareImage(resource, candidate.second, move)
+					};
+
+					// the rest of the block would fail alike, and the block can't be emptied anymore
+					if (!prepared)
+					{
+						++m_statistics.failedMoveCount;
+						break;
+					}
+
+					movedBytes += size;
+					moves.push_back(std::move(move));
+				}
+
+				if (exhausted)
+					break;
+			}
+
+			if (!moves.empty())
+			{
+				s_recordCopies(commandBuffer, moves);
+
+				for (auto &move : moves)
+				{
+					vkpp::MovableResource &resource {m_resources[move.handle]};
+
+					if (resource.buffer != nullptr)
+					{
+						m_device.getDeletionQueue().retire([&allocator, old = *resource.buffer]() mutable {allocator.destroyBuffer(old);});
+						*resource.buffer = move.buffer;
+					}
+
+					else
+					{
+						m_device.getImageTracker().add(
+							move.image.image, move.image.format, move.image.mipLevels, move.image.arrayLayers, move.newLayout
+						);
+						m_device.getDeletionQueue().retire([&allocator, old = *resource.image]() mutable {allocator.destroyImage(old);});
+						*resource.image = move.image;
+					}
+
+					if (resource.onMoved)
+						callbacks.push_back(resource.onMoved);
+				}
+
+				m_lastFrame.moveCount = static_cast<uint32_t> (moves.size());
+				m_lastFrame.movedBytes = movedBytes;
+				m_statistics.moveCount += moves.size();
+				m_statistics.movedBytes += movedBytes;
+				++m_statistics.passCount;
+			}
+		}
+
+		// outside the lock, owners may register their resources again from there
+		for (const auto &callback : callbacks)
+			callback();
+
+		vkpp::AllocatorStatistics statistics {allocator.getStatistics()};
+		if (statistics.reservedBytes != 0)
+			m_lastFrame.fragmentation = 1.f - static_cast<float> (static_cast<double> (statistics.usedBytes) / static_cast<double> (statistics.reservedBytes));
+
+		m_lastFrame.time = elapsed();
+		return m_lastFrame;
+	}
+
+
+
+	void Defragmenter::resetStatistics() noexcept
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_statistics = {};
+	}
+
+
+
+	bool Defragmenter::s_prepareBuffer(vkpp::MovableResource &resource, const vkpp::MemoryBlock *source, Move &move)
+	{
+		const vkpp::Buffer &old {*resource.buffer};
+
+		VkBufferCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		createInfo.size = old.size;
+		createInfo.usage = resource.bufferUsage;
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkBuffer buffer {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateBuffer(m_device.get(), &createInfo, nullptr, &buffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create a buffer of " + std::to_string(old.size) + " bytes to defragment to");
+
+		VkMemoryRequirements requirements {};
+		m_device.getDispatch().vkGetBufferMemoryRequirements(m_device.get(), buffer, &requirements);
+
+		std::optional<vkpp::Allocation> allocation {
+			m_device.getAllocator().allocateForRelocation(requirements, old.allocation.memoryType, true, source)
+		};
+
+		if (!allocation.has_value())
+		{
+			m_device.getDispatch().vkDestroyBuffer(m_device.get(), buffer, nullptr);
+			return false;
+		}
+
+		if (m_device.getDispatch().vkBindBufferMemory(m_device.get(), buffer, allocation->memory, allocation->offset) != VK_SUCCESS)
+		{
+			m_device.getDispatch().vkDestroyBuffer(m_device.get(), buffer, nullptr);
+			m_device.getAllocator().free(allocation.value());
+			throw std::runtime_error("VKPP : Can't bind memory to a buffer to defragment to");
+		}
+
+		move.buffer = {buffer, old.size, allocation.value()};
+		return true;
+	}
+
+
+
+	bool Defragmenter::s_prepareImage(vkpp::MovableResource &resource, const vkpp::MemoryBlock *source, Move &move)
+	{
+		const vkpp::Image &old {*resource.image};
+		vkpp::ImageTracker &tracker {m_device.getImageTracker()};
+
+		// the new image is registered with a single layout
+		VkImageLayout layout {tracker.getState(old.image).layout};
+		for (uint32_t layer {0}; layer < old.arrayLayers; layer++)
+		{
+			for (uint32_t mip {0}; mip < old.mipLevels; mip++)
+			{
+				if (tracker.getState(old.image, mip, layer).layout != layout)
+					return false;
+			}
+		}
+
+		VkImage image {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateImage(m_device.get(), &resource.imageCreateInfo, nullptr, &image) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create an image to defragment to");
+
+		VkMemoryRequirements requirements {};
+		m_device.getDispatch().vkGetImageMemoryRequirements(m_device.get(), image, &requirements);
+
+		std::optional<vkpp::Allocation> allocation {m_device.getAllocator().allocateForRelocation(
+			requirements, old.allocation.memoryType, resource.imageCreateInfo.tiling == VK_IMAGE_TILING_LINEAR, source
+		)};
+
+		if (!allocation.has_value())
+		{
+			m_device.getDispatch().vkDestroyImage(m_device.get(), image, nullptr);
+			return false;
+		}
+
+		if (m_device.getDispatch().vkBindImageMemory(m_device.get(), image, allocation->memory, allocation->offset) != VK_SUCCESS)
+		{
+			m_device.getDispatch().vkDestroyImage(m_device.get(), image, nullptr);
+			m_device.getAllocator().free(allocation.value());
+			throw std::runtime_error("VKPP : Can't bind memory to an image to defragment to");
+		}
+
+		move.image = {image, old.format, old.extent, old.mipLevels, old.arrayLayers, allocation.value()};
+		move.oldLayout = layout;
+		move.newLayout = layout == VK_IMAGE_LAYOUT_UNDEFINED || layout == VK_IMAGE_LAYOUT_PREINITIALIZED
+			? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+			: layout;
+		return true;
+	}
+
+
+
+	void Defragmenter::s_recordCopies(VkCommandBuffer commandBuffer, const std::vector<Move> &moves)
+	{
+		const vkpp::DeviceDispatch &dispatch {m_device.getDispatch()};
+		std::vector<VkImageMemoryBarrier> preBarriers {};
+		std::vector<VkImageMemoryBarrier> postBarriers {};
+
+		for (const auto &move : moves)
+		{
+			if (move.image.image == VK_NULL_HANDLE)
+				continue;
+
+			const vkpp::Image &old {*m_resources[move.handle].image};
+
+			VkImageMemoryBarrier barrier {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.oldLayout = move.oldLayout;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = old.image;
+			barrier.subresourceRange = {vkpp::getImageAspect(old.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+			preBarriers.push_back(barrier);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.image = move.image.image;
+			preBarriers.push_back(barrier);
+
+			if (move.newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+				continue;
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = move.newLayout;
+			postBarriers.push_back(barrier);
+		}
+
+		// after everything the earlier frames did with the old resources, on the very same queue
+		VkMemoryBarrier memoryBarrier {};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		dispatch.vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 1, &memoryBarrier, 0, nullptr,
+			static_cast<uint32_t> (preBarriers.size()), preBarriers.data()
+		);
+
+		std::vector<VkImageCopy> regions {};
+
+		for (const auto &move : moves)
+		{
+			if (move.buffer.buffer != VK_NULL_HANDLE)
+			{
+				VkBufferCopy region {0, 0, move.buffer.size};
+				dispatch.vkCmdCopyBuffer(commandBuffer, m_resources[move.handle].buffer->buffer, move.buffer.buffer, 1, &region);
+				continue;
+			}
+
+			const vkpp::Image &old {*m_resources[move.handle].image};
+			VkImageAspectFlags aspect {vkpp::getImageAspect(old.format)};
+			regions.clear();
+
+			for (uint32_t mip {0}; mip < old.mipLevels; mip++)
+			{
+				VkImageCopy region {};
+				region.srcSubresource = {aspect, mip, 0, old.arrayLayers};
+				region.dstSubresource = region.srcSubresource;
+				region.extent = {
+					std::max(old.extent.width >> mip, 1u),
+					std::max(old.extent.height >> mip, 1u),
+					std::max(old.extent.depth >> mip, 1u)
+				};
+				regions.push_back(region);
+			}
+
+			dispatch.vkCmdCopyImage(
+				commandBuffer,
+				old.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				move.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				static_cast<uint32_t> (regions.size()), regions.data()
+			);
+		}
+
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+		dispatch.vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 1, &memoryBarrier, 0, nullptr,
+			static_cast<uint32_t> (postBarriers.size()), postBarriers.data()
+		);
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "deletionQueue.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	DeletionQueue::DeletionQueue(vkpp::Device &device) :
+		m_device {device},
+		m_mutex {},
+		m_retired {},
+		m_retiredTimeline {},
+		m_currentFrame {0},
+		m_completedFrame {},
+		m_statistics {}
+	{
+
+	}
+
+
+
+	DeletionQueue::~DeletionQueue()
+	{
+		this->flush();
+	}
+
+
+
+	void DeletionQueue::retire(vkpp::DeletionQueue::Deleter deleter)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_retired.push_back({std::move(deleter), m_currentFrame});
+		++m_statistics.retiredCount;
+		m_statistics.maxPendingCount = std::max<uint64_t> (m_statistics.maxPendingCount, m_retired.size() + m_retiredTimeline.size());
+	}
+
+
+
+	void DeletionQueue::retire(vkpp::DeletionQueue::Deleter deleter, const vkpp::TimelinePoint &point)
+	{
+		if (!m_device.hasScheduler())
+			throw std::runtime_error("VKPP : Can't retire a resource on a timeline without scheduler");
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_retiredTimeline.push_back({std::move(deleter), point});
+		++m_statistics.retiredCount;
+		m_statistics.maxPendingCount = std::max<uint64_t> (m_statistics.maxPendingCount, m_retired.size() + m_retiredTimeline.size());
+	}
+
+
+
+	void DeletionQueue::beginFrame(uint64_t frameNumber, uint32_t framesInFlight)
+	{
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			m_currentFrame = frameNumber;
+			if (frameNumber >= framesInFlight)
+				m_completedFrame = frameNumber - framesInFlight;
+		}
+
+		this->collect();
+	}
+
+
+
+	void DeletionQueue::collect()
+	{
+		auto start {std::chrono::steady_clock::now()};
+		std::vector<vkpp::DeletionQueue::Deleter> deleters {};
+
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+
+			while (m_completedFrame.has_value() && !m_retired.empty() && m_retired.front().frame <= m_completedFrame.value())
+			{
+				deleters.push_back(std::move(m_retired.front().deleter));
+				m_retired.pop_front();
+			}
+
+			if (!m_retiredTimeline.empty())
+			{
+				// one counter query per timeline, however many resources wait on it
+				std::map<vkpp::QueueType, uint64_t> completedValues {};
+				for (const auto &retired : m_retiredTimeline)
+				{
+					if (!completedValues.contains(retired.point.queue))
+						completedValues[retired.point.queue] = m_device.getScheduler().getCompletedValue(retired.point.queue);
+				}
+
+				std::erase_if(m_retiredTimeline, [&](vkpp::RetiredTimelineResource &retired) {
+					if (retired.point.value > completedValues[retired.point.queue])
+						return false;
+
+					deleters.push_back(std::move(retired.deleter));
+					return true;
+				});
+			}
+		}
+
+		// outside the lock, so that a deleter may retire something else
+		for (auto &deleter : deleters)
+			deleter();
+
+		m_statistics.destroyedCount += deleters.size();
+		m_statistics.collectTime += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+	}
+
+
+
+	void DeletionQueue::flush()
+	{
+		// work still queued in the scheduler may use the resources too
+		if (m_device.hasScheduler())
+			m_device.getScheduler().flush();
+
+		m_device.getDispatch().vkDeviceWaitIdle(m_device.get());
+
+		for (;;)
+		{
+			std::deque<vkpp::RetiredResource> retired {};
+			std::vector<vkpp::RetiredTimelineResource> retiredTimeline {};
+
+			{
+				std::lock_guard<std::mutex> lock {m_mutex};
+				retired.swap(m_retired);
+				retiredTimeline.swap(m_retiredTimeline);
+			}
+
+			if (retired.empty() && retiredTimeline.empty())
+				return;
+
+			for (auto &resource : retired)
+				resource.deleter();
+
+			for (auto &resource : retiredTimeline)
+				resource.deleter();
+
+			m_statistics.destroyedCount += retired.size() + retiredTimeline.size();
+		}
+	}
+
+
+
+	void DeletionQueue::resetStatistics() noexcept
+	{
+		m_statistics = {};
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "descriptorAllocator.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	DescriptorAllocator::DescriptorAllocator(
+		vkpp::Device &device,
+		uint32_t framesInFlight,
+		const vkpp::DescriptorAllocatorParameters &parameters
+	) :
+		m_device {device},
+		m_parameters {parameters},
+		m_frames (framesInFlight),
+		m_currentFrame {0},
+		m_freePools {},
+		m_nextPoolSize {std::max(parameters.setsPerPool, 1u)},
+		m_poolCount {0},
+		m_statistics {}
+	{
+		if (framesInFlight == 0)
+			throw std::runtime_error("VKPP : Descriptor allocator needs at least one frame");
+	}
+
+
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		for (const auto &frame : m_frames)
+		{
+			for (auto pool : frame.pools)
+				m_device.getDispatch().vkDestroyDescriptorPool(m_device.get(), pool, nullptr);
+		}
+
+		for (auto pool : m_freePools)
+			m_device.getDispatch().vkDestroyDescriptorPool(m_device.get(), pool, nullptr);
+	}
+
+
+
+	void DescriptorAllocator::beginFrame(uint32_t frameIndex)
+	{
+		if (frameIndex >= m_frames.size())
+			throw std::runtime_error("VKPP : Descriptor allocator has no frame " + std::to_string(frameIndex));
+
+		m_currentFrame = frameIndex;
+		vkpp::FrameDescriptorPools &frame {m_frames[m_currentFrame]};
+
+		// resetting a pool frees all its sets at once, far cheaper than freeing them one by one
+		for (auto pool : frame.pools)
+		{
+			if (m_device.getDispatch().vkResetDescriptorPool(m_device.get(), pool, 0) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't reset a descriptor pool");
+
+			m_freePools.push_back(pool);
+			++m_statistics.resetCount;
+		}
+
+		frame.pools.clear();
+	}
+
+
+
+	VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+	{
+		VkDescriptorSet set {VK_NULL_HANDLE};
+		this->allocate(&layout, 1, &set);
+		return set;
+	}
+
+
+
+	void DescriptorAllocator::allocate(const VkDescriptorSetLayout *layouts, uint32_t count, VkDescriptorSet *sets)
+	{
+		vkpp::FrameDescriptorPools &frame {m_frames[m_currentFrame]};
+		if (frame.pools.empty())
+			frame.pools.push_back(s_nextPool());
+
+		VkDescriptorSetAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = frame.pools.back();
+		allocateInfo.descriptorSetCount = count;
+		allocateInfo.pSetLayouts = layouts;
+
+		VkResult result {m_device.getDispatch().vkAllocateDescriptorSets(m_device.get(), &allocateInfo, sets)};
+
+		// the current pool is full, the allocation moves to a fresh one, and so do the next ones
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			++m_statistics.overflowCount;
+			frame.pools.push_back(s_nextPool());
+			allocateInfo.descriptorPool = frame.pools.back();
+			result = m_device.getDispatch().vkAllocateDescriptorSets(m_device.get(), &allocateInfo, sets);
+		}
+
+		if (result != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't allocate " + std::to_string(count) + " descriptor set(s)");
+
+		m_statistics.allocatedCount += count;
+	}
+
+
+
+	void DescriptorAllocator::resetStatistics() noexcept
+	{
+		m_statistics = {};
+	}
+
+
+
+	VkDescriptorPool DescriptorAllocator::s_nextPool()
+	{
+		if (!m_freePools.empty())
+		{
+			VkDescriptorPool pool {m_freePools.back()};
+			m_freePools.pop_back();
+			return pool;
+		}
+
+		std::vector<VkDescriptorPoolSize> sizes {};
+		sizes.reserve(m_parameters.ratios.size());
+
+		for (const auto &ratio : m_parameters.ratios)
+		{
+			uint32_t descriptorCount {static_cast<uint32_t> (ratio.ratio * static_cast<float> (m_nextPoolSize))};
+			if (descriptorCount != 0)
+				sizes.push_back({ratio.type, descriptorCount});
+		}
+
+		VkDescriptorPoolCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		createInfo.flags = 0;
+		createInfo.maxSets = m_nextPoolSize;
+		createInfo.poolSizeCount = static_cast<uint32_t> (sizes.size());
+		createInfo.pPoolSizes = sizes.data();
+
+		VkDescriptorPool pool {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateDescriptorPool(m_device.get(), &createInfo, nullptr, &pool) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create a descriptor pool of " + std::to_string(m_nextPoolSize) + " sets");
+
+		// frames needing many sets quickly settle on a few large pools
+		m_nextPoolSize = std::min(m_nextPoolSize * 2, std::max(m_parameters.maxSetsPerPool, m_nextPoolSize));
+		++m_poolCount;
+		++m_statistics.createdPoolCount;
+		return pool;
+	}
+
+
+
+} // namespace vkpp
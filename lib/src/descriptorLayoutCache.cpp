@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "descriptorLayoutCache.hpp"
+#include "device.hpp"
+#include "utils/hash.hpp"
+
+
+
+namespace vkpp
+{
+	uint64_t DescriptorLayoutDescription::hash() const noexcept
+	{
+		uint64_t seed {vkpp::utils::FNV_OFFSET_BASIS};
+
+		for (const auto &binding : bindings)
+		{
+			vkpp::utils::hashCombine(seed, binding.binding);
+			vkpp::utils::hashCombine(seed, static_cast<uint32_t> (binding.type));
+			vkpp::utils::hashCombine(seed, binding.count);
+			vkpp::utils::hashCombine(seed, static_cast<uint32_t> (binding.stages));
+			vkpp::utils::hashCombine(seed, static_cast<uint32_t> (binding.flags));
+
+			for (auto sampler : binding.immutableSamplers)
+				vkpp::utils::hashCombine(seed, sampler);
+		}
+
+		vkpp::utils::hashCombine(seed, static_cast<uint32_t> (flags));
+		return seed;
+	}
+
+
+
+	DescriptorLayoutCache::DescriptorLayoutCache(vkpp::Device &device) :
+		m_device {device},
+		m_mutex {},
+		m_layouts {},
+		m_statistics {}
+	{
+
+	}
+
+
+
+	DescriptorLayoutCache::~DescriptorLayoutCache()
+	{
+		for (const auto &layout : m_layouts)
+			m_device.getDispatch().vkDestroyDescriptorSetLayout(m_device.get(), layout.second, nullptr);
+	}
+
+
+
+	VkDescriptorSetLayout DescriptorLayoutCache::get(const vkpp::DescriptorLayoutDescription &description)
+	{
+		// bindings sorted, so that the order they were declared in doesn't split identical layouts
+		vkpp::DescriptorLayoutDescription sorted {description};
+		std::sort(sorted.bindings.begin(), sorted.bindings.end(), [](const auto &first, const auto &second) {
+			return first.binding < second.binding;
+		});
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+		++m_statistics.requestCount;
+
+		auto found {m_layouts.find(sorted)};
+		if (found != m_layouts.end())
+			return found->second;
+
+		VkDescriptorSetLayout layout {s_create(sorted)};
+		m_layouts.emplace(std::move(sorted), layout);
+		++m_statistics.createdCount;
+		return layout;
+	}
+
+
+
+	void DescriptorLayoutCache::resetStatistics() noexcept
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_statistics = {};
+	}
+
+
+
+	VkDescriptorSetLayout DescriptorLayoutCache::s_create(const vkpp::DescriptorLayoutDescription &description)
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings {};
+		std::vector<VkDescriptorBindingFlags> bindingFlags {};
+		bindings.reserve(description.bindings.size());
+		bindingFlags.reserve(description.bindings.size());
+		bool hasFlags {false};
+
+		for (const auto &binding : description.bindings)
+		{
+			if (!binding.immutableSamplers.empty() && binding.immutableSamplers.size() != binding.count)
+				throw std::runtime_error("VKPP : Descriptor binding " + std::to_string(binding.binding) + " needs as many immutable samplers as descriptors");
+
+			VkDescriptorSetLayoutBinding layoutBinding {};
+			layoutBinding.binding = binding.binding;
+			layoutBinding.descriptorType = binding.type;
+			layoutBinding.descriptorCount = binding.count;
+			layoutBinding.stageFlags = binding.stages;
+			layoutBinding.pImmutableSamplers = binding.immutableSamplers.empty() ? nullptr : binding.immutableSamplers.data();
+			bindings.push_back(layoutBinding);
+
+			bindingFlags.push_back(binding.flags);
+			hasFlags |= binding.flags != 0;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo {};
+		bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsCreateInfo.bindingCount = static_cast<uint32_t> (bindingFlags.size());
+		bindingFlagsCreateInfo.pBindingFlags = bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		createInfo.pNext = hasFlags ? &bindingFlagsCreateInfo : nullptr;
+		createInfo.flags = description.flags;
+		createInfo.bindingCount = static_cast<uint32_t> (bindings.size());
+		createInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout layout {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateDescriptorSetLayout(m_device.get(), &createInfo, nullptr, &layout) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create a descriptor set layout");
+
+		return layout;
+	}
+
+
+
+} // namespace vkpp
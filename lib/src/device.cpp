@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
 #include "device.hpp"
+#include "instance.hpp"
 
 
 
@@ -12,76 +15,204 @@ namespace vkpp
 		m_instance {physicalDevice.getInstance()},
 		m_physicalDevice {physicalDevice},
 		m_device {VK_NULL_HANDLE},
-		m_queues {}
+		m_dispatch {},
+		m_queues {},
+		m_queueIndices {},
+		m_imageTracker {nullptr},
+		m_allocator {nullptr},
+		m_memoryBudget {nullptr},
+		m_stagingRing {nullptr},
+		m_pipelineCache {nullptr},
+		m_descriptorLayoutCache {nullptr},
+		m_scheduler {nullptr},
+		m_deletionQueue {nullptr},
+		m_residencyManager {nullptr},
+		m_bindlessHeap {nullptr},
+		m_apiVersion {std::min(static_cast<uint32_t> (m_instance.getParameters().vulkanVersion), physicalDevice.getProperties().apiVersion)},
+		m_bindless {false},
+		m_memoryBudgetExtension {false}
 	{
-		float priority {1.0f};
-
-		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos {};
-		queueCreateInfos.reserve(vkpp::QUEUE_TYPE_AMOUNT);
+		// every queue type gets its own queue of its family while the family has some left, present always
+		// shares the graphics queue when they live in the same family
+		std::map<uint32_t, std::vector<float>> familyPriorities {};
 
+		for (auto type : {vkpp::QueueType::graphics, vkpp::QueueType::present, vkpp::QueueType::compute, vkpp::QueueType::transfer})
+		{
+			const vkpp::QueueInfos &infos {m_physicalDevice.getQueues().get(type)};
 
-		std::vector<uint32_t> usedQueues {};
+			// headless devices have no present queue
+			if (!infos.index.has_value())
+				continue;
 
+			uint32_t family {infos.index.value()};
+			std::vector<float> &priorities {familyPriorities[family]};
 
-		for (auto queueInfo : m_physicalDevice.getQueues().get())
-		{
-			bool addValue {true};
+			if (type == vkpp::QueueType::present && m_queueIndices.contains(vkpp::QueueType::graphics)
+				&& m_physicalDevice.getQueues().get(vkpp::QueueType::graphics).index.value() == family)
+			{
+				m_queueIndices[type] = m_queueIndices[vkpp::QueueType::graphics];
+				continue;
+			}
 
-			for (auto usedQueue : usedQueues)
+			if (priorities.size() < infos.count.value())
 			{
-				if (usedQueue == queueInfo.second.index.value())
-				{
-					addValue = false;
-					break;
-				}
+				m_queueIndices[type] = static_cast<uint32_t> (priorities.size());
+				priorities.push_back(s_getQueuePriority(type));
 			}
 
-			if (!addValue)
-				continue;
+			else
+				m_queueIndices[type] = static_cast<uint32_t> (priorities.size() - 1);
+		}
 
-			queueCreateInfos.push_back({});
-			(queueCreateInfos.end() - 1)->sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			(queueCreateInfos.end() - 1)->queueFamilyIndex = queueInfo.second.index.value();
-			(queueCreateInfos.end() - 1)->queueCount = 1;
-			(queueCreateInfos.end() - 1)->pQueuePriorities = &priority;
+		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos {};
+		queueCreateInfos.reserve(familyPriorities.size());
 
-			usedQueues.push_back(queueInfo.second.index.value());
+		for (const auto &family : familyPriorities)
+		{
+			VkDeviceQueueCreateInfo queueCreateInfo {};
+			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCreateInfo.queueFamilyIndex = family.first;
+			queueCreateInfo.queueCount = static_cast<uint32_t> (family.second.size());
+			queueCreateInfo.pQueuePriorities = family.second.data();
+			queueCreateInfos.push_back(queueCreateInfo);
 		}
-		
 
 		VkPhysicalDeviceFeatures wantedFeatures {};
 
+		// timeline semaphores are a required feature of Vulkan 1.2
+		VkPhysicalDeviceVulkan12Features wantedFeatures12 {};
+		wantedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		wantedFeatures12.timelineSemaphore = VK_TRUE;
+
+		// the subset of descriptor indexing the bindless heap relies on, every piece of it being optional in 1.2
+		const VkPhysicalDeviceVulkan12Features &features12 {m_physicalDevice.getFeatures12()};
+		m_bindless = this->hasScheduler()
+			&& features12.runtimeDescriptorArray
+			&& features12.descriptorBindingPartiallyBound
+			&& features12.descriptorBindingUpdateUnusedWhilePending
+			&& features12.descriptorBindingSampledImageUpdateAfterBind
+			&& features12.descriptorBindingStorageBufferUpdateAfterBind;
+
+		if (m_bindless)
+		{
+			wantedFeatures12.runtimeDescriptorArray = VK_TRUE;
+			wantedFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+			wantedFeatures12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			wantedFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			wantedFeatures12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+			wantedFeatures12.shaderSampledImageArrayNonUniformIndexing = features12.shaderSampledImageArrayNonUniformIndexing;
+			wantedFeatures12.shaderStorageBufferArrayNonUniformIndexing = features12.shaderStorageBufferArrayNonUniformIndexing;
+		}
+
+		// the budget is queried through vkGetPhysicalDeviceMemoryProperties2, an instance level 1.1 function
+		std::vector<const char*> extensions {m_physicalDevice.getExtensions()};
+		m_memoryBudgetExtension = static_cast<uint32_t> (m_instance.getParameters().vulkanVersion) >= VK_API_VERSION_1_1
+			&& m_physicalDevice.isExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		auto isMemoryBudget = [](const char *extension) {return std::string_view(extension) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;};
+		if (m_memoryBudgetExtension && std::none_of(extensions.begin(), extensions.end(), isMemoryBudget))
+			extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
 		VkDeviceCreateInfo deviceCreateInfo {};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t> (m_physicalDevice.getExtensions().size());
-		deviceCreateInfo.ppEnabledExtensionNames = m_physicalDevice.getExtensions().data();
+		deviceCreateInfo.pNext = this->hasScheduler() ? &wantedFeatures12 : nullptr;
+		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t> (extensions.size());
+		deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
 		deviceCreateInfo.enabledLayerCount = 0;
 		deviceCreateInfo.ppEnabledLayerNames = nullptr;
 		deviceCreateInfo.pEnabledFeatures = &wantedFeatures;
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t> (queueCreateInfos.size());
 		deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-		if (vkCreateDevice(m_physicalDevice.get(), &deviceCreateInfo, nullptr, &m_device) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkCreateDevice(m_physicalDevice.get(), &deviceCreateInfo, nullptr, &m_device) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't create a logical device");
 
+		bool swapchain {std::any_of(extensions.begin(), extensions.end(), [](const char *extension) {
+			return std::string_view(extension) == VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+		})};
+		m_dispatch.load(m_instance.getDispatch(), m_device, m_apiVersion, swapchain);
+
 
 		for (uint32_t i {0}; i < vkpp::QUEUE_TYPE_AMOUNT; i++)
 		{
+			if (!m_queueIndices.contains(static_cast<vkpp::QueueType> (i)))
+				continue;
+
 			m_queues[static_cast<vkpp::QueueType> (i)] = {};
-			vkGetDeviceQueue(
+			m_dispatch.vkGetDeviceQueue(
 				m_device,
-				m_physicalDevice.getQueues().get(static_cast<vkpp::QueueType> (i)).index.value(),
-				0,
+				this->getQueueFamily(static_cast<vkpp::QueueType> (i)),
+				m_queueIndices[static_cast<vkpp::QueueType> (i)],
 				&m_queues[static_cast<vkpp::QueueType> (i)]
 			);
 		}
+
+		m_imageTracker = new vkpp::ImageTracker(*this);
+		m_allocator = new vkpp::Allocator(*this);
+		m_memoryBudget = new vkpp::MemoryBudget(*this);
+		m_stagingRing = new vkpp::StagingRing(*this, m_instance.getParameters().stagingRingSize);
+		m_pipelineCache = new vkpp::PipelineCache(*this, m_instance.getParameters().pipelineCachePath);
+		m_descriptorLayoutCache = new vkpp::DescriptorLayoutCache(*this);
+
+		if (this->hasScheduler())
+			m_scheduler = new vkpp::Scheduler(*this);
+
+		m_deletionQueue = new vkpp::DeletionQueue(*this);
+		m_residencyManager = new vkpp::ResidencyManager(*this, m_instance.getParameters().residency);
+
+		if (m_bindless)
+			m_bindlessHeap = new vkpp::BindlessHeap(*this, m_instance.getParameters().bindlessHeap);
 	}
 
 
 
 	Device::~Device()
 	{
-		vkDestroyDevice(m_device, nullptr);
+		delete m_bindlessHeap;
+		delete m_residencyManager;
+		delete m_deletionQueue;
+		delete m_scheduler;
+		delete m_descriptorLayoutCache;
+		delete m_pipelineCache;
+		delete m_stagingRing;
+		delete m_memoryBudget;
+		delete m_allocator;
+		delete m_imageTracker;
+		m_dispatch.vkDestroyDevice(m_device, nullptr);
+	}
+
+
+
+	uint32_t Device::getQueueFamily(vkpp::QueueType type) const
+	{
+		return m_physicalDevice.getQueues().get(type).index.value();
+	}
+
+
+
+	bool Device::isSameQueueFamily(vkpp::QueueType first, vkpp::QueueType second) const
+	{
+		return this->getQueueFamily(first) == this->getQueueFamily(second);
+	}
+
+
+
+	float Device::s_getQueuePriority(vkpp::QueueType type)
+	{
+		switch (type)
+		{
+			case vkpp::QueueType::graphics:
+			case vkpp::QueueType::present:
+				return 1.0f;
+
+			case vkpp::QueueType::compute:
+				return 0.75f;
+
+			case vkpp::QueueType::transfer:
+				return 0.5f;
+		}
+
+		return 1.0f;
 	}
 
 
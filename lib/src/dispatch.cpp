@@ -0,0 +1,91 @@
+#include <stdexcept>
+#include <string>
+
+#ifdef VKPP_DYNAMIC_VULKAN
+	#include <SDL2/SDL_vulkan.h>
+#endif
+
+#include "dispatch.hpp"
+
+
+
+namespace vkpp
+{
+	namespace
+	{
+		template <class T>
+		void loadFunction(T &function, PFN_vkVoidFunction address, const char *name)
+		{
+			if (address == nullptr)
+				throw std::runtime_error("VKPP : Can't load Vulkan function '" + std::string(name) + "'");
+
+			function = reinterpret_cast<T> (address);
+		}
+	}
+
+
+
+	void InstanceDispatch::loadGlobal()
+	{
+		#ifdef VKPP_DYNAMIC_VULKAN
+			// the window already loaded the library when created with SDL_WINDOW_VULKAN
+			if (SDL_Vulkan_GetVkGetInstanceProcAddr() == nullptr && SDL_Vulkan_LoadLibrary(nullptr) != 0)
+				throw std::runtime_error("VKPP : Can't load the Vulkan library : " + std::string(SDL_GetError()));
+
+			vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr> (SDL_Vulkan_GetVkGetInstanceProcAddr());
+		#else
+			vkGetInstanceProcAddr = &::vkGetInstanceProcAddr;
+		#endif
+
+		if (vkGetInstanceProcAddr == nullptr)
+			throw std::runtime_error("VKPP : Can't load vkGetInstanceProcAddr");
+
+		#define VKPP_LOAD_GLOBAL(name) loadFunction(name, vkGetInstanceProcAddr(VK_NULL_HANDLE, #name), #name);
+		VKPP_GLOBAL_FUNCTIONS(VKPP_LOAD_GLOBAL)
+		#undef VKPP_LOAD_GLOBAL
+	}
+
+
+
+	void InstanceDispatch::loadInstance(VkInstance instance, uint32_t apiVersion, bool surface)
+	{
+		#define VKPP_LOAD_INSTANCE(name) loadFunction(name, vkGetInstanceProcAddr(instance, #name), #name);
+		VKPP_INSTANCE_FUNCTIONS(VKPP_LOAD_INSTANCE)
+
+		// the loader returns null for the commands of extensions the instance wasn't created with
+		if (surface)
+		{
+			VKPP_SURFACE_FUNCTIONS(VKPP_LOAD_INSTANCE)
+		}
+
+		if (apiVersion >= VK_API_VERSION_1_1)
+		{
+			VKPP_INSTANCE_11_FUNCTIONS(VKPP_LOAD_INSTANCE)
+		}
+
+		#undef VKPP_LOAD_INSTANCE
+	}
+
+
+
+	void DeviceDispatch::load(const vkpp::InstanceDispatch &instanceDispatch, VkDevice device, uint32_t apiVersion, bool swapchain)
+	{
+		#define VKPP_LOAD_DEVICE(name) loadFunction(name, instanceDispatch.vkGetDeviceProcAddr(device, #name), #name);
+		VKPP_DEVICE_FUNCTIONS(VKPP_LOAD_DEVICE)
+
+		if (swapchain)
+		{
+			VKPP_SWAPCHAIN_FUNCTIONS(VKPP_LOAD_DEVICE)
+		}
+
+		if (apiVersion >= VK_API_VERSION_1_2)
+		{
+			VKPP_DEVICE_12_FUNCTIONS(VKPP_LOAD_DEVICE)
+		}
+
+		#undef VKPP_LOAD_DEVICE
+	}
+
+
+
+} // namespace vkpp
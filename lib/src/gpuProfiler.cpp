@@ -0,0 +1,279 @@
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "gpuProfiler.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	namespace
+	{
+		std::string escapeJson(const std::string &text)
+		{
+			std::string escaped {};
+			escaped.reserve(text.size());
+
+			for (auto character : text)
+			{
+				if (character == '"' || character == '\\')
+					escaped += '\\';
+
+				escaped += character;
+			}
+
+			return escaped;
+		}
+	}
+
+
+
+	GpuProfiler::GpuProfiler(vkpp::Device &device, uint32_t framesInFlight, uint32_t maxScopes, vkpp::QueueType queue, uint32_t historyFrames) :
+		m_device {device},
+		m_enabled {false},
+		m_maxScopes {maxScopes},
+		m_historyFrames {historyFrames},
+		m_timestampPeriod {m_device.getPhysicalDevice().getProperties().limits.timestampPeriod},
+		m_timestampMask {0},
+		m_frames {},
+		m_currentFrame {0},
+		m_depth {0},
+		m_queryResults {},
+		m_origin {0},
+		m_originTicks {0},
+		m_hasOrigin {false},
+		m_lastResults {},
+		m_history {},
+		m_historySizes {}
+	{
+		// without timestampComputeAndGraphics, support must be checked on the queue family itself
+		uint32_t validBits {m_device.getPhysicalDevice().getQueues().get(queue).timestampValidBits};
+		m_enabled = validBits != 0 && m_timestampPeriod > 0.f;
+
+		if (!m_enabled)
+		{
+			#ifndef NDEBUG
+				std::clog << "GPU profiler disabled : queue family can't write timestamps (timestampComputeAndGraphics : "
+					<< m_device.getPhysicalDevice().getProperties().limits.timestampComputeAndGraphics << ")" << std::endl;
+			#endif
+
+			return;
+		}
+
+		m_timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t {1} << validBits) - 1;
+		m_queryResults.resize(m_maxScopes * 2);
+
+		VkQueryPoolCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		createInfo.queryCount = m_maxScopes * 2;
+
+		m_frames.resize(framesInFlight);
+
+		for (auto &frame : m_frames)
+		{
+			frame.number = 0;
+			frame.queryCount = 0;
+
+			if (m_device.getDispatch().vkCreateQueryPool(m_device.get(), &createInfo, nullptr, &frame.pool) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create timestamp query pool");
+		}
+	}
+
+
+
+	GpuProfiler::~GpuProfiler()
+	{
+		for (auto &frame : m_frames)
+			m_device.getDispatch().vkDestroyQueryPool(m_device.get(), frame.pool, nullptr);
+	}
+
+
+
+	void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber)
+	{
+		if (!m_enabled)
+			return;
+
+		if (frameIndex >= m_frames.size())
+			throw std::runtime_error("VKPP : GPU profiler has no frame " + std::to_string(frameIndex));
+
+		m_currentFrame = frameIndex;
+		m_depth = 0;
+		vkpp::ProfilerFrame &frame {m_frames[m_currentFrame]};
+
+		s_readBack(frame);
+
+		frame.number = frameNumber;
+		frame.queryCount = 0;
+		frame.scopes.clear();
+
+		m_device.getDispatch().vkCmdResetQueryPool(commandBuffer, frame.pool, 0, m_maxScopes * 2);
+	}
+
+
+
+	uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string &name, VkPipelineStageFlagBits stage)
+	{
+		if (!m_enabled)
+			return vkpp::PROFILER_INVALID_SCOPE;
+
+		vkpp::ProfilerFrame &frame {m_frames[m_currentFrame]};
+
+		// scopes past the pool's capacity are dropped rather than growing it mid frame
+		if (frame.scopes.size() >= m_maxScopes)
+			return vkpp::PROFILER_INVALID_SCOPE;
+
+		uint32_t scope {static_cast<uint32_t> (frame.scopes.size())};
+		frame.scopes.push_back({name, m_depth++, frame.queryCount++, vkpp::PROFILER_INVALID_SCOPE});
+
+		m_device.getDispatch().vkCmdWriteTimestamp(commandBuffer, stage, frame.pool, frame.scopes[scope].beginQuery);
+		return scope;
+	}
+
+
+
+	void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope, VkPipelineStageFlagBits stage)
+	{
+		if (!m_enabled || scope == vkpp::PROFILER_INVALID_SCOPE)
+			return;
+
+		vkpp::ProfilerFrame &frame {m_frames[m_currentFrame]};
+		frame.scopes[scope].endQuery = frame.queryCount++;
+		--m_depth;
+
+		m_device.getDispatch().vkCmdWriteTimestamp(commandBuffer, stage, frame.pool, frame.scopes[scope].endQuery);
+	}
+
+
+
+	void GpuProfiler::exportChromeTrace(const std::filesystem::path &path) const
+	{
+		std::ofstream file {path};
+		if (!file)
+			throw std::runtime_error("VKPP : Can't open trace file " + path.string());
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		for (size_t i {0}; i < m_history.size(); i++)
+		{
+			const vkpp::GpuTiming &timing {m_history[i]};
+
+			// trace events are expressed in microseconds
+			file << (i == 0 ? "" : ",") << "\n{\"name\":\"" << escapeJson(timing.name) << "\",\"cat\":\"gpu\",\"ph\":\"X\""
+				<< ",\"ts\":" << timing.start * 1000.0 << ",\"dur\":" << timing.duration * 1000.0
+				<< ",\"pid\":0,\"tid\":0,\"args\":{\"frame\":" << timing.frame << ",\"depth\":" << timing.depth << "}}";
+		}
+
+		file << "\n]}\n";
+
+		if (!file)
+			throw std::runtime_error("VKPP : Can't write trace file " + path.string());
+	}
+
+
+
+	void GpuProfiler::clearHistory() noexcept
+	{
+		m_history.clear();
+		m_historySizes.clear();
+	}
+
+
+
+	void GpuProfiler::s_readBack(vkpp::ProfilerFrame &frame)
+	{
+		if (frame.queryCount == 0)
+			return;
+
+		// the slot being reused means its previous submission retired, so this never has to wait
+		VkResult result {m_device.getDispatch().vkGetQueryPoolResults(
+			m_device.get(),
+			frame.pool,
+			0, frame.queryCount,
+			frame.queryCount * sizeof(uint64_t), m_queryResults.data(),
+			sizeof(uint64_t), VK_QUERY_RESULT_64_BIT
+		)};
+
+		if (result == VK_NOT_READY)
+			return;
+
+		if (result != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't get timestamp query results");
+
+		// counters with less than 64 valid bits wrap around : a difference in the upper half of their range is a
+		// timestamp earlier than the one it is measured from, e.g. across queues, and clamped to 0
+		auto getTicks = [this](uint64_t from, uint64_t to) {
+			uint64_t ticks {(to - from) & m_timestampMask};
+			return ticks > m_timestampMask / 2 ? 0 : ticks;
+		};
+
+		auto toMilliseconds = [this](uint64_t ticks) {
+			return static_cast<double> (ticks) * m_timestampPeriod / 1000000.0;
+		};
+
+		// the origin follows the frames, so that a wrapping counter never gets half its range away from it
+		uint64_t first {m_queryResults[0] & m_timestampMask};
+		if (!m_hasOrigin)
+		{
+			m_origin = first;
+			m_hasOrigin = true;
+		}
+
+		uint64_t advance {getTicks(m_origin, first)};
+		m_origin = (m_origin + advance) & m_timestampMask;
+		m_originTicks += advance;
+
+		m_lastResults.clear();
+
+		for (const auto &scope : frame.scopes)
+		{
+			// scopes left open have no end timestamp
+			if (scope.endQuery == vkpp::PROFILER_INVALID_SCOPE)
+				continue;
+
+			uint64_t begin {m_queryResults[scope.beginQuery] & m_timestampMask};
+			uint64_t end {m_queryResults[scope.endQuery] & m_timestampMask};
+
+			m_lastResults.push_back({
+				scope.name,
+				frame.number,
+				scope.depth,
+				toMilliseconds(m_originTicks + getTicks(m_origin, begin)),
+				toMilliseconds(getTicks(begin, end))
+			});
+		}
+
+		m_history.insert(m_history.end(), m_lastResults.begin(), m_lastResults.end());
+		m_historySizes.push_back(m_lastResults.size());
+
+		while (m_historySizes.size() > m_historyFrames)
+		{
+			m_history.erase(m_history.begin(), m_history.begin() + static_cast<std::ptrdiff_t> (m_historySizes.front()));
+			m_historySizes.pop_front();
+		}
+	}
+
+
+
+	ScopedMarker::ScopedMarker(vkpp::GpuProfiler &profiler, VkCommandBuffer commandBuffer, const std::string &name) :
+		m_profiler {profiler},
+		m_commandBuffer {commandBuffer},
+		m_scope {m_profiler.beginScope(m_commandBuffer, name)}
+	{
+
+	}
+
+
+
+	ScopedMarker::~ScopedMarker()
+	{
+		m_profiler.endScope(m_commandBuffer, m_scope);
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "imageTracker.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	namespace
+	{
+		using SubresourceBarrier = std::pair<bool, vkpp::AccessBarrier>;
+
+		// `subresources` is the layer major grid of `range`. Neighbouring mips, then neighbouring layers, transitioning
+		// the same way share a single barrier
+		uint32_t appendImageBarriers(
+			std::vector<VkImageMemoryBarrier> &barriers,
+			VkImage image,
+			VkImageAspectFlags aspect,
+			const vkpp::ImageRange &range,
+			const std::vector<SubresourceBarrier> &subresources
+		)
+		{
+			size_t first {barriers.size()};
+			size_t firstOfLayer {first};
+
+			auto sameTransition = [](const vkpp::AccessBarrier &barrier, const VkImageMemoryBarrier &imageBarrier) {
+				return barrier.srcAccess == imageBarrier.srcAccessMask && barrier.dstAccess == imageBarrier.dstAccessMask
+					&& barrier.oldLayout == imageBarrier.oldLayout && barrier.newLayout == imageBarrier.newLayout;
+			};
+
+			for (uint32_t layer {0}; layer < range.arrayLayerCount; layer++)
+			{
+				size_t layerStart {barriers.size()};
+
+				for (uint32_t mip {0}; mip < range.mipLevelCount; mip++)
+				{
+					const SubresourceBarrier &subresource {subresources[layer * range.mipLevelCount + mip]};
+					if (!subresource.first)
+						continue;
+
+					VkImageMemoryBarrier *previous {barriers.size() > layerStart ? &barriers.back() : nullptr};
+					if (previous != nullptr && sameTransition(subresource.second, *previous)
+						&& previous->subresourceRange.baseMipLevel + previous->subresourceRange.levelCount == range.baseMipLevel + mip)
+					{
+						++previous->subresourceRange.levelCount;
+						continue;
+					}
+
+					VkImageMemoryBarrier barrier {};
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.srcAccessMask = subresource.second.srcAccess;
+					barrier.dstAccessMask = subresource.second.dstAccess;
+					barrier.oldLayout = subresource.second.oldLayout;
+					barrier.newLayout = subresource.second.newLayout;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.image = image;
+					barrier.subresourceRange = {aspect, range.baseMipLevel + mip, 1, range.baseArrayLayer + layer, 1};
+					barriers.push_back(barrier);
+				}
+
+				// a layer transitioning exactly like the one before it extends that one's barriers
+				size_t layerBarriers {barriers.size() - layerStart};
+				bool mergeable {layerStart > firstOfLayer && layerStart - firstOfLayer == layerBarriers};
+
+				for (size_t i {0}; mergeable && i < layerBarriers; i++)
+				{
+					const VkImageMemoryBarrier &previous {barriers[firstOfLayer + i]};
+					const VkImageMemoryBarrier &current {barriers[layerStart + i]};
+
+					mergeable = previous.srcAccessMask == current.srcAccessMask && previous.dstAccessMask == current.dstAccessMask
+						&& previous.oldLayout == current.oldLayout && previous.newLayout == current.newLayout
+						&& previous.subresourceRange.baseMipLevel == current.subresourceRange.baseMipLevel
+						&& previous.subresourceRange.levelCount == current.subresourceRange.levelCount
+						&& previous.subresourceRange.baseArrayLayer + previous.subresourceRange.layerCount == current.subresourceRange.baseArrayLayer;
+				}
+
+				if (mergeable && layerBarriers != 0)
+				{
+					for (size_t i {0}; i < layerBarriers; i++)
+						++barriers[firstOfLayer + i].subresourceRange.layerCount;
+
+					barriers.resize(layerStart);
+				}
+
+				else
+					firstOfLayer = layerStart;
+			}
+
+			return static_cast<uint32_t> (barriers.size() - first);
+		}
+
+
+		vkpp::ImageRange resolveRange(const vkpp::ImageRange &range, uint32_t mipLevels, uint32_t arrayLayers)
+		{
+			vkpp::ImageRange resolved {range};
+			if (resolved.mipLevelCount == VK_REMAINING_MIP_LEVELS)
+				resolved.mipLevelCount = mipLevels - std::min(resolved.baseMipLevel, mipLevels);
+			if (resolved.arrayLayerCount == VK_REMAINING_ARRAY_LAYERS)
+				resolved.arrayLayerCount = arrayLayers - std::min(resolved.baseArrayLayer, arrayLayers);
+
+			if (resolved.mipLevelCount == 0 || resolved.arrayLayerCount == 0
+				|| resolved.baseMipLevel + resolved.mipLevelCount > mipLevels
+				|| resolved.baseArrayLayer + resolved.arrayLayerCount > arrayLayers)
+				throw std::runtime_error("VKPP : Image range out of the image's subresources");
+
+			return resolved;
+		}
+	}
+
+
+
+	LocalImageTracker::LocalImageTracker(vkpp::ImageTracker &tracker) :
+		m_tracker {tracker},
+		m_images {},
+		m_barriers {},
+		m_srcStages {0},
+		m_dstStages {0},
+		m_statistics {}
+	{
+
+	}
+
+
+
+	void LocalImageTracker::use(VkImage image, vkpp::ResourceUsage usage, bool write, const vkpp::ImageRange &range)
+	{
+		this->use(image, vkpp::getAccessRequest(usage, write), range);
+	}
+
+
+
+	void LocalImageTracker::use(VkImage image, const vkpp::AccessRequest &request, const vkpp::ImageRange &range)
+	{
+		auto found {m_images.find(image)};
+		if (found == m_images.end())
+			found = m_images.emplace(image, m_tracker.makeLocal(image)).first;
+
+		vkpp::LocalImage &local {found->second};
+		vkpp::ImageRange resolved {resolveRange(range, local.mipLevels, local.arrayLayers)};
+
+		std::vector<SubresourceBarrier> subresources (resolved.mipLevelCount * resolved.arrayLayerCount, {false, {}});
+
+		for (uint32_t layer {0}; layer < resolved.arrayLayerCount; layer++)
+		{
+			for (uint32_t mip {0}; mip < resolved.mipLevelCount; mip++)
+			{
+				vkpp::LocalSubresource &subresource {local.subresources[(resolved.baseArrayLayer + layer) * local.mipLevels + resolved.baseMipLevel + mip]};
+				SubresourceBarrier &barrier {subresources[layer * resolved.mipLevelCount + mip]};
+
+				// the barrier of a first use is left to the resolution, against the global state
+				if (!subresource.used)
+				{
+					subresource = {true, request, vkpp::getStateAfter(request, true)};
+					continue;
+				}
+
+				barrier.first = vkpp::transitionAccess(subresource.state, request, true, barrier.second);
+
+				if (!barrier.first)
+				{
+					++m_statistics.skippedCount;
+					continue;
+				}
+
+				m_srcStages |= barrier.second.srcStages;
+				m_dstStages |= barrier.second.dstStages;
+			}
+		}
+
+		m_statistics.barrierCount += appendImageBarriers(m_barriers, image, local.aspect, resolved, subresources);
+	}
+
+
+
+	void LocalImageTracker::flush(VkCommandBuffer commandBuffer)
+	{
+		if (m_barriers.empty())
+			return;
+
+		m_tracker.getDevice().getDispatch().vkCmdPipelineBarrier(
+			commandBuffer, m_srcStages, m_dstStages, 0,
+			0, nullptr, 0, nullptr,
+			static_cast<uint32_t> (m_barriers.size()), m_barriers.data()
+		);
+
+		m_barriers.clear();
+		m_srcStages = 0;
+		m_dstStages = 0;
+		++m_statistics.pipelineBarrierCount;
+	}
+
+
+
+	void LocalImageTracker::reset()
+	{
+		m_images.clear();
+		m_barriers.clear();
+		m_srcStages = 0;
+		m_dstStages = 0;
+	}
+
+
+
+	ImageTracker::ImageTracker(vkpp::Device &device) :
+		m_device {device},
+		m_mutex {},
+		m_images {},
+		m_statistics {}
+	{
+
+	}
+
+
+
+	void ImageTracker::add(VkImage image, VkFormat format, uint32_t mipLevels, uint32_t arrayLayers, VkImageLayout initialLayout)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_images[image] = {
+			vkpp::getImageAspect(format), mipLevels, arrayLayers,
+			std::vector<vkpp::AccessState> (mipLevels * arrayLayers, {0, 0, 0, 0, 0, initialLayout})
+		};
+	}
+
+
+
+	void ImageTracker::remove(VkImage image)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_images.erase(image);
+	}
+
+
+
+	uint32_t ImageTracker::resolve(const vkpp::LocalImageTracker &local, VkCommandBuffer commandBuffer)
+	{
+		std::vector<VkImageMemoryBarrier> barriers {};
+		VkPipelineStageFlags srcStages {0};
+		VkPipelineStageFlags dstStages {0};
+
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+
+			for (const auto &[image, localImage] : local.getImages())
+			{
+				// destroyed since it was recorded, nothing will run with it anyway
+				auto tracked {m_images.find(image)};
+				if (tracked == m_images.end())
+					continue;
+
+				std::vector<SubresourceBarrier> subresources (localImage.subresources.size(), {false, {}});
+
+				for (size_t i {0}; i < localImage.subresources.size(); i++)
+				{
+					const vkpp::LocalSubresource &subresource {localImage.subresources[i]};
+					if (!subresource.used)
+						continue;
+
+					vkpp::AccessState &state {tracked->second.states[i]};
+					subresources[i].first = vkpp::transitionAccess(state, subresource.firstUse, true, subresources[i].second);
+
+					if (subresources[i].first)
+					{
+						srcStages |= subresources[i].second.srcStages;
+						dstStages |= subresources[i].second.dstStages;
+					}
+
+					else
+						++m_statistics.skippedCount;
+
+					state = subresource.state;
+				}
+
+				appendImageBarriers(barriers, image, localImage.aspect, {0, localImage.mipLevels, 0, localImage.arrayLayers}, subresources);
+			}
+
+			m_statistics.barrierCount += barriers.size();
+			if (!barriers.empty())
+				++m_statistics.pipelineBarrierCount;
+		}
+
+		if (!barriers.empty())
+		{
+			m_device.getDispatch().vkCmdPipelineBarrier(
+				commandBuffer, srcStages, dstStages, 0,
+				0, nullptr, 0, nullptr,
+				static_cast<uint32_t> (barriers.size()), barriers.data()
+			);
+		}
+
+		return static_cast<uint32_t> (barriers.size());
+	}
+
+
+
+	void ImageTracker::acquire(VkImage image, VkPipelineStageFlags waitStages)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto tracked {m_images.find(image)};
+		if (tracked == m_images.end())
+			return;
+
+		for (auto &state : tracked->second.states)
+			state = {waitStages, 0, 0, 0, 0, state.layout};
+	}
+
+
+
+	vkpp::AccessState ImageTracker::getState(VkImage image, uint32_t mipLevel, uint32_t arrayLayer)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto tracked {m_images.find(image)};
+		if (tracked == m_images.end() || mipLevel >= tracked->second.mipLevels || arrayLayer >= tracked->second.arrayLayers)
+			throw std::runtime_error("VKPP : Can't get the state of an untracked image subresource");
+
+		return tracked->second.states[arrayLayer * tracked->second.mipLevels + mipLevel];
+	}
+
+
+
+	vkpp::LocalImage ImageTracker::makeLocal(VkImage image)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto tracked {m_images.find(image)};
+		if (tracked == m_images.end())
+			throw std::runtime_error("VKPP : Can't use an image the tracker doesn't know");
+
+		const vkpp::TrackedImage &trackedImage {tracked->second};
+		return {
+			trackedImage.aspect, trackedImage.mipLevels, trackedImage.arrayLayers,
+			std::vector<vkpp::LocalSubresource> (trackedImage.states.size(), {false, {}, {}})
+		};
+	}
+
+
+
+	void ImageTracker::resetStatistics() noexcept
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_statistics = {};
+	}
+
+
+
+} // namespace vkpp
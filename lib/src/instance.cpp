@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <stdexcept>
 #include <iostream>
+#include <string_view>
+#include <unordered_set>
 
 #include <SDL2/SDL_vulkan.h>
 
@@ -12,63 +16,119 @@ namespace vkpp
 {
 	Instance::Instance(const vkpp::InstanceParameter &parameter) : 
 		m_parameter {parameter},
+		m_dispatch {},
 		m_instance {VK_NULL_HANDLE},
 		m_surface {VK_NULL_HANDLE},
 		m_physicalDevice {nullptr},
 		m_device {nullptr},
-		m_swapChain {nullptr}
+		m_swapChain {nullptr},
+		m_offscreenTargets {nullptr},
+		m_startupTimings {}
 	{
+		using Clock = std::chrono::steady_clock;
+		auto elapsed = [](Clock::time_point &since) {
+			Clock::time_point now {Clock::now()};
+			double milliseconds {std::chrono::duration<double, std::milli> (now - since).count()};
+			since = now;
+			return milliseconds;
+		};
+
+		Clock::time_point start {Clock::now()};
+		Clock::time_point step {start};
+
+		m_dispatch.loadGlobal();
+
 		bool layerSupported {true};
 
 		#ifdef NDEBUG
 			const std::vector<const char*> layers {};
 		#else
 			const std::vector<const char*> layers {"VK_LAYER_KHRONOS_validation"};
-			layerSupported = s_checkValidationLayers(layers);
+			layerSupported = s_checkValidationLayers(m_dispatch, layers);
 		#endif
 
-		const std::vector<const char*> extensions {s_checkExtensions(m_parameter)};
-		s_createInstance(m_instance, m_parameter, extensions, layers, layerSupported);
+		const std::vector<const char*> extensions {s_checkExtensions(m_dispatch, m_parameter)};
+		m_startupTimings.extensionCheck = elapsed(step);
+
+		s_createInstance(m_dispatch, m_instance, m_parameter, extensions, layers, layerSupported);
+		bool surface {std::any_of(extensions.begin(), extensions.end(), [](const char *extension) {
+			return std::string_view(extension) == VK_KHR_SURFACE_EXTENSION_NAME;
+		})};
+		m_dispatch.loadInstance(m_instance, static_cast<uint32_t> (m_parameter.vulkanVersion), surface);
+		m_startupTimings.instanceCreation = elapsed(step);
 
-		if (!SDL_Vulkan_CreateSurface(m_parameter.window, m_instance, &m_surface))
+		if (!this->isHeadless() && !SDL_Vulkan_CreateSurface(m_parameter.window, m_instance, &m_surface))
 			throw std::runtime_error("VKPP : Can't create a VkSurfaceKHR : " + std::string(SDL_GetError()));
+		m_startupTimings.surfaceCreation = elapsed(step);
 
 		m_physicalDevice = new vkpp::PhysicalDevice(*this);
+		m_startupTimings.physicalDeviceSelection = elapsed(step);
+
 		m_device = new vkpp::Device(*m_physicalDevice);
-		m_swapChain = new vkpp::SwapChain(*this);
+		m_startupTimings.deviceCreation = elapsed(step);
+
+		if (this->isHeadless())
+			m_offscreenTargets = new vkpp::OffscreenTargets(*this);
+		else
+			m_swapChain = new vkpp::SwapChain(*this);
+		m_startupTimings.presentationSetup = elapsed(step);
+
+		m_startupTimings.total = elapsed(start);
+
+		#ifndef NDEBUG
+
+			std::clog << "Startup took " << m_startupTimings.total << " ms :" << std::endl;
+			std::clog << "\tExtensions check : " << m_startupTimings.extensionCheck << " ms" << std::endl;
+			std::clog << "\tInstance creation : " << m_startupTimings.instanceCreation << " ms" << std::endl;
+			std::clog << "\tSurface creation : " << m_startupTimings.surfaceCreation << " ms" << std::endl;
+			std::clog << "\tPhysical device selection : " << m_startupTimings.physicalDeviceSelection << " ms" << std::endl;
+			std::clog << "\tDevice creation : " << m_startupTimings.deviceCreation << " ms" << std::endl;
+			std::clog << "\tPresentation setup : " << m_startupTimings.presentationSetup << " ms" << std::endl;
+
+		#endif
 	}
 
 
 
 	Instance::~Instance()
 	{
+		delete m_offscreenTargets;
 		delete m_swapChain;
 		delete m_device;
 		delete m_physicalDevice;
-		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
-		vkDestroyInstance(m_instance, nullptr);
+
+		if (m_surface != VK_NULL_HANDLE)
+			m_dispatch.vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+
+		m_dispatch.vkDestroyInstance(m_instance, nullptr);
 	}
 
 
 
-	std::vector<const char *> Instance::s_checkExtensions(const vkpp::InstanceParameter &parameter)
+	std::vector<const char *> Instance::s_checkExtensions(const vkpp::InstanceDispatch &dispatch, const vkpp::InstanceParameter &parameter)
 	{
 		uint32_t availableExtensionsCount {};
-		if (vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionsCount, nullptr) != VK_SUCCESS)
+		if (dispatch.vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionsCount, nullptr) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get supported vulkan instance extensions count");
 
 		std::vector<VkExtensionProperties> availableExtensions {availableExtensionsCount};
-		if (vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionsCount, availableExtensions.data()) != VK_SUCCESS)
+		if (dispatch.vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionsCount, availableExtensions.data()) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get supported vulkan instance extensions");
 
 
-		uint32_t neededExtensionsCount {};
-		if (!SDL_Vulkan_GetInstanceExtensions(parameter.window, &neededExtensionsCount, nullptr))
-			throw std::runtime_error("VKPP : Can't get SDL2 required instance extensions count : " + std::string(SDL_GetError()));
+		std::vector<const char*> neededExtensions {};
 
-		std::vector<const char*> neededExtensions {neededExtensionsCount};
-		if (!SDL_Vulkan_GetInstanceExtensions(parameter.window, &neededExtensionsCount, neededExtensions.data()))
-			throw std::runtime_error("VKPP : Can't get SDL2 required instance extensions : " + std::string(SDL_GetError()));
+		// headless instances need no surface extension
+		if (parameter.window != nullptr)
+		{
+			uint32_t neededExtensionsCount {};
+			if (!SDL_Vulkan_GetInstanceExtensions(parameter.window, &neededExtensionsCount, nullptr))
+				throw std::runtime_error("VKPP : Can't get SDL2 required instance extensions count : " + std::string(SDL_GetError()));
+
+			neededExtensions.resize(neededExtensionsCount);
+			if (!SDL_Vulkan_GetInstanceExtensions(parameter.window, &neededExtensionsCount, neededExtensions.data()))
+				throw std::runtime_error("VKPP : Can't get SDL2 required instance extensions : " + std::string(SDL_GetError()));
+		}
 
 
 		neededExtensions.insert(
@@ -77,20 +137,16 @@ namespace vkpp
 			std::make_move_iterator(parameter.instanceExtensions.end())
 		);
 
-		for (auto extension : neededExtensions)
-		{
-			bool found {false};
+		// hashed once, instead of a string comparison per needed and available extension pair
+		std::unordered_set<std::string_view> availableNames {};
+		availableNames.reserve(availableExtensions.size());
 
-			for (auto available : availableExtensions)
-			{
-				if (strcmp(extension, available.extensionName) == 0)
-				{
-					found = true;
-					break;
-				}
-			}
+		for (const auto &available : availableExtensions)
+			availableNames.emplace(available.extensionName);
 
-			if (!found)
+		for (auto extension : neededExtensions)
+		{
+			if (!availableNames.contains(extension))
 				throw std::runtime_error("VKPP : Vulkan instance extension '" + std::string(extension) + "' is not available");
 		}
 
@@ -98,7 +154,7 @@ namespace vkpp
 
 			std::clog << "Supported instance's extensions :" << std::endl;
 
-			for (auto available : availableExtensions)
+			for (const auto &available : availableExtensions)
 				std::clog << "\t" << available.extensionName << std::endl;
 
 		#endif
@@ -108,17 +164,17 @@ namespace vkpp
 
 
 
-	bool Instance::s_checkValidationLayers(const std::vector<const char*> &layers)
+	bool Instance::s_checkValidationLayers(const vkpp::InstanceDispatch &dispatch, const std::vector<const char*> &layers)
 	{
 		uint32_t availableLayersCount {};
-		if (vkEnumerateInstanceLayerProperties(&availableLayersCount, nullptr) != VK_SUCCESS)
+		if (dispatch.vkEnumerateInstanceLayerProperties(&availableLayersCount, nullptr) != VK_SUCCESS)
 		{
 			std::cerr << "VKPP : Can't get supported validation layers count" << std::endl;
 			return false;
 		}
 
 		std::vector<VkLayerProperties> availableLayers {availableLayersCount};
-		if (vkEnumerateInstanceLayerProperties(&availableLayersCount, availableLayers.data()) != VK_SUCCESS)
+		if (dispatch.vkEnumerateInstanceLayerProperties(&availableLayersCount, availableLayers.data()) != VK_SUCCESS)
 		{
 			std::cerr << "VKPP : Can't get supported validation layers" << std::endl;
 			return false;
@@ -126,26 +182,19 @@ namespace vkpp
 
 		std::clog << "Available validation layers : " << std::endl;
 
-		for (auto available : availableLayers)
+		std::unordered_set<std::string_view> availableNames {};
+		availableNames.reserve(availableLayers.size());
+
+		for (const auto &available : availableLayers)
 		{
 			std::clog << "\t" << available.layerName << " : " << available.description << std::endl;
+			availableNames.emplace(available.layerName);
 		}
 
 
 		for (auto layer : layers)
 		{
-			bool found {false};
-
-			for (auto available : availableLayers)
-			{
-				if (strcmp(layer, available.layerName) == 0)
-				{
-					found = true;
-					break;
-				}
-			}
-
-			if (!found)
+			if (!availableNames.contains(layer))
 			{
 				std::cerr << "VKPP : Validation layer '" << layer << "' isn't supported" << std::endl;
 				return false;
@@ -158,6 +207,7 @@ namespace vkpp
 
 
 	void Instance::s_createInstance(
+		const vkpp::InstanceDispatch &dispatch,
 		VkInstance &instance,
 		const vkpp::InstanceParameter &parameter,
 		const std::vector<const char *> &extensions,
@@ -198,7 +248,7 @@ namespace vkpp
 			}
 		#endif
 
-		if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+		if (dispatch.vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't create a vulkan instance");
 	}
 
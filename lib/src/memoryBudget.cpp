@@ -0,0 +1,93 @@
+#include <algorithm>
+
+#include "device.hpp"
+#include "instance.hpp"
+#include "memoryBudget.hpp"
+
+
+
+namespace vkpp
+{
+	MemoryBudget::MemoryBudget(vkpp::Device &device) :
+		m_device {device},
+		m_driverReported {device.hasMemoryBudget()},
+		m_heapCount {device.getPhysicalDevice().getMemoryProperties().memoryHeapCount},
+		m_heaps {},
+		m_statistics {}
+	{
+		const VkPhysicalDeviceMemoryProperties &properties {m_device.getPhysicalDevice().getMemoryProperties()};
+
+		for (uint32_t i {0}; i < m_heapCount; i++)
+		{
+			m_heaps[i].size = properties.memoryHeaps[i].size;
+			m_heaps[i].flags = properties.memoryHeaps[i].flags;
+			m_heaps[i].budget = static_cast<VkDeviceSize> (static_cast<double> (m_heaps[i].size) * FALLBACK_BUDGET_RATIO);
+		}
+
+		this->update();
+	}
+
+
+
+	void MemoryBudget::update()
+	{
+		if (m_driverReported)
+		{
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budget {};
+			budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+			VkPhysicalDeviceMemoryProperties2 properties {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties.pNext = &budget;
+
+			const vkpp::PhysicalDevice &physicalDevice {m_device.getPhysicalDevice()};
+			physicalDevice.getInstance().getDispatch().vkGetPhysicalDeviceMemoryProperties2(physicalDevice.get(), &properties);
+
+			for (uint32_t i {0}; i < m_heapCount; i++)
+			{
+				m_heaps[i].budget = budget.heapBudget[i];
+				m_heaps[i].usage = budget.heapUsage[i];
+			}
+		}
+
+		else
+		{
+			std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> usage {m_device.getAllocator().getHeapUsage()};
+			for (uint32_t i {0}; i < m_heapCount; i++)
+				m_heaps[i].usage = usage[i];
+		}
+
+		++m_statistics.updateCount;
+		bool overBudget {false};
+
+		for (uint32_t i {0}; i < m_heapCount; i++)
+		{
+			float ratio {this->getUsageRatio(i)};
+			m_statistics.peakUsageRatio = std::max(m_statistics.peakUsageRatio, ratio);
+			overBudget |= ratio > 1.f;
+		}
+
+		if (overBudget)
+			++m_statistics.overBudgetCount;
+	}
+
+
+
+	void MemoryBudget::resetStatistics() noexcept
+	{
+		m_statistics = {};
+	}
+
+
+
+	float MemoryBudget::getUsageRatio(uint32_t heap) const noexcept
+	{
+		if (m_heaps[heap].budget == 0)
+			return 0.f;
+
+		return static_cast<float> (static_cast<double> (m_heaps[heap].usage) / static_cast<double> (m_heaps[heap].budget));
+	}
+
+
+
+} // namespace vkpp
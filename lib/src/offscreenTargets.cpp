@@ -0,0 +1,174 @@
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "offscreenTargets.hpp"
+#include "instance.hpp"
+
+
+
+namespace vkpp
+{
+	OffscreenTargets::OffscreenTargets(vkpp::Instance &instance) :
+		m_instance {instance},
+		m_extent {m_instance.getParameters().offscreenExtent},
+		m_format {m_instance.getParameters().offscreenFormat},
+		m_images {},
+		m_frames {},
+		m_readback {nullptr},
+		m_currentFrame {0},
+		m_frameNumber {0},
+		m_lastSubmitted {VK_NULL_HANDLE},
+		m_lastBeginFrame {},
+		m_statistics {}
+	{
+		vkpp::Device &device {m_instance.getDevice()};
+		uint32_t framesInFlight {m_instance.getParameters().framesInFlight};
+
+		VkImageCreateInfo imageCreateInfo {};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageCreateInfo.format = m_format;
+		imageCreateInfo.extent = {m_extent.width, m_extent.height, 1};
+		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkFenceCreateInfo fenceCreateInfo {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		m_images.reserve(framesInFlight);
+		m_frames.resize(framesInFlight);
+
+		for (uint32_t i {0}; i < framesInFlight; i++)
+		{
+			m_images.push_back(device.getAllocator().createImage(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+
+			m_frames[i] = {};
+			m_frames[i].index = i;
+			m_frames[i].imageIndex = i;
+			m_frames[i].image = m_images[i].image;
+			m_frames[i].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+			if (device.getDispatch().vkCreateFence(device.get(), &fenceCreateInfo, nullptr, &m_frames[i].inFlight) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create in flight fence of offscreen frame " + std::to_string(i));
+		}
+
+		// a couple more buffers than frames in flight absorb callbacks slower than a frame
+		if (m_instance.getParameters().offscreenReadback)
+			m_readback = new vkpp::Readback(device, framesInFlight + 2);
+	}
+
+
+
+	OffscreenTargets::~OffscreenTargets()
+	{
+		vkpp::Device &device {m_instance.getDevice()};
+		device.getDispatch().vkDeviceWaitIdle(device.get());
+
+		delete m_readback;
+
+		for (auto &frame : m_frames)
+			device.getDispatch().vkDestroyFence(device.get(), frame.inFlight, nullptr);
+
+		for (auto &image : m_images)
+			device.getAllocator().destroyImage(image);
+	}
+
+
+
+	const vkpp::FrameContext &OffscreenTargets::beginFrame()
+	{
+		vkpp::Device &device {m_instance.getDevice()};
+		vkpp::FrameContext &frame {m_frames[m_currentFrame]};
+
+		auto start {std::chrono::steady_clock::now()};
+		if (m_statistics.frameCount != 0)
+			m_statistics.cpuFrameTime += std::chrono::duration<double, std::milli> (start - m_lastBeginFrame).count();
+		m_lastBeginFrame = start;
+
+		if (device.getDispatch().vkWaitForFences(device.get(), 1, &frame.inFlight, VK_TRUE, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't wait for offscreen frame " + std::to_string(m_currentFrame) + " fence");
+
+		m_statistics.fenceWaitTime += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+		device.getDeletionQueue().beginFrame(m_frameNumber, static_cast<uint32_t> (m_frames.size()));
+		device.getResidencyManager().beginFrame(m_frameNumber, static_cast<uint32_t> (m_frames.size()));
+
+		if (m_readback != nullptr)
+			m_readback->poll();
+
+		frame.number = m_frameNumber;
+		return frame;
+	}
+
+
+
+	void OffscreenTargets::endFrame(const std::vector<VkCommandBuffer> &commandBuffers, vkpp::Readback::Callback readback)
+	{
+		vkpp::Device &device {m_instance.getDevice()};
+		vkpp::FrameContext &frame {m_frames[m_currentFrame]};
+
+		if (m_lastSubmitted != VK_NULL_HANDLE && device.getDispatch().vkGetFenceStatus(device.get(), m_lastSubmitted) == VK_SUCCESS)
+			++m_statistics.gpuStarvedFrames;
+
+		// descriptors written while recording must reach the set before the GPU reads it
+		if (device.hasBindless())
+			device.getBindlessHeap().flush();
+
+		if (device.getDispatch().vkResetFences(device.get(), 1, &frame.inFlight) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't reset offscreen frame " + std::to_string(m_currentFrame) + " fence");
+
+		VkQueue queue {device.getQueue(vkpp::QueueType::graphics)};
+		bool readingBack {m_readback != nullptr && readback};
+
+		// with a scheduler the frame goes out in the same batch as the work queued before it on the graphics queue
+		if (device.hasScheduler())
+		{
+			device.getScheduler().submit(vkpp::QueueType::graphics, {commandBuffers});
+			device.getScheduler().flush(vkpp::QueueType::graphics, readingBack ? VK_NULL_HANDLE : frame.inFlight);
+		}
+
+		else
+		{
+			VkSubmitInfo submitInfo {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = static_cast<uint32_t> (commandBuffers.size());
+			submitInfo.pCommandBuffers = commandBuffers.data();
+
+			if (device.getDispatch().vkQueueSubmit(queue, 1, &submitInfo, readingBack ? VK_NULL_HANDLE : frame.inFlight) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't submit offscreen frame " + std::to_string(m_frameNumber));
+		}
+
+		if (readingBack)
+		{
+			// submitted right after the frame on the same queue, the copy is ordered after it. The frame fence
+			// comes after the copy so that the image isn't rendered to again while being read
+			m_readback->request(frame.image, m_extent, m_format, frame.number, std::move(readback));
+
+			if (device.getDispatch().vkQueueSubmit(queue, 0, nullptr, frame.inFlight) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't submit offscreen frame " + std::to_string(m_frameNumber) + " fence");
+		}
+
+		m_lastSubmitted = frame.inFlight;
+		m_currentFrame = (m_currentFrame + 1) % static_cast<uint32_t> (m_frames.size());
+		++m_frameNumber;
+		++m_statistics.frameCount;
+	}
+
+
+
+	void OffscreenTargets::resetStatistics() noexcept
+	{
+		m_statistics = {};
+	}
+
+
+
+} // namespace vkpp
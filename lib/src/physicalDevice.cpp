@@ -1,3 +1,5 @@
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -42,12 +44,17 @@ namespace vkpp
 
 
 
-	bool QueueFamilyIndices::hasEverything() const noexcept
+	bool QueueFamilyIndices::hasEverything(bool presentRequired) const noexcept
 	{
 		bool result {true};
 
 		for (auto it : m_queues)
+		{
+			if (it.first == vkpp::QueueType::present && !presentRequired)
+				continue;
+
 			result = result && it.second.index.has_value() && it.second.count.has_value();
+		}
 
 		return result;
 	}
@@ -61,10 +68,18 @@ namespace vkpp
 		m_swapChainInfos {},
 		m_properties {},
 		m_features {},
-		m_extensions {
-			VK_KHR_SWAPCHAIN_EXTENSION_NAME
-		}
+		m_features12 {},
+		m_properties12 {},
+		m_memoryProperties {},
+		m_extensions {},
+		m_supportedExtensions {},
+		m_selectionTime {0.0}
 	{
+		auto start {std::chrono::steady_clock::now()};
+
+		if (!m_instance.isHeadless())
+			m_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
 		m_extensions.insert(
 			m_extensions.end(),
 			std::make_move_iterator(m_instance.getParameters().deviceExtensions.begin()),
@@ -73,51 +88,76 @@ namespace vkpp
 
 
 		uint32_t devicesCount {};
-		if (vkEnumeratePhysicalDevices(m_instance.get(), &devicesCount, nullptr) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkEnumeratePhysicalDevices(m_instance.get(), &devicesCount, nullptr) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get physical devices count");
 
 		if (devicesCount == 0)
 			throw std::runtime_error("VKPP : No GPU support Vulkan");
 
 		std::vector<VkPhysicalDevice> devices {devicesCount};
-		if (vkEnumeratePhysicalDevices(m_instance.get(), &devicesCount, devices.data()) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkEnumeratePhysicalDevices(m_instance.get(), &devicesCount, devices.data()) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get physical devices");
 
+		// every device is queried once, each on its own thread on multi GPU machines as the driver round trips
+		// add up, and the chosen one is never queried again
+		std::vector<vkpp::DeviceSnapshot> snapshots {};
+		snapshots.reserve(devicesCount);
+
+		if (m_instance.getParameters().parallelDeviceQueries && devicesCount > 1)
+		{
+			std::vector<std::future<vkpp::DeviceSnapshot>> futures {};
+			futures.reserve(devicesCount);
+
+			for (auto device : devices)
+				futures.push_back(std::async(std::launch::async, [this, device] {return s_takeSnapshot(device);}));
+
+			for (auto &future : futures)
+				snapshots.push_back(future.get());
+		}
+
+		else
+		{
+			for (auto device : devices)
+				snapshots.push_back(s_takeSnapshot(device));
+		}
+
 		std::vector<int> scores {};
 		scores.reserve(devicesCount);
 
-		for (auto device : devices)
-			scores.push_back(s_scoreGPU(device, m_instance, m_extensions));
+		for (const auto &snapshot : snapshots)
+			scores.push_back(s_scoreGPU(snapshot));
 
 		auto bestScore {vkpp::utils::max(scores.begin(), scores.end())};
 		if (*bestScore <= 0)
 			throw std::runtime_error("VKPP : No GPU is suitable for needed use");
 
-		uint32_t index {static_cast<uint32_t> (bestScore - scores.begin())};
-		m_device = devices[index];
-
-		m_queues = s_getQueueFamiliesIndices(m_device);
-		vkGetPhysicalDeviceProperties(m_device, &m_properties);
-		vkGetPhysicalDeviceFeatures(m_device, &m_features);
+		vkpp::DeviceSnapshot &chosen {snapshots[static_cast<size_t> (bestScore - scores.begin())]};
+		m_device = chosen.device;
+		m_queues = chosen.queues;
+		m_properties = chosen.properties;
+		m_features = chosen.features;
+		m_features12 = chosen.features12;
+		m_properties12 = chosen.properties12;
+		m_memoryProperties = chosen.memoryProperties;
+		m_swapChainInfos = std::move(chosen.swapChainInfos);
+		m_supportedExtensions = std::move(chosen.extensions);
 
-		m_swapChainInfos = s_getSwapChainInfos(m_device, m_instance.getSurface());
+		m_selectionTime = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
 
 		#ifndef NDEBUG
 
-			std::clog << "Choosen physical device : " << m_properties.deviceName << " [" << m_properties.deviceID << "]" << std::endl;
-
-			uint32_t supportedExtensionsCount {};
-			if (vkEnumerateDeviceExtensionProperties(m_device, nullptr, &supportedExtensionsCount, nullptr) != VK_SUCCESS)
-				return;
-
-			std::vector<VkExtensionProperties> supportedExtensions {supportedExtensionsCount};
-			if (vkEnumerateDeviceExtensionProperties(m_device, nullptr, &supportedExtensionsCount, supportedExtensions.data()) != VK_SUCCESS)
-				return;
+			for (const auto &snapshot : snapshots)
+			{
+				std::clog << "Physical device " << snapshot.properties.deviceName << " queried in " << snapshot.queryTime
+					<< " ms, scored " << scores[static_cast<size_t> (&snapshot - snapshots.data())] << std::endl;
+			}
 
+			std::clog << "Choosen physical device : " << m_properties.deviceName << " [" << m_properties.deviceID << "] in "
+				<< m_selectionTime << " ms" << std::endl;
 			std::clog << "This device support the following extensions : " << std::endl;
 
-			for (auto supported : supportedExtensions)
-				std::clog << "\t" << supported.extensionName << std::endl;
+			for (const auto &supported : m_supportedExtensions)
+				std::clog << "\t" << supported << std::endl;
 
 		#endif
 	}
@@ -131,20 +171,89 @@ namespace vkpp
 
 
 
-	int PhysicalDevice::s_scoreGPU(VkPhysicalDevice device, vkpp::Instance &instance, const std::vector<const char *> &extensions)
+	void PhysicalDevice::refreshSurfaceCapabilities()
 	{
-		int score {0};
+		if (m_instance.isHeadless())
+			throw std::runtime_error("VKPP : A headless physical device has no surface capabilities");
 
-		if (!s_isValidGPU(device, instance, extensions))
-			return -1;
+		if (m_instance.getDispatch().vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_device, m_instance.getSurface(), &m_swapChainInfos.capabilities) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't refresh physical device surface capabilities");
+	}
+
+
+
+	bool PhysicalDevice::hasResizableBar() const noexcept
+	{
+		VkMemoryPropertyFlags mappableVram {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+
+		for (uint32_t i {0}; i < m_memoryProperties.memoryTypeCount; i++)
+		{
+			const VkMemoryType &type {m_memoryProperties.memoryTypes[i]};
+			if ((type.propertyFlags & mappableVram) == mappableVram && m_memoryProperties.memoryHeaps[type.heapIndex].size > 256ull * 1024 * 1024)
+				return true;
+		}
+
+		return false;
+	}
+
+
+
+	vkpp::DeviceSnapshot PhysicalDevice::s_takeSnapshot(VkPhysicalDevice device) const
+	{
+		auto start {std::chrono::steady_clock::now()};
+
+		vkpp::DeviceSnapshot snapshot {};
+		snapshot.device = device;
+		m_instance.getDispatch().vkGetPhysicalDeviceProperties(device, &snapshot.properties);
+		m_instance.getDispatch().vkGetPhysicalDeviceFeatures(device, &snapshot.features);
+		m_instance.getDispatch().vkGetPhysicalDeviceMemoryProperties(device, &snapshot.memoryProperties);
+
+		if (static_cast<uint32_t> (m_instance.getParameters().vulkanVersion) >= VK_API_VERSION_1_2 && snapshot.properties.apiVersion >= VK_API_VERSION_1_2)
+		{
+			snapshot.features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			VkPhysicalDeviceFeatures2 features {};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &snapshot.features12;
+			m_instance.getDispatch().vkGetPhysicalDeviceFeatures2(device, &features);
+
+			snapshot.properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+			VkPhysicalDeviceProperties2 properties {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties.pNext = &snapshot.properties12;
+			m_instance.getDispatch().vkGetPhysicalDeviceProperties2(device, &properties);
+		}
+
+		uint32_t supportedExtensionsCount {};
+		if (m_instance.getDispatch().vkEnumerateDeviceExtensionProperties(device, nullptr, &supportedExtensionsCount, nullptr) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't get supported device extensions count");
+
+		std::vector<VkExtensionProperties> supportedExtensions {supportedExtensionsCount};
+		if (m_instance.getDispatch().vkEnumerateDeviceExtensionProperties(device, nullptr, &supportedExtensionsCount, supportedExtensions.data()) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't get supported device extensions");
+
+		snapshot.extensions.reserve(supportedExtensionsCount);
+		for (const auto &supported : supportedExtensions)
+			snapshot.extensions.emplace(supported.extensionName);
 
-		VkPhysicalDeviceProperties properties {};
-		vkGetPhysicalDeviceProperties(device, &properties);
+		snapshot.queues = s_getQueueFamiliesIndices(device);
 
-		VkPhysicalDeviceFeatures features {};
-		vkGetPhysicalDeviceFeatures(device, &features);
+		if (!m_instance.isHeadless())
+			snapshot.swapChainInfos = s_getSwapChainInfos(device, m_instance.getSurface());
 
-		if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+		snapshot.queryTime = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+		return snapshot;
+	}
+
+
+
+	int PhysicalDevice::s_scoreGPU(const vkpp::DeviceSnapshot &snapshot) const
+	{
+		int score {0};
+
+		if (!s_isValidGPU(snapshot))
+			return -1;
+
+		if (snapshot.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
 			score += 100;
 
 		return score;
@@ -152,60 +261,100 @@ namespace vkpp
 
 
 
-	vkpp::QueueFamilyIndices PhysicalDevice::s_getQueueFamiliesIndices(VkPhysicalDevice device)
+	vkpp::QueueFamilyIndices PhysicalDevice::s_getQueueFamiliesIndices(VkPhysicalDevice device) const
 	{
 		QueueFamilyIndices indices {};
 
 		uint32_t queueCount {};
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueCount, nullptr);
+		m_instance.getDispatch().vkGetPhysicalDeviceQueueFamilyProperties(device, &queueCount, nullptr);
 
 		std::vector<VkQueueFamilyProperties> queues {queueCount};
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueCount, queues.data());
+		m_instance.getDispatch().vkGetPhysicalDeviceQueueFamilyProperties(device, &queueCount, queues.data());
+
+		std::optional<uint32_t> graphics {};
+		std::optional<uint32_t> present {};
+		std::optional<uint32_t> asyncCompute {};
+		std::optional<uint32_t> anyCompute {};
+		std::optional<uint32_t> dedicatedTransfer {};
+		std::optional<uint32_t> asyncTransfer {};
 
 		for (uint32_t i {0}; i < queueCount; i++)
 		{
-			if (queues[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
-				indices.set(vkpp::QueueType::graphics, {i, queues[i].queueCount});
+			VkQueueFlags flags {queues[i].queueFlags};
 
 			VkBool32 presentSupport {static_cast<VkBool32> (false)};
-			if (vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_instance.getSurface(), &presentSupport) != VK_SUCCESS)
+			if (!m_instance.isHeadless() && m_instance.getDispatch().vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_instance.getSurface(), &presentSupport) != VK_SUCCESS)
 				throw std::runtime_error("VKPP : Can't get availability of present of queue " + std::to_string(i));
 
-			if (presentSupport)
-				indices.set(vkpp::QueueType::present, {i, queues[i].queueCount});
+			// a family doing both graphics and present avoids sharing the swap chain images
+			if ((flags & VK_QUEUE_GRAPHICS_BIT) && (!graphics.has_value() || (presentSupport && present != graphics)))
+			{
+				graphics = i;
+				if (presentSupport)
+					present = i;
+			}
+
+			if (presentSupport && !present.has_value())
+				present = i;
+
+			if ((flags & VK_QUEUE_COMPUTE_BIT) && !anyCompute.has_value())
+				anyCompute = i;
+
+			if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && !asyncCompute.has_value())
+				asyncCompute = i;
 
-			if (indices.hasEverything())
-				return indices;
+			// graphics and compute families implicitly support transfer
+			if (!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && (flags & VK_QUEUE_TRANSFER_BIT) && !dedicatedTransfer.has_value())
+				dedicatedTransfer = i;
+
+			if (!(flags & VK_QUEUE_GRAPHICS_BIT) && (flags & (VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)) && !asyncTransfer.has_value())
+				asyncTransfer = i;
 		}
 
+		auto setType = [&](vkpp::QueueType type, std::optional<uint32_t> family) {
+			if (family.has_value())
+				indices.set(type, {family.value(), queues[family.value()].queueCount, queues[family.value()].timestampValidBits});
+		};
+
+		setType(vkpp::QueueType::graphics, graphics);
+		setType(vkpp::QueueType::present, present);
+		setType(vkpp::QueueType::compute, asyncCompute.has_value() ? asyncCompute : anyCompute);
+
+		if (dedicatedTransfer.has_value())
+			setType(vkpp::QueueType::transfer, dedicatedTransfer);
+		else if (asyncTransfer.has_value())
+			setType(vkpp::QueueType::transfer, asyncTransfer);
+		else
+			setType(vkpp::QueueType::transfer, graphics);
+
 		return indices;
 	}
 
 
 
-	vkpp::SwapChainInfos PhysicalDevice::s_getSwapChainInfos(VkPhysicalDevice device, VkSurfaceKHR surface)
+	vkpp::SwapChainInfos PhysicalDevice::s_getSwapChainInfos(VkPhysicalDevice device, VkSurfaceKHR surface) const
 	{
 		vkpp::SwapChainInfos swapChainInfos {};
 
-		if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &swapChainInfos.capabilities) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &swapChainInfos.capabilities) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get physical device surface capabilities");
 
 		
 		uint32_t formatsCount {};
-		if (vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatsCount, nullptr) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatsCount, nullptr) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get physical device surface formats count");
 
 		swapChainInfos.formats.resize(formatsCount);
-		if (vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatsCount, swapChainInfos.formats.data()) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatsCount, swapChainInfos.formats.data()) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get physical device surface formats");
 
 
 		uint32_t presentModesCount {};
-		if (vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModesCount, nullptr) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModesCount, nullptr) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get physical device surface present modes count");
 
 		swapChainInfos.presentModes.resize(presentModesCount);
-		if (vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModesCount, swapChainInfos.presentModes.data()) != VK_SUCCESS)
+		if (m_instance.getDispatch().vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModesCount, swapChainInfos.presentModes.data()) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get physical device surface present modes");
 
 		return swapChainInfos;
@@ -213,52 +362,20 @@ namespace vkpp
 
 
 
-	bool PhysicalDevice::s_isValidGPU(VkPhysicalDevice device, vkpp::Instance &instance, const std::vector<const char *> &extensions)
+	bool PhysicalDevice::s_isValidGPU(const vkpp::DeviceSnapshot &snapshot) const
 	{
-		uint32_t supportedExtensionsCount {};
-		if (vkEnumerateDeviceExtensionProperties(device, nullptr, &supportedExtensionsCount, nullptr) != VK_SUCCESS)
-			throw std::runtime_error("VKPP : Can't get supported device extensions count");
-
-		std::vector<VkExtensionProperties> supportedExtensions {supportedExtensionsCount};
-		if (vkEnumerateDeviceExtensionProperties(device, nullptr, &supportedExtensionsCount, supportedExtensions.data()) != VK_SUCCESS)
-			throw std::runtime_error("VKPP : Can't get supported device extensions");
-
-		for (auto extension : extensions)
+		for (auto extension : m_extensions)
 		{
-			bool isSupported {false};
-
-			for (auto supported : supportedExtensions)
-			{
-				if (strcmp(extension, supported.extensionName) == 0)
-				{
-					isSupported = true;
-					break;
-				}
-			}
-
-			if (!isSupported)
+			if (!snapshot.extensions.contains(extension))
 				return false;
 		}
 
-
-		vkpp::SwapChainInfos swapChainInfos {s_getSwapChainInfos(device, instance.getSurface())};
-		if (swapChainInfos.formats.empty() || swapChainInfos.presentModes.empty())
+		if (!m_instance.isHeadless() && (snapshot.swapChainInfos.formats.empty() || snapshot.swapChainInfos.presentModes.empty()))
 			return false;
 
-
-		vkpp::QueueFamilyIndices queues {s_getQueueFamiliesIndices(device)};
-
-		if (!(queues.get(vkpp::QueueType::graphics).index.has_value()
-			&& queues.get(vkpp::QueueType::graphics).count.has_value()
-		))
+		if (!snapshot.queues.hasEverything(!m_instance.isHeadless()))
 			return false;
 
-		if (!(queues.get(vkpp::QueueType::present).index.has_value()
-			&& queues.get(vkpp::QueueType::present).count.has_value()
-		))
-			return false;
-
-		
 		return true;
 	}
 
@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "pipelineBuilder.hpp"
+#include "device.hpp"
+#include "utils/hash.hpp"
+
+
+
+namespace vkpp
+{
+	namespace
+	{
+		template <class T>
+		void hashVector(uint64_t &seed, const std::vector<T> &values) noexcept
+		{
+			seed = vkpp::utils::hash(values.data(), values.size() * sizeof(T), seed);
+			vkpp::utils::hashCombine(seed, values.size());
+		}
+
+
+		// the hashed Vulkan structures are made of 32 bits members only, hence without padding
+		template <class T>
+		bool isSameVector(const std::vector<T> &first, const std::vector<T> &second) noexcept
+		{
+			return first.size() == second.size() && std::memcmp(first.data(), second.data(), first.size() * sizeof(T)) == 0;
+		}
+
+
+		void hashStage(uint64_t &seed, const vkpp::ShaderStageDescription &stage) noexcept
+		{
+			vkpp::utils::hashCombine(seed, static_cast<uint32_t> (stage.stage));
+			vkpp::utils::hashCombine(seed, stage.module);
+			vkpp::utils::hashCombine(seed, stage.entryPoint);
+		}
+
+
+		VkPipelineShaderStageCreateInfo getStageCreateInfo(const vkpp::ShaderStageDescription &stage)
+		{
+			VkPipelineShaderStageCreateInfo createInfo {};
+			createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			createInfo.stage = stage.stage;
+			createInfo.module = stage.module;
+			createInfo.pName = stage.entryPoint.c_str();
+			return createInfo;
+		}
+	}
+
+
+
+	uint64_t GraphicsPipelineDescription::hash() const noexcept
+	{
+		uint64_t seed {vkpp::utils::FNV_OFFSET_BASIS};
+
+		for (const auto &stage : stages)
+			hashStage(seed, stage);
+
+		hashVector(seed, vertexBindings);
+		hashVector(seed, vertexAttributes);
+		vkpp::utils::hashCombine(seed, static_cast<uint32_t> (topology));
+		vkpp::utils::hashCombine(seed, static_cast<uint32_t> (polygonMode));
+		vkpp::utils::hashCombine(seed, static_cast<uint32_t> (cullMode));
+		vkpp::utils::hashCombine(seed, static_cast<uint32_t> (frontFace));
+		vkpp::utils::hashCombine(seed, static_cast<uint32_t> (samples));
+		vkpp::utils::hashCombine(seed, depthTest);
+		vkpp::utils::hashCombine(seed, depthWrite);
+		vkpp::utils::hashCombine(seed, static_cast<uint32_t> (depthCompare));
+		hashVector(seed, colorBlendAttachments);
+		hashVector(seed, dynamicStates);
+		vkpp::utils::hashCombine(seed, layout);
+		vkpp::utils::hashCombine(seed, renderPass);
+		vkpp::utils::hashCombine(seed, subpass);
+
+		return seed;
+	}
+
+
+
+	bool GraphicsPipelineDescription::operator==(const vkpp::GraphicsPipelineDescription &other) const noexcept
+	{
+		return stages == other.stages
+			&& isSameVector(vertexBindings, other.vertexBindings)
+			&& isSameVector(vertexAttributes, other.vertexAttributes)
+			&& topology == other.topology
+			&& polygonMode == other.polygonMode
+			&& cullMode == other.cullMode
+			&& frontFace == other.frontFace
+			&& samples == other.samples
+			&& depthTest == other.depthTest
+			&& depthWrite == other.depthWrite
+			&& depthCompare == other.depthCompare
+			&& isSameVector(colorBlendAttachments, other.colorBlendAttachments)
+			&& isSameVector(dynamicStates, other.dynamicStates)
+			&& layout == other.layout
+			&& renderPass == other.renderPass
+			&& subpass == other.subpass;
+	}
+
+
+
+	uint64_t ComputePipelineDescription::hash() const noexcept
+	{
+		uint64_t seed {vkpp::utils::FNV_OFFSET_BASIS};
+		hashStage(seed, stage);
+		vkpp::utils::hashCombine(seed, layout);
+		return seed;
+	}
+
+
+
+	PipelineHandle::PipelineHandle(std::shared_future<VkPipeline> future) :
+		m_future {future}
+	{
+
+	}
+
+
+
+	bool PipelineHandle::isReady() const
+	{
+		return m_future.valid() && m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+
+
+	VkPipeline PipelineHandle::get() const
+	{
+		if (!m_future.valid())
+			throw std::runtime_error("VKPP : Can't get the pipeline of an empty handle");
+
+		return m_future.get();
+	}
+
+
+
+	VkPipeline PipelineHandle::tryGet() const
+	{
+		if (!this->isReady())
+			return VK_NULL_HANDLE;
+
+		return m_future.get();
+	}
+
+
+
+	PipelineBuilder::PipelineBuilder(vkpp::Device &device, uint32_t threadCount) :
+		m_device {device},
+		m_threadPool {threadCount},
+		m_workerCaches {},
+		m_graphicsPipelines {},
+		m_computePipelines {},
+		m_mutex {},
+		m_compilingCount {0},
+		m_compiled {},
+		m_statistics {}
+	{
+		m_workerCaches.reserve(m_threadPool.getThreadCount());
+		for (uint32_t i {0}; i < m_threadPool.getThreadCount(); i++)
+			m_workerCaches.push_back(m_device.getPipelineCache().createWorkerCache());
+	}
+
+
+
+	PipelineBuilder::~PipelineBuilder()
+	{
+		m_threadPool.wait();
+
+		auto destroyPipelines = [this](const auto &pipelines) {
+			for (const auto &pipeline : pipelines)
+			{
+				vkpp::PipelineHandle handle {pipeline.second};
+
+				try
+				{
+					m_device.getDispatch().vkDestroyPipeline(m_device.get(), handle.get(), nullptr);
+				}
+
+				// failed compilations own no pipeline
+				catch (const std::exception &) {}
+			}
+		};
+
+		destroyPipelines(m_graphicsPipelines);
+		destroyPipelines(m_computePipelines);
+
+		m_device.getPipelineCache().merge(m_workerCaches);
+	}
+
+
+
+	vkpp::PipelineHandle PipelineBuilder::build(const vkpp::GraphicsPipelineDescription &description)
+	{
+		return s_build(m_graphicsPipelines, description);
+	}
+
+
+
+	vkpp::PipelineHandle PipelineBuilder::build(const vkpp::ComputePipelineDescription &description)
+	{
+		return s_build(m_computePipelines, description);
+	}
+
+
+
+	void PipelineBuilder::mergeCaches()
+	{
+		// build() submits under the lock, no compilation can start using a worker cache while they are swapped
+		std::unique_lock<std::mutex> lock {m_mutex};
+		m_compiled.wait(lock, [this] {return m_compilingCount == 0;});
+
+		m_device.getPipelineCache().merge(m_workerCaches);
+
+		for (auto &cache : m_workerCaches)
+			cache = m_device.getPipelineCache().createWorkerCache();
+	}
+
+
+
+	vkpp::PipelineBuilderStatistics PipelineBuilder::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return m_statistics;
+	}
+
+
+
+	template <class T>
+	vkpp::PipelineHandle PipelineBuilder::s_build(
+		std::unordered_map<T, std::shared_future<VkPipeline>, vkpp::DescriptionHasher<T>> &pipelines,
+		const T &description
+	)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		++m_statistics.requestCount;
+
+		auto it {pipelines.find(description)};
+		if (it != pipelines.end())
+		{
+			++m_statistics.deduplicatedCount;
+			return {it->second};
+		}
+
+		auto promise {std::make_shared<std::promise<VkPipeline>> ()};
+		it = pipelines.emplace(description, promise->get_future().share()).first;
+
+		// nodes of an unordered_map are stable, the job can keep a reference on the stored description
+		const T &stored {it->first};
+
+		++m_compilingCount;
+		m_threadPool.submit([this, promise, &stored](uint32_t worker) {
+			auto start {std::chrono::steady_clock::now()};
+
+			try
+			{
+				VkPipeline pipeline {s_compile(worker, stored)};
+				s_record(std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count(), false);
+				promise->set_value(pipeline);
+			}
+
+			catch (...)
+			{
+				s_record(std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count(), true);
+				promise->set_exception(std::current_exception());
+			}
+		});
+
+		return {it->second};
+	}
+
+
+
+	VkPipeline PipelineBuilder::s_compile(uint32_t worker, const vkpp::GraphicsPipelineDescription &description)
+	{
+		std::vector<VkPipelineShaderStageCreateInfo> stages {};
+		stages.reserve(description.stages.size());
+		for (const auto &stage : description.stages)
+			stages.push_back(getStageCreateInfo(stage));
+
+		VkPipelineVertexInputStateCreateInfo vertexInput {};
+		vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInput.vertexBindingDescriptionCount = static_cast<uint32_t> (description.vertexBindings.size());
+		vertexInput.pVertexBindingDescriptions = description.vertexBindings.data();
+		vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t> (description.vertexAttributes.size());
+		vertexInput.pVertexAttributeDescriptions = description.vertexAttributes.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = description.topology;
+
+		// viewports and scissors are expected to be dynamic
+		VkPipelineViewportStateCreateInfo viewport {};
+		viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewport.viewportCount = 1;
+		viewport.scissorCount = 1;
+
+		VkPipelineRasterizationStateCreateInfo rasterization {};
+		rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterization.polygonMode = description.polygonMode;
+		rasterization.cullMode = description.cullMode;
+		rasterization.frontFace = description.frontFace;
+		rasterization.lineWidth = 1.f;
+
+		VkPipelineMultisampleStateCreateInfo multisample {};
+		multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisample.rasterizationSamples = description.samples;
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil {};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = description.depthTest;
+		depthStencil.depthWriteEnable = description.depthWrite;
+		depthStencil.depthCompareOp = description.depthCompare;
+
+		VkPipelineColorBlendStateCreateInfo colorBlend {};
+		colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlend.attachmentCount = static_cast<uint32_t> (description.colorBlendAttachments.size());
+		colorBlend.pAttachments = description.colorBlendAttachments.data();
+
+		VkPipelineDynamicStateCreateInfo dynamicState {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = static_cast<uint32_t> (description.dynamicStates.size());
+		dynamicState.pDynamicStates = description.dynamicStates.data();
+
+		VkGraphicsPipelineCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		createInfo.stageCount = static_cast<uint32_t> (stages.size());
+		createInfo.pStages = stages.data();
+		createInfo.pVertexInputState = &vertexInput;
+		createInfo.pInputAssemblyState = &inputAssembly;
+		createInfo.pViewportState = &viewport;
+		createInfo.pRasterizationState = &rasterization;
+		createInfo.pMultisampleState = &multisample;
+		createInfo.pDepthStencilState = &depthStencil;
+		createInfo.pColorBlendState = &colorBlend;
+		createInfo.pDynamicState = &dynamicState;
+		createInfo.layout = description.layout;
+		createInfo.renderPass = description.renderPass;
+		createInfo.subpass = description.subpass;
+		createInfo.basePipelineIndex = -1;
+
+		VkPipeline pipeline {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateGraphicsPipelines(m_device.get(), m_workerCaches[worker], 1, &createInfo, nullptr, &pipeline) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create graphics pipeline");
+
+		return pipeline;
+	}
+
+
+
+	VkPipeline PipelineBuilder::s_compile(uint32_t worker, const vkpp::ComputePipelineDescription &description)
+	{
+		VkComputePipelineCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		createInfo.stage = getStageCreateInfo(description.stage);
+		createInfo.layout = description.layout;
+		createInfo.basePipelineIndex = -1;
+
+		VkPipeline pipeline {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateComputePipelines(m_device.get(), m_workerCaches[worker], 1, &createInfo, nullptr, &pipeline) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create compute pipeline");
+
+		return pipeline;
+	}
+
+
+
+	void PipelineBuilder::s_record(double milliseconds, bool failed)
+	{
+		uint32_t bucket {static_cast<uint32_t> (std::bit_width(static_cast<uint64_t> (milliseconds)))};
+
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+
+			if (failed)
+				++m_statistics.failedCount;
+			else
+				++m_statistics.compiledCount;
+
+			m_statistics.compileTime += milliseconds;
+			++m_statistics.histogram[std::min(bucket, vkpp::PIPELINE_COMPILE_HISTOGRAM_BUCKETS - 1)];
+			--m_compilingCount;
+		}
+
+		m_compiled.notify_all();
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,193 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#include "pipelineCache.hpp"
+#include "device.hpp"
+#include "utils/hash.hpp"
+
+
+
+namespace vkpp
+{
+	PipelineCache::PipelineCache(vkpp::Device &device, const std::filesystem::path &path) :
+		m_device {device},
+		m_path {path},
+		m_cache {VK_NULL_HANDLE},
+		m_warm {false},
+		m_loadedSize {0},
+		m_mutex {}
+	{
+		std::vector<char> data {s_load()};
+		m_warm = !data.empty();
+		m_loadedSize = data.size();
+
+		VkPipelineCacheCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (m_device.getDispatch().vkCreatePipelineCache(m_device.get(), &createInfo, nullptr, &m_cache) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create pipeline cache");
+	}
+
+
+
+	PipelineCache::~PipelineCache()
+	{
+		// a failed save only costs the next startup its warm cache
+		try
+		{
+			this->save();
+		}
+
+		catch (const std::exception &exception)
+		{
+			std::cerr << exception.what() << std::endl;
+		}
+
+		m_device.getDispatch().vkDestroyPipelineCache(m_device.get(), m_cache, nullptr);
+	}
+
+
+
+	void PipelineCache::save()
+	{
+		if (m_path.empty())
+			return;
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		size_t size {};
+		if (m_device.getDispatch().vkGetPipelineCacheData(m_device.get(), m_cache, &size, nullptr) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't get pipeline cache data size");
+
+		std::vector<char> data(size);
+		if (m_device.getDispatch().vkGetPipelineCacheData(m_device.get(), m_cache, &size, data.data()) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't get pipeline cache data");
+
+		const VkPhysicalDeviceProperties &properties {m_device.getPhysicalDevice().getProperties()};
+
+		vkpp::PipelineCacheFileHeader header {};
+		header.magic = vkpp::PIPELINE_CACHE_FILE_MAGIC;
+		header.version = vkpp::PIPELINE_CACHE_FILE_VERSION;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = size;
+		header.dataHash = vkpp::utils::hash(data.data(), size);
+
+		std::filesystem::path temporary {m_path};
+		temporary += ".tmp";
+
+		{
+			std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+			file.write(reinterpret_cast<const char*> (&header), sizeof(header));
+			file.write(data.data(), static_cast<std::streamsize> (size));
+
+			if (!file)
+				throw std::runtime_error("VKPP : Can't write pipeline cache to " + temporary.string());
+		}
+
+		std::error_code error {};
+		std::filesystem::rename(temporary, m_path, error);
+		if (error)
+			throw std::runtime_error("VKPP : Can't replace pipeline cache " + m_path.string() + " : " + error.message());
+	}
+
+
+
+	VkPipelineCache PipelineCache::createWorkerCache()
+	{
+		VkPipelineCacheCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		VkPipelineCache cache {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreatePipelineCache(m_device.get(), &createInfo, nullptr, &cache) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create worker pipeline cache");
+
+		return cache;
+	}
+
+
+
+	void PipelineCache::merge(const std::vector<VkPipelineCache> &workerCaches)
+	{
+		if (workerCaches.empty())
+			return;
+
+		{
+			// the destination cache of a merge must be externally synchronized
+			std::lock_guard<std::mutex> lock {m_mutex};
+			if (m_device.getDispatch().vkMergePipelineCaches(m_device.get(), m_cache, static_cast<uint32_t> (workerCaches.size()), workerCaches.data()) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't merge worker pipeline caches");
+		}
+
+		for (auto cache : workerCaches)
+			m_device.getDispatch().vkDestroyPipelineCache(m_device.get(), cache, nullptr);
+	}
+
+
+
+	std::vector<char> PipelineCache::s_load()
+	{
+		if (m_path.empty() || !std::filesystem::exists(m_path))
+			return {};
+
+		std::ifstream file {m_path, std::ios::binary};
+		vkpp::PipelineCacheFileHeader header {};
+
+		if (!file.read(reinterpret_cast<char*> (&header), sizeof(header)) || !s_isValid(header))
+		{
+			#ifndef NDEBUG
+				std::clog << "Pipeline cache " << m_path << " is stale, starting cold" << std::endl;
+			#endif
+
+			return {};
+		}
+
+		// the size is checked against the file's before allocating, a corrupted header could ask for gigabytes
+		std::error_code error {};
+		uintmax_t fileSize {std::filesystem::file_size(m_path, error)};
+		if (error || fileSize < sizeof(header) || header.dataSize != fileSize - sizeof(header))
+		{
+			#ifndef NDEBUG
+				std::clog << "Pipeline cache " << m_path << " is truncated or corrupted, starting cold" << std::endl;
+			#endif
+
+			return {};
+		}
+
+		std::vector<char> data(header.dataSize);
+		if (!file.read(data.data(), static_cast<std::streamsize> (data.size())) || vkpp::utils::hash(data.data(), data.size()) != header.dataHash)
+		{
+			#ifndef NDEBUG
+				std::clog << "Pipeline cache " << m_path << " is corrupted, starting cold" << std::endl;
+			#endif
+
+			return {};
+		}
+
+		return data;
+	}
+
+
+
+	bool PipelineCache::s_isValid(const vkpp::PipelineCacheFileHeader &header) const
+	{
+		const VkPhysicalDeviceProperties &properties {m_device.getPhysicalDevice().getProperties()};
+
+		return header.magic == vkpp::PIPELINE_CACHE_FILE_MAGIC
+			&& header.version == vkpp::PIPELINE_CACHE_FILE_VERSION
+			&& header.vendorID == properties.vendorID
+			&& header.deviceID == properties.deviceID
+			&& header.driverVersion == properties.driverVersion
+			&& std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+
+
+} // namespace vkpp
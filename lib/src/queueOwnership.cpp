@@ -0,0 +1,136 @@
+#include "device.hpp"
+#include "queueOwnership.hpp"
+
+
+
+namespace vkpp
+{
+	void releaseBufferOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkBuffer buffer,
+		const vkpp::QueueOwnershipTransfer &transfer,
+		VkDeviceSize offset,
+		VkDeviceSize size
+	)
+	{
+		// within a single family the acquire alone carries the whole dependency
+		if (device.isSameQueueFamily(transfer.source, transfer.destination))
+			return;
+
+		VkBufferMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = transfer.srcAccess;
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = device.getQueueFamily(transfer.source);
+		barrier.dstQueueFamilyIndex = device.getQueueFamily(transfer.destination);
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		device.getDispatch().vkCmdPipelineBarrier(
+			commandBuffer,
+			transfer.srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 1, &barrier, 0, nullptr
+		);
+	}
+
+
+
+	void acquireBufferOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkBuffer buffer,
+		const vkpp::QueueOwnershipTransfer &transfer,
+		VkDeviceSize offset,
+		VkDeviceSize size
+	)
+	{
+		bool sameFamily {device.isSameQueueFamily(transfer.source, transfer.destination)};
+
+		VkBufferMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = sameFamily ? transfer.srcAccess : 0;
+		barrier.dstAccessMask = transfer.dstAccess;
+		barrier.srcQueueFamilyIndex = sameFamily ? VK_QUEUE_FAMILY_IGNORED : device.getQueueFamily(transfer.source);
+		barrier.dstQueueFamilyIndex = sameFamily ? VK_QUEUE_FAMILY_IGNORED : device.getQueueFamily(transfer.destination);
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		device.getDispatch().vkCmdPipelineBarrier(
+			commandBuffer,
+			sameFamily ? transfer.srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, transfer.dstStage,
+			0, 0, nullptr, 1, &barrier, 0, nullptr
+		);
+	}
+
+
+
+	void releaseImageOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkImage image,
+		const VkImageSubresourceRange &range,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		const vkpp::QueueOwnershipTransfer &transfer
+	)
+	{
+		if (device.isSameQueueFamily(transfer.source, transfer.destination))
+			return;
+
+		VkImageMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = transfer.srcAccess;
+		barrier.dstAccessMask = 0;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = device.getQueueFamily(transfer.source);
+		barrier.dstQueueFamilyIndex = device.getQueueFamily(transfer.destination);
+		barrier.image = image;
+		barrier.subresourceRange = range;
+
+		device.getDispatch().vkCmdPipelineBarrier(
+			commandBuffer,
+			transfer.srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier
+		);
+	}
+
+
+
+	void acquireImageOwnership(
+		const vkpp::Device &device,
+		VkCommandBuffer commandBuffer,
+		VkImage image,
+		const VkImageSubresourceRange &range,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		const vkpp::QueueOwnershipTransfer &transfer
+	)
+	{
+		bool sameFamily {device.isSameQueueFamily(transfer.source, transfer.destination)};
+
+		// the layout transition is part of both halves of a transfer and happens only once
+		VkImageMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = sameFamily ? transfer.srcAccess : 0;
+		barrier.dstAccessMask = transfer.dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = sameFamily ? VK_QUEUE_FAMILY_IGNORED : device.getQueueFamily(transfer.source);
+		barrier.dstQueueFamilyIndex = sameFamily ? VK_QUEUE_FAMILY_IGNORED : device.getQueueFamily(transfer.destination);
+		barrier.image = image;
+		barrier.subresourceRange = range;
+
+		device.getDispatch().vkCmdPipelineBarrier(
+			commandBuffer,
+			sameFamily ? transfer.srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, transfer.dstStage,
+			0, 0, nullptr, 0, nullptr, 1, &barrier
+		);
+	}
+
+
+
+} // namespace vkpp
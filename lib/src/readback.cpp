@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "readback.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	Readback::Readback(vkpp::Device &device, uint32_t slotCount, uint32_t workerCount, vkpp::QueueType queue) :
+		m_device {device},
+		m_queue {queue},
+		m_slots(std::max<uint32_t> (slotCount, 1)),
+		m_nextRequest {1},
+		m_firstRequest {},
+		m_mutex {},
+		m_statistics {},
+		m_workers {workerCount}
+	{
+		VkCommandPoolCreateInfo poolCreateInfo {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolCreateInfo.queueFamilyIndex = m_device.getQueueFamily(m_queue);
+
+		VkFenceCreateInfo fenceCreateInfo {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (auto &slot : m_slots)
+		{
+			if (m_device.getDispatch().vkCreateCommandPool(m_device.get(), &poolCreateInfo, nullptr, &slot.pool) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create readback command pool");
+
+			VkCommandBufferAllocateInfo allocateInfo {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.commandPool = slot.pool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandBufferCount = 1;
+
+			if (m_device.getDispatch().vkAllocateCommandBuffers(m_device.get(), &allocateInfo, &slot.commandBuffer) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't allocate readback command buffer");
+
+			if (m_device.getDispatch().vkCreateFence(m_device.get(), &fenceCreateInfo, nullptr, &slot.fence) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create readback fence");
+		}
+	}
+
+
+
+	Readback::~Readback()
+	{
+		try
+		{
+			this->flush();
+		}
+
+		catch (const std::exception &) {}
+
+		for (auto &slot : m_slots)
+		{
+			if (slot.buffer.buffer != VK_NULL_HANDLE)
+				m_device.getAllocator().destroyBuffer(slot.buffer);
+
+			m_device.getDispatch().vkDestroyFence(m_device.get(), slot.fence, nullptr);
+			m_device.getDispatch().vkDestroyCommandPool(m_device.get(), slot.pool, nullptr);
+		}
+	}
+
+
+
+	uint64_t Readback::request(VkImage image, VkExtent2D extent, VkFormat format, uint64_t frame, vkpp::Readback::Callback callback)
+	{
+		this->poll();
+
+		auto now {std::chrono::steady_clock::now()};
+
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			if (m_statistics.requestCount++ == 0)
+				m_firstRequest = now;
+		}
+
+		auto slot {std::find_if(m_slots.begin(), m_slots.end(), [](const vkpp::ReadbackSlot &slot) {
+			return slot.state == vkpp::ReadbackSlotState::free;
+		})};
+
+		// waiting for a buffer would stall the caller, the frame is skipped instead
+		if (slot == m_slots.end())
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			++m_statistics.droppedCount;
+			return 0;
+		}
+
+		VkDeviceSize size {static_cast<VkDeviceSize> (extent.width) * extent.height * getTexelSize(format)};
+		s_prepareSlot(*slot, size);
+		s_record(*slot, image, extent);
+
+		slot->result = {m_nextRequest++, frame, slot->buffer.allocation.mapped, size, extent, format, 0.0};
+		slot->callback = std::move(callback);
+		slot->requestTime = now;
+
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &slot->commandBuffer;
+
+		if (m_device.getDispatch().vkQueueSubmit(m_device.getQueue(m_queue), 1, &submitInfo, slot->fence) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't submit readback of frame " + std::to_string(frame));
+
+		slot->state = vkpp::ReadbackSlotState::copying;
+		return slot->result.id;
+	}
+
+
+
+	void Readback::poll()
+	{
+		for (auto &slot : m_slots)
+		{
+			if (slot.state != vkpp::ReadbackSlotState::copying)
+				continue;
+
+			if (m_device.getDispatch().vkGetFenceStatus(m_device.get(), slot.fence) != VK_SUCCESS)
+				continue;
+
+			auto now {std::chrono::steady_clock::now()};
+			slot.result.latency = std::chrono::duration<double, std::milli> (now - slot.requestTime).count();
+
+			if (m_device.getDispatch().vkResetFences(m_device.get(), 1, &slot.fence) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't reset readback fence");
+
+			{
+				std::lock_guard<std::mutex> lock {m_mutex};
+				++m_statistics.completedCount;
+				m_statistics.readBytes += slot.result.size;
+				m_statistics.totalLatency += slot.result.latency;
+				m_statistics.maxLatency = std::max(m_statistics.maxLatency, slot.result.latency);
+				m_statistics.activeTime = std::chrono::duration<double, std::milli> (now - m_firstRequest).count();
+			}
+
+			slot.state = vkpp::ReadbackSlotState::delivering;
+
+			// the slot is only handed back once the callback is done reading its memory
+			m_workers.submit([&slot](uint32_t) {
+				try
+				{
+					if (slot.callback)
+						slot.callback(slot.result);
+				}
+
+				catch (...)
+				{
+					slot.state = vkpp::ReadbackSlotState::free;
+					throw;
+				}
+
+				slot.state = vkpp::ReadbackSlotState::free;
+			});
+		}
+	}
+
+
+
+	void Readback::flush()
+	{
+		for (auto &slot : m_slots)
+		{
+			if (slot.state != vkpp::ReadbackSlotState::copying)
+				continue;
+
+			if (m_device.getDispatch().vkWaitForFences(m_device.get(), 1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't wait for readback fence");
+		}
+
+		this->poll();
+		m_workers.wait();
+	}
+
+
+
+	void Readback::resetStatistics()
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_statistics = {};
+	}
+
+
+
+	vkpp::ReadbackStatistics Readback::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return m_statistics;
+	}
+
+
+
+	vkpp::Readback::Callback Readback::writeToFile(const std::filesystem::path &prefix)
+	{
+		return [prefix](const vkpp::ReadbackResult &result) {
+			bool bgra {result.format == VK_FORMAT_B8G8R8A8_UNORM || result.format == VK_FORMAT_B8G8R8A8_SRGB};
+			if (!bgra && result.format != VK_FORMAT_R8G8B8A8_UNORM && result.format != VK_FORMAT_R8G8B8A8_SRGB)
+				throw std::runtime_error("VKPP : Only RGBA8 and BGRA8 frames can be written to PAM files");
+
+			std::filesystem::path path {prefix};
+			path += std::to_string(result.frame) + ".pam";
+
+			std::ofstream file {path, std::ios::binary};
+			file << "P7\nWIDTH " << result.extent.width << "\nHEIGHT " << result.extent.height
+				<< "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+
+			if (!bgra)
+				file.write(static_cast<const char*> (result.data), static_cast<std::streamsize> (result.size));
+
+			else
+			{
+				// PAM has no BGRA tuple type, rows are swizzled one at a time
+				const char *texels {static_cast<const char*> (result.data)};
+				std::vector<char> row (static_cast<size_t> (result.extent.width) * 4);
+
+				for (VkDeviceSize offset {0}; offset < result.size; offset += row.size())
+				{
+					size_t size {static_cast<size_t> (std::min<VkDeviceSize> (row.size(), result.size - offset))};
+					for (size_t i {0}; i + 3 < size; i += 4)
+					{
+						row[i] = texels[offset + i + 2];
+						row[i + 1] = texels[offset + i + 1];
+						row[i + 2] = texels[offset + i];
+						row[i + 3] = texels[offset + i + 3];
+					}
+
+					file.write(row.data(), static_cast<std::streamsize> (size));
+				}
+			}
+
+			if (!file)
+				throw std::runtime_error("VKPP : Can't write readback file " + path.string());
+		};
+	}
+
+
+
+	VkDeviceSize Readback::getTexelSize(VkFormat format)
+	{
+		switch (format)
+		{
+			case VK_FORMAT_R8G8B8A8_UNORM:
+			case VK_FORMAT_R8G8B8A8_SRGB:
+			case VK_FORMAT_B8G8R8A8_UNORM:
+			case VK_FORMAT_B8G8R8A8_SRGB:
+			case VK_FORMAT_R32_SFLOAT:
+				return 4;
+
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+				return 8;
+
+			case VK_FORMAT_R32G32B32A32_SFLOAT:
+				return 16;
+
+			default:
+				throw std::runtime_error("VKPP : Readback of format " + std::to_string(static_cast<int> (format)) + " isn't supported");
+		}
+	}
+
+
+
+	void Readback::s_prepareSlot(vkpp::ReadbackSlot &slot, VkDeviceSize size)
+	{
+		if (slot.buffer.buffer != VK_NULL_HANDLE && slot.buffer.size >= size)
+			return;
+
+		if (slot.buffer.buffer != VK_NULL_HANDLE)
+			m_device.getAllocator().destroyBuffer(slot.buffer);
+
+		// coherent memory spares the invalidation before every read, cached memory makes those reads fast
+		slot.buffer = m_device.getAllocator().createBuffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+		);
+	}
+
+
+
+	void Readback::s_record(vkpp::ReadbackSlot &slot, VkImage image, VkExtent2D extent)
+	{
+		if (m_device.getDispatch().vkResetCommandPool(m_device.get(), slot.pool, 0) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't reset readback command pool");
+
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (m_device.getDispatch().vkBeginCommandBuffer(slot.commandBuffer, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't begin readback command buffer");
+
+		// the first scope covers everything submitted before on the queue, hence the frame that rendered the image
+		VkImageMemoryBarrier imageBarrier {};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = image;
+		imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+		m_device.getDispatch().vkCmdPipelineBarrier(
+			slot.commandBuffer,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &imageBarrier
+		);
+
+		VkBufferImageCopy region {};
+		region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+		region.imageExtent = {extent.width, extent.height, 1};
+
+		m_device.getDispatch().vkCmdCopyImageToBuffer(
+			slot.commandBuffer,
+			image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			slot.buffer.buffer,
+			1, &region
+		);
+
+		VkBufferMemoryBarrier bufferBarrier {};
+		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.buffer = slot.buffer.buffer;
+		bufferBarrier.size = VK_WHOLE_SIZE;
+
+		m_device.getDispatch().vkCmdPipelineBarrier(
+			slot.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+			0, 0, nullptr, 1, &bufferBarrier, 0, nullptr
+		);
+
+		if (m_device.getDispatch().vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't end readback command buffer");
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,803 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "renderGraph.hpp"
+#include "device.hpp"
+#include "utils/hash.hpp"
+
+
+
+namespace vkpp
+{
+	namespace
+	{
+		constexpr vkpp::RenderGraphResource NO_RESOURCE {std::numeric_limits<vkpp::RenderGraphResource>::max()};
+	}
+
+
+
+	RenderGraphPassBuilder::RenderGraphPassBuilder(vkpp::RenderGraph &graph, uint32_t pass) :
+		m_graph {graph},
+		m_pass {pass}
+	{
+
+	}
+
+
+
+	void RenderGraphPassBuilder::read(vkpp::RenderGraphResource resource, vkpp::ResourceUsage usage)
+	{
+		if (resource >= m_graph.m_resources.size())
+			throw std::runtime_error("VKPP : Can't read an unknown render graph resource");
+
+		m_graph.m_passes[m_pass].accesses.push_back({resource, usage, false});
+	}
+
+
+
+	void RenderGraphPassBuilder::write(vkpp::RenderGraphResource resource, vkpp::ResourceUsage usage)
+	{
+		if (resource >= m_graph.m_resources.size())
+			throw std::runtime_error("VKPP : Can't write an unknown render graph resource");
+
+		if (vkpp::getUsageAccess(usage).writeAccess == 0)
+			throw std::runtime_error("VKPP : Render graph pass '" + m_graph.m_passes[m_pass].name + "' writes through a read only usage");
+
+		m_graph.m_passes[m_pass].accesses.push_back({resource, usage, true});
+	}
+
+
+
+	void RenderGraphPassBuilder::setSideEffects() noexcept
+	{
+		m_graph.m_passes[m_pass].sideEffects = true;
+	}
+
+
+
+	RenderGraph::RenderGraph(vkpp::Device &device, vkpp::BarrierMode mode, uint32_t maxUnusedFrames) :
+		m_device {device},
+		m_mode {mode},
+		m_maxUnusedFrames {maxUnusedFrames},
+		m_resources {},
+		m_passes {},
+		m_cache {},
+		m_compiled {nullptr},
+		m_dirty {true},
+		m_statistics {}
+	{
+
+	}
+
+
+
+	RenderGraph::~RenderGraph()
+	{
+		this->clearCache();
+	}
+
+
+
+	void RenderGraph::reset()
+	{
+		m_resources.clear();
+		m_passes.clear();
+		m_dirty = true;
+	}
+
+
+
+	vkpp::RenderGraphResource RenderGraph::createImage(const std::string &name, const vkpp::RenderGraphImageDescription &description)
+	{
+		m_resources.push_back({name, true, false, false, description, {}, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, VK_NULL_HANDLE, VK_NULL_HANDLE});
+		m_dirty = true;
+		return static_cast<vkpp::RenderGraphResource> (m_resources.size() - 1);
+	}
+
+
+
+	vkpp::RenderGraphResource RenderGraph::createBuffer(const std::string &name, const vkpp::RenderGraphBufferDescription &description)
+	{
+		m_resources.push_back({name, false, false, false, {}, description, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, VK_NULL_HANDLE, VK_NULL_HANDLE});
+		m_dirty = true;
+		return static_cast<vkpp::RenderGraphResource> (m_resources.size() - 1);
+	}
+
+
+
+	vkpp::RenderGraphResource RenderGraph::importImage(
+		const std::string &name,
+		VkImage image,
+		const vkpp::RenderGraphImageDescription &description,
+		VkImageLayout initialLayout,
+		VkImageLayout finalLayout
+	)
+	{
+		m_resources.push_back({name, true, true, true, description, {}, initialLayout, finalLayout, image, VK_NULL_HANDLE});
+		m_dirty = true;
+		return static_cast<vkpp::RenderGraphResource> (m_resources.size() - 1);
+	}
+
+
+
+	vkpp::RenderGraphResource RenderGraph::importBuffer(const std::string &name, VkBuffer buffer, VkDeviceSize size)
+	{
+		m_resources.push_back({name, false, true, true, {}, {size}, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, VK_NULL_HANDLE, buffer});
+		m_dirty = true;
+		return static_cast<vkpp::RenderGraphResource> (m_resources.size() - 1);
+	}
+
+
+
+	void RenderGraph::setImported(vkpp::RenderGraphResource resource, VkImage image)
+	{
+		if (resource >= m_resources.size() || !m_resources[resource].imported || !m_resources[resource].image)
+			throw std::runtime_error("VKPP : Can't set the image of a render graph resource which isn't an imported image");
+
+		m_resources[resource].importedImage = image;
+	}
+
+
+
+	void RenderGraph::setImported(vkpp::RenderGraphResource resource, VkBuffer buffer)
+	{
+		if (resource >= m_resources.size() || !m_resources[resource].imported || m_resources[resource].image)
+			throw std::runtime_error("VKPP : Can't set the buffer of a render graph resource which isn't an imported buffer");
+
+		m_resources[resource].importedBuffer = buffer;
+	}
+
+
+
+	void RenderGraph::setOutput(vkpp::RenderGraphResource resource)
+	{
+		if (resource >= m_resources.size())
+			throw std::runtime_error("VKPP : Can't output an unknown render graph resource");
+
+		m_resources[resource].output = true;
+		m_dirty = true;
+	}
+
+
+
+	void RenderGraph::addPass(
+		const std::string &name,
+		const std::function<void(vkpp::RenderGraphPassBuilder&)> &setup,
+		vkpp::RenderGraphPass::Execute execute
+	)
+	{
+		m_passes.push_back({name, {}, false, std::move(execute)});
+
+		vkpp::RenderGraphPassBuilder builder {*this, static_cast<uint32_t> (m_passes.size() - 1)};
+		setup(builder);
+		m_dirty = true;
+	}
+
+
+
+	void RenderGraph::compile()
+	{
+		if (!m_dirty && m_compiled != nullptr)
+			return;
+
+		std::vector<uint32_t> topology {s_getTopology()};
+		uint64_t hash {vkpp::utils::hash(topology.data(), topology.size() * sizeof(uint32_t))};
+		auto cached {m_cache.find(hash)};
+
+		if (cached != m_cache.end() && cached->second.topology == topology)
+			++m_statistics.cacheHitCount;
+
+		else
+		{
+			// a colliding topology takes the entry over, the graph it held may still be in flight
+			if (cached != m_cache.end())
+			{
+				s_destroyTransients(cached->second);
+				m_cache.erase(cached);
+			}
+
+			cached = m_cache.emplace(hash, vkpp::CompiledRenderGraph {}).first;
+			cached->second.topology = std::move(topology);
+			s_compile(cached->second);
+			++m_statistics.compileCount;
+		}
+
+		m_compiled = &cached->second;
+		m_compiled->lastUsedFrame = m_device.getDeletionQueue().getCurrentFrame();
+		m_dirty = false;
+
+		m_statistics.passCount = static_cast<uint32_t> (m_compiled->passes.size());
+		m_statistics.culledPassCount = m_compiled->culledPassCount;
+		m_statistics.pipelineBarrierCount = static_cast<uint32_t> (m_compiled->batches.size());
+		m_statistics.memoryBarrierCount = static_cast<uint32_t> (m_compiled->memoryBarriers.size());
+		m_statistics.imageBarrierCount = static_cast<uint32_t> (m_compiled->imageBarriers.size());
+		m_statistics.transientBytes = m_compiled->transientBytes;
+		m_statistics.allocatedBytes = m_compiled->allocatedBytes;
+	}
+
+
+
+	void RenderGraph::execute(VkCommandBuffer commandBuffer)
+	{
+		this->compile();
+		m_compiled->lastUsedFrame = m_device.getDeletionQueue().getCurrentFrame();
+		s_evictUnused();
+		vkpp::CompiledRenderGraph &compiled {*m_compiled};
+
+		for (size_t i {0}; i < compiled.imageBarriers.size(); i++)
+		{
+			const vkpp::RenderGraphResourceDeclaration &resource {m_resources[compiled.imageBarrierResources[i]]};
+			if (resource.imported)
+				compiled.imageBarriers[i].image = resource.importedImage;
+		}
+
+		auto record = [&](uint32_t first, uint32_t count) {
+			for (uint32_t i {first}; i < first + count; i++)
+			{
+				const vkpp::BarrierBatch &batch {compiled.batches[i]};
+				m_device.getDispatch().vkCmdPipelineBarrier(
+					commandBuffer, batch.srcStages, batch.dstStages, 0,
+					batch.memoryBarrierCount, compiled.memoryBarriers.data() + batch.firstMemoryBarrier,
+					0, nullptr,
+					batch.imageBarrierCount, compiled.imageBarriers.data() + batch.firstImageBarrier
+				);
+			}
+		};
+
+		for (const auto &pass : compiled.passes)
+		{
+			record(pass.firstBatch, pass.batchCount);
+
+			if (m_passes[pass.pass].execute)
+				m_passes[pass.pass].execute(commandBuffer, *this);
+		}
+
+		record(compiled.firstFinalBatch, compiled.finalBatchCount);
+	}
+
+
+
+	void RenderGraph::clearCache()
+	{
+		for (auto &compiled : m_cache)
+			s_destroyTransients(compiled.second);
+
+		m_cache.clear();
+		m_compiled = nullptr;
+	}
+
+
+
+	void RenderGraph::resetStatistics() noexcept
+	{
+		m_statistics.compileCount = 0;
+		m_statistics.cacheHitCount = 0;
+	}
+
+
+
+	VkImage RenderGraph::getImage(vkpp::RenderGraphResource resource) const
+	{
+		if (resource >= m_resources.size() || !m_resources[resource].image)
+			throw std::runtime_error("VKPP : Render graph resource " + std::to_string(resource) + " isn't an image");
+
+		if (m_resources[resource].imported)
+			return m_resources[resource].importedImage;
+
+		if (m_compiled == nullptr)
+			throw std::runtime_error("VKPP : Render graph transient images only exist once compiled");
+
+		return m_compiled->images[resource];
+	}
+
+
+
+	VkBuffer RenderGraph::getBuffer(vkpp::RenderGraphResource resource) const
+	{
+		if (resource >= m_resources.size() || m_resources[resource].image)
+			throw std::runtime_error("VKPP : Render graph resource " + std::to_string(resource) + " isn't a buffer");
+
+		if (m_resources[resource].imported)
+			return m_resources[resource].importedBuffer;
+
+		if (m_compiled == nullptr)
+			throw std::runtime_error("VKPP : Render graph transient buffers only exist once compiled");
+
+		return m_compiled->buffers[resource];
+	}
+
+
+
+	std::vector<uint32_t> RenderGraph::s_getTopology() const
+	{
+		std::vector<uint32_t> topology {static_cast<uint32_t> (m_mode), static_cast<uint32_t> (m_resources.size())};
+
+		for (const auto &resource : m_resources)
+		{
+			topology.push_back(resource.image);
+			topology.push_back(resource.imported);
+			topology.push_back(resource.output);
+
+			if (resource.image)
+			{
+				topology.push_back(static_cast<uint32_t> (resource.imageDescription.format));
+				topology.push_back(resource.imageDescription.extent.width);
+				topology.push_back(resource.imageDescription.extent.height);
+				topology.push_back(resource.imageDescription.extent.depth);
+				topology.push_back(resource.imageDescription.mipLevels);
+				topology.push_back(resource.imageDescription.arrayLayers);
+				topology.push_back(static_cast<uint32_t> (resource.initialLayout));
+				topology.push_back(static_cast<uint32_t> (resource.finalLayout));
+			}
+
+			else
+			{
+				topology.push_back(static_cast<uint32_t> (resource.bufferDescription.size));
+				topology.push_back(static_cast<uint32_t> (resource.bufferDescription.size >> 32));
+			}
+		}
+
+		for (const auto &pass : m_passes)
+		{
+			topology.push_back(pass.sideEffects);
+			topology.push_back(static_cast<uint32_t> (pass.accesses.size()));
+
+			for (const auto &access : pass.accesses)
+			{
+				topology.push_back(access.resource);
+				topology.push_back(static_cast<uint32_t> (access.usage));
+				topology.push_back(access.write);
+			}
+		}
+
+		return topology;
+	}
+
+
+
+	void RenderGraph::s_evictUnused()
+	{
+		uint64_t currentFrame {m_device.getDeletionQueue().getCurrentFrame()};
+
+		// the deletion queue keeps the transient resources alive until the frames that executed them retired
+		for (auto compiled {m_cache.begin()}; compiled != m_cache.end();)
+		{
+			if (&compiled->second == m_compiled || compiled->second.lastUsedFrame + m_maxUnusedFrames >= currentFrame)
+			{
+				++compiled;
+				continue;
+			}
+
+			s_destroyTransients(compiled->second);
+			compiled = m_cache.erase(compiled);
+		}
+	}
+
+
+
+	void RenderGraph::s_compile(vkpp::CompiledRenderGraph &compiled)
+	{
+		std::vector<bool> kept {s_cull()};
+
+		compiled.culledPassCount = static_cast<uint32_t> (std::count(kept.begin(), kept.end(), false));
+		std::vector<vkpp::RenderGraphResource> aliasPredecessors {s_allocateTransients(compiled, kept)};
+		s_computeBarriers(compiled, kept, aliasPredecessors);
+	}
+
+
+
+	std::vector<bool> RenderGraph::s_cull() const
+	{
+		std::vector<bool> needed (m_resources.size(), false);
+		for (size_t i {0}; i < m_resources.size(); i++)
+			needed[i] = m_resources[i].imported || m_resources[i].output;
+
+		// walking backward, a pass is kept when a kept pass after it or the outside reads what it writes
+		std::vector<bool> kept (m_passes.size(), false);
+
+		for (size_t i {m_passes.size()}; i-- > 0;)
+		{
+			const vkpp::RenderGraphPass &pass {m_passes[i]};
+			kept[i] = pass.sideEffects || std::any_of(pass.accesses.begin(), pass.accesses.end(), [&](const vkpp::RenderGraphAccess &access) {
+				return access.write && needed[access.resource];
+			});
+
+			if (!kept[i])
+				continue;
+
+			for (const auto &access : pass.accesses)
+			{
+				if (!access.write)
+					needed[access.resource] = true;
+			}
+		}
+
+		return kept;
+	}
+
+
+
+	std::vector<vkpp::RenderGraphResource> RenderGraph::s_allocateTransients(vkpp::CompiledRenderGraph &compiled, const std::vector<bool> &kept)
+	{
+		VkDevice device {m_device.get()};
+		const vkpp::DeviceDispatch &dispatch {m_device.getDispatch()};
+
+		compiled.images.assign(m_resources.size(), VK_NULL_HANDLE);
+		compiled.buffers.assign(m_resources.size(), VK_NULL_HANDLE);
+		compiled.transientBytes = 0;
+		compiled.allocatedBytes = 0;
+
+		// lifetimes in pass indices, and the usages the resources are created with
+		constexpr uint32_t UNUSED {std::numeric_limits<uint32_t>::max()};
+		std::vector<uint32_t> firstUse (m_resources.size(), UNUSED);
+		std::vector<uint32_t> lastUse (m_resources.size(), 0);
+		std::vector<VkFlags> usages (m_resources.size(), 0);
+
+		for (uint32_t i {0}; i < m_passes.size(); i++)
+		{
+			if (!kept[i])
+				continue;
+
+			for (const auto &access : m_passes[i].accesses)
+			{
+				firstUse[access.resource] = std::min(firstUse[access.resource], i);
+				lastUse[access.resource] = std::max(lastUse[access.resource], i);
+
+				vkpp::UsageAccess infos {vkpp::getUsageAccess(access.usage)};
+				usages[access.resource] |= m_resources[access.resource].image ? infos.imageUsage : infos.bufferUsage;
+			}
+		}
+
+		std::vector<VkMemoryRequirements> requirements (m_resources.size());
+		std::vector<vkpp::RenderGraphResource> transients {};
+
+		for (vkpp::RenderGraphResource i {0}; i < m_resources.size(); i++)
+		{
+			const vkpp::RenderGraphResourceDeclaration &resource {m_resources[i]};
+			if (resource.imported || firstUse[i] == UNUSED)
+				continue;
+
+			if (resource.image)
+			{
+				VkImageCreateInfo createInfo {};
+				createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				createInfo.imageType = resource.imageDescription.extent.depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
+				createInfo.format = resource.imageDescription.format;
+				createInfo.extent = resource.imageDescription.extent;
+				createInfo.mipLevels = resource.imageDescription.mipLevels;
+				createInfo.arrayLayers = resource.imageDescription.arrayLayers;
+				createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				createInfo.usage = usages[i];
+				createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+				if (dispatch.vkCreateImage(device, &createInfo, nullptr, &compiled.images[i]) != VK_SUCCESS)
+					throw std::runtime_error("VKPP : Can't create render graph image '" + resource.name + "'");
+
+				dispatch.vkGetImageMemoryRequirements(device, compiled.images[i], &requirements[i]);
+			}
+
+			else
+			{
+				VkBufferCreateInfo createInfo {};
+				createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+				createInfo.size = resource.bufferDescription.size;
+				createInfo.usage = usages[i];
+				createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+				if (dispatch.vkCreateBuffer(device, &createInfo, nullptr, &compiled.buffers[i]) != VK_SUCCESS)
+					throw std::runtime_error("VKPP : Can't create render graph buffer '" + resource.name + "'");
+
+				dispatch.vkGetBufferMemoryRequirements(device, compiled.buffers[i], &requirements[i]);
+			}
+
+			compiled.transientBytes += requirements[i].size;
+			transients.push_back(i);
+		}
+
+		// largest first, every resource goes to the first memory whose occupants' lifetimes it doesn't overlap. Buffers
+		// and optimal images never share a memory, to stay clear of bufferImageGranularity
+		std::sort(transients.begin(), transients.end(), [&](vkpp::RenderGraphResource first, vkpp::RenderGraphResource second) {
+			return requirements[first].size > requirements[second].size;
+		});
+
+		std::vector<std::vector<vkpp::RenderGraphResource>> occupants {};
+		std::vector<uint32_t> memoryOf (m_resources.size(), UNUSED);
+
+		for (auto resource : transients)
+		{
+			bool linear {!m_resources[resource].image};
+			uint32_t memory {0};
+
+			for (; memory < compiled.memories.size(); memory++)
+			{
+				const vkpp::TransientMemory &candidate {compiled.memories[memory]};
+				if (candidate.linear != linear || (candidate.requirements.memoryTypeBits & requirements[resource].memoryTypeBits) == 0)
+					continue;
+
+				bool overlaps {std::any_of(occupants[memory].begin(), occupants[memory].end(), [&](vkpp::RenderGraphResource occupant) {
+					return firstUse[resource] <= lastUse[occupant] && firstUse[occupant] <= lastUse[resource];
+				})};
+
+				if (!overlaps)
+					break;
+			}
+
+			if (memory == compiled.memories.size())
+			{
+				compiled.memories.push_back({{}, requirements[resource], linear});
+				occupants.emplace_back();
+			}
+
+			VkMemoryRequirements &merged {compiled.memories[memory].requirements};
+			merged.size = std::max(merged.size, requirements[resource].size);
+			merged.alignment = std::max(merged.alignment, requirements[resource].alignment);
+			merged.memoryTypeBits &= requirements[resource].memoryTypeBits;
+
+			occupants[memory].push_back(resource);
+			memoryOf[resource] = memory;
+		}
+
+		for (auto &memory : compiled.memories)
+		{
+			memory.allocation = m_device.getAllocator().allocate(memory.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, memory.linear);
+			compiled.allocatedBytes += memory.requirements.size;
+		}
+
+		for (auto resource : transients)
+		{
+			const vkpp::Allocation &allocation {compiled.memories[memoryOf[resource]].allocation};
+
+			VkResult result {m_resources[resource].image
+				? dispatch.vkBindImageMemory(device, compiled.images[resource], allocation.memory, allocation.offset)
+				: dispatch.vkBindBufferMemory(device, compiled.buffers[resource], allocation.memory, allocation.offset)
+			};
+
+			if (result != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't bind render graph resource '" + m_resources[resource].name + "' memory");
+		}
+
+		// the first occupant of a memory follows its last one, from the previous execution of the graph
+		std::vector<vkpp::RenderGraphResource> predecessors (m_resources.size(), NO_RESOURCE);
+
+		for (auto &memory : occupants)
+		{
+			std::sort(memory.begin(), memory.end(), [&](vkpp::RenderGraphResource first, vkpp::RenderGraphResource second) {
+				return firstUse[first] < firstUse[second];
+			});
+
+			for (size_t i {0}; i < memory.size(); i++)
+				predecessors[memory[i]] = memory[(i + memory.size() - 1) % memory.size()];
+		}
+
+		return predecessors;
+	}
+
+
+
+	void RenderGraph::s_computeBarriers(
+		vkpp::CompiledRenderGraph &compiled,
+		const std::vector<bool> &kept,
+		const std::vector<vkpp::RenderGraphResource> &aliasPredecessors
+	) const
+	{
+		// every kept pass' requests, one per resource it uses
+		std::vector<std::vector<std::pair<vkpp::RenderGraphResource, vkpp::AccessRequest>>> requests (m_passes.size());
+
+		for (size_t i {0}; i < m_passes.size(); i++)
+		{
+			if (!kept[i])
+				continue;
+
+			for (const auto &access : m_passes[i].accesses)
+			{
+				vkpp::AccessRequest request {vkpp::getAccessRequest(access.usage, access.write)};
+
+				auto merged {std::find_if(requests[i].begin(), requests[i].end(), [&](const auto &other) {return other.first == access.resource;})};
+				if (merged == requests[i].end())
+				{
+					requests[i].push_back({access.resource, request});
+					continue;
+				}
+
+				if (m_resources[access.resource].image && merged->second.layout != request.layout)
+					throw std::runtime_error("VKPP : Render graph pass '" + m_passes[i].name + "' uses image '" + m_resources[access.resource].name + "' in two layouts");
+
+				merged->second.stages |= request.stages;
+				merged->second.readAccess |= request.readAccess;
+				merged->second.writeAccess |= request.writeAccess;
+			}
+		}
+
+		auto initialStates = [&]() {
+			std::vector<vkpp::AccessState> states (m_resources.size());
+			for (size_t i {0}; i < m_resources.size(); i++)
+			{
+				// whatever used an imported resource before the graph is unknown
+				if (m_resources[i].imported)
+					states[i] = {VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT, 0, 0, 0, m_resources[i].initialLayout};
+				else
+					states[i] = {0, 0, 0, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED};
+			}
+
+			return states;
+		};
+
+		// a dry run gives the state every transient resource is left in, which the next occupant of its memory waits on
+		std::vector<vkpp::AccessState> finalStates {initialStates()};
+		for (const auto &pass : requests)
+		{
+			for (const auto &request : pass)
+			{
+				vkpp::AccessBarrier barrier {};
+				vkpp::transitionAccess(finalStates[request.first], request.second, m_resources[request.first].image, barrier);
+			}
+		}
+
+		std::vector<vkpp::AccessState> states {initialStates()};
+		std::vector<bool> used (m_resources.size(), false);
+
+		compiled.passes.clear();
+		compiled.batches.clear();
+		compiled.memoryBarriers.clear();
+		compiled.imageBarriers.clear();
+		compiled.imageBarrierResources.clear();
+
+		// barriers of a transition point, merged into a single batch unless in naive mode
+		auto openBatch = [&]() {
+			compiled.batches.push_back({
+				0, 0,
+				static_cast<uint32_t> (compiled.memoryBarriers.size()), 0,
+				static_cast<uint32_t> (compiled.imageBarriers.size()), 0
+			});
+		};
+
+		auto addBarrier = [&](vkpp::RenderGraphResource resource, const vkpp::AccessBarrier &barrier) {
+			vkpp::BarrierBatch &batch {compiled.batches.back()};
+			batch.srcStages |= barrier.srcStages;
+			batch.dstStages |= barrier.dstStages;
+
+			const vkpp::RenderGraphResourceDeclaration &declaration {m_resources[resource]};
+
+			if (!declaration.image || (m_mode == vkpp::BarrierMode::merged && barrier.oldLayout == barrier.newLayout))
+			{
+				// buffers and images keeping their layout share a single global memory barrier
+				if (batch.memoryBarrierCount == 0)
+				{
+					compiled.memoryBarriers.push_back({VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, 0, 0});
+					batch.memoryBarrierCount = 1;
+				}
+
+				compiled.memoryBarriers.back().srcAccessMask |= barrier.srcAccess;
+				compiled.memoryBarriers.back().dstAccessMask |= barrier.dstAccess;
+				return;
+			}
+
+			VkImageMemoryBarrier imageBarrier {};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.srcAccessMask = barrier.srcAccess;
+			imageBarrier.dstAccessMask = barrier.dstAccess;
+			imageBarrier.oldLayout = barrier.oldLayout;
+			imageBarrier.newLayout = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = declaration.imported ? declaration.importedImage : compiled.images[resource];
+			imageBarrier.subresourceRange = {
+				vkpp::getImageAspect(declaration.imageDescription.format),
+				0, declaration.imageDescription.mipLevels,
+				0, declaration.imageDescription.arrayLayers
+			};
+
+			compiled.imageBarriers.push_back(imageBarrier);
+			compiled.imageBarrierResources.push_back(resource);
+			++batch.imageBarrierCount;
+		};
+
+		for (uint32_t i {0}; i < m_passes.size(); i++)
+		{
+			if (!kept[i])
+				continue;
+
+			vkpp::CompiledRenderPass compiledPass {i, static_cast<uint32_t> (compiled.batches.size()), 0};
+
+			for (const auto &[resource, request] : requests[i])
+			{
+				vkpp::AccessState &state {states[resource]};
+
+				// the memory of a transient resource was last used by the resource before it, its content is discarded
+				if (!used[resource] && !m_resources[resource].imported)
+				{
+					const vkpp::AccessState &predecessor {finalStates[aliasPredecessors[resource]]};
+					state = {predecessor.writeStages | predecessor.readStages, predecessor.writeAccess, 0, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED};
+				}
+
+				used[resource] = true;
+
+				vkpp::AccessBarrier barrier {};
+				bool needed {vkpp::transitionAccess(state, request, m_resources[resource].image, barrier)};
+
+				if (m_mode == vkpp::BarrierMode::naive)
+				{
+					barrier = {
+						VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+						VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+						needed ? barrier.oldLayout : state.layout, state.layout
+					};
+
+					openBatch();
+					addBarrier(resource, barrier);
+					++compiledPass.batchCount;
+					continue;
+				}
+
+				if (!needed)
+					continue;
+
+				if (compiledPass.batchCount == 0)
+				{
+					openBatch();
+					compiledPass.batchCount = 1;
+				}
+
+				addBarrier(resource, barrier);
+			}
+
+			compiled.passes.push_back(compiledPass);
+		}
+
+		compiled.firstFinalBatch = static_cast<uint32_t> (compiled.batches.size());
+		compiled.finalBatchCount = 0;
+
+		for (vkpp::RenderGraphResource i {0}; i < m_resources.size(); i++)
+		{
+			const vkpp::RenderGraphResourceDeclaration &resource {m_resources[i]};
+			if (!resource.imported || !resource.image || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || states[i].layout == resource.finalLayout)
+				continue;
+
+			if (compiled.finalBatchCount == 0 || m_mode == vkpp::BarrierMode::naive)
+			{
+				openBatch();
+				++compiled.finalBatchCount;
+			}
+
+			addBarrier(i, {
+				states[i].writeStages | states[i].readStages, states[i].writeAccess,
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				states[i].layout, resource.finalLayout
+			});
+		}
+	}
+
+
+
+	void RenderGraph::s_destroyTransients(vkpp::CompiledRenderGraph &compiled)
+	{
+		// the graph may still be executing on the GPU
+		m_device.getDeletionQueue().retire([&device = m_device, images = compiled.images, buffers = compiled.buffers, memories = compiled.memories]() mutable {
+			for (auto image : images)
+			{
+				if (image != VK_NULL_HANDLE)
+					device.getDispatch().vkDestroyImage(device.get(), image, nullptr);
+			}
+
+			for (auto buffer : buffers)
+			{
+				if (buffer != VK_NULL_HANDLE)
+					device.getDispatch().vkDestroyBuffer(device.get(), buffer, nullptr);
+			}
+
+			for (auto &memory : memories)
+				device.getAllocator().free(memory.allocation);
+		});
+
+		compiled.images.clear();
+		compiled.buffers.clear();
+		compiled.memories.clear();
+	}
+
+
+
+} // namespace vkpp
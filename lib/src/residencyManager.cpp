@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "device.hpp"
+#include "residencyManager.hpp"
+
+
+
+namespace vkpp
+{
+	ResidencyManager::ResidencyManager(vkpp::Device &device, const vkpp::ResidencyParameters &parameters) :
+		m_device {device},
+		m_parameters {parameters},
+		m_mutex {},
+		m_resources {},
+		m_locations {},
+		m_residentBytes {},
+		m_pending {},
+		m_nextHandle {1},
+		m_currentFrame {0},
+		m_statistics {}
+	{
+		if (m_parameters.evictionTarget > m_parameters.evictionThreshold)
+			throw std::runtime_error("VKPP : Residency eviction target must be lower than its threshold");
+	}
+
+
+
+	vkpp::ResidencyHandle ResidencyManager::add(const vkpp::Allocation &allocation, vkpp::ResidencyManager::Evictor evictor)
+	{
+		const VkPhysicalDeviceMemoryProperties &properties {m_device.getPhysicalDevice().getMemoryProperties()};
+		return this->add(properties.memoryTypes[allocation.memoryType].heapIndex, allocation.size, std::move(evictor));
+	}
+
+
+
+	vkpp::ResidencyHandle ResidencyManager::add(uint32_t heap, VkDeviceSize size, vkpp::ResidencyManager::Evictor evictor)
+	{
+		if (heap >= m_device.getPhysicalDevice().getMemoryProperties().memoryHeapCount)
+			throw std::runtime_error("VKPP : Can't make a resource resident in heap " + std::to_string(heap) + ", the device has no such heap");
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+		vkpp::ResidencyHandle handle {m_nextHandle++};
+
+		std::list<vkpp::ResidentResource> &resources {m_resources[heap]};
+		resources.push_back({handle, size, m_currentFrame, std::move(evictor)});
+		m_locations[handle] = {heap, std::prev(resources.end())};
+		m_residentBytes[heap] += size;
+		return handle;
+	}
+
+
+
+	bool ResidencyManager::touch(vkpp::ResidencyHandle handle)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto location {m_locations.find(handle)};
+		if (location == m_locations.end())
+			return false;
+
+		location->second.resource->lastUsedFrame = m_currentFrame;
+
+		// most recently used to the back, iterators stay valid
+		std::list<vkpp::ResidentResource> &resources {m_resources[location->second.heap]};
+		resources.splice(resources.end(), resources, location->second.resource);
+		return true;
+	}
+
+
+
+	void ResidencyManager::remove(vkpp::ResidencyHandle handle)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto location {m_locations.find(handle)};
+		if (location == m_locations.end())
+			return;
+
+		m_residentBytes[location->second.heap] -= location->second.resource->size;
+		m_resources[location->second.heap].erase(location->second.resource);
+		m_locations.erase(location);
+	}
+
+
+
+	void ResidencyManager::beginFrame(uint64_t frameNumber, uint32_t framesInFlight)
+	{
+		vkpp::MemoryBudget &budget {m_device.getMemoryBudget()};
+		budget.update();
+
+		std::vector<vkpp::ResidencyManager::Evictor> evictors {};
+
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			m_currentFrame = frameNumber;
+
+			// the deletion queue collected what those frames retired, the budget sees it gone
+			while (!m_pending.empty() && m_pending.front().frame + framesInFlight <= frameNumber)
+				m_pending.pop_front();
+
+			// a freed suballocation only returns bytes to its block, the driver keeps counting the whole block : the
+			// space left free in the blocks is available as well, else every eviction would be followed by another
+			std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> availableBytes {m_device.getAllocator().getHeapFreeBytes()};
+			for (const auto &pending : m_pending)
+				availableBytes[pending.heap] += pending.size;
+
+			bool pressure {false};
+			bool starved {false};
+
+			for (uint32_t heap {0}; heap < budget.getHeapCount(); heap++)
+			{
+				const vkpp::HeapBudget &heapBudget {budget.getHeap(heap)};
+				VkDeviceSize usage {heapBudget.usage - std::min(heapBudget.usage, availableBytes[heap])};
+
+				if (static_cast<double> (usage) <= static_cast<double> (heapBudget.budget) * m_parameters.evictionThreshold)
+					continue;
+
+				pressure = true;
+				VkDeviceSize target {static_cast<VkDeviceSize> (static_cast<double> (heapBudget.budget) * m_parameters.evictionTarget)};
+				std::list<vkpp::ResidentResource> &resources {m_resources[heap]};
+
+				while (usage > target && !resources.empty())
+				{
+					// least recently used first, so the first busy resource means every other one is busy too
+					vkpp::ResidentResource &resource {resources.front()};
+					if (resource.lastUsedFrame + m_parameters.minimumIdleFrames > frameNumber)
+						break;
+
+					usage -= std::min(usage, resource.size);
+					m_pending.push_back({frameNumber, heap, resource.size});
+					m_residentBytes[heap] -= resource.size;
+					++m_statistics.evictedCount;
+					m_statistics.evictedBytes += resource.size;
+
+					evictors.push_back(std::move(resource.evictor));
+					m_locations.erase(resource.handle);
+					resources.pop_front();
+				}
+
+				starved |= usage > target;
+			}
+
+			if (pressure)
+				++m_statistics.pressureFrameCount;
+
+			if (starved)
+				++m_statistics.starvedFrameCount;
+		}
+
+		// outside the lock, evictors usually retire their resource or register a demoted copy of it
+		for (auto &evictor : evictors)
+			evictor();
+	}
+
+
+
+	void ResidencyManager::resetStatistics() noexcept
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_statistics = {};
+	}
+
+
+
+	VkDeviceSize ResidencyManager::getResidentBytes(uint32_t heap)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return m_residentBytes[heap];
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,170 @@
+#include <stdexcept>
+
+#include "resourceAccess.hpp"
+
+
+
+namespace vkpp
+{
+	vkpp::UsageAccess getUsageAccess(vkpp::ResourceUsage usage)
+	{
+		switch (usage)
+		{
+			case vkpp::ResourceUsage::colorAttachment:
+				return {
+					VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+					VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+					VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0
+				};
+
+			case vkpp::ResourceUsage::depthAttachment:
+				return {
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+					VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0
+				};
+
+			case vkpp::ResourceUsage::sampled:
+				return {
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_ACCESS_SHADER_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT
+				};
+
+			case vkpp::ResourceUsage::storage:
+				return {
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+				};
+
+			case vkpp::ResourceUsage::transferSource:
+				return {
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_ACCESS_TRANSFER_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+				};
+
+			case vkpp::ResourceUsage::transferDestination:
+				return {
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					0, VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT
+				};
+
+			case vkpp::ResourceUsage::uniform:
+				return {
+					VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_ACCESS_UNIFORM_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+				};
+
+			case vkpp::ResourceUsage::vertex:
+				return {
+					VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+					VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+				};
+
+			case vkpp::ResourceUsage::index:
+				return {
+					VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+					VK_ACCESS_INDEX_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+				};
+
+			case vkpp::ResourceUsage::indirect:
+				return {
+					VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+					VK_ACCESS_INDIRECT_COMMAND_READ_BIT, 0,
+					VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+				};
+
+			case vkpp::ResourceUsage::present:
+				return {
+					VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+					0, 0,
+					VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 0
+				};
+		}
+
+		throw std::runtime_error("VKPP : Unknown resource usage");
+	}
+
+
+
+	vkpp::AccessRequest getAccessRequest(vkpp::ResourceUsage usage, bool write)
+	{
+		vkpp::UsageAccess access {vkpp::getUsageAccess(usage)};
+		return {access.stages, write ? 0 : access.readAccess, write ? access.writeAccess : 0, access.layout};
+	}
+
+
+
+	bool transitionAccess(vkpp::AccessState &state, const vkpp::AccessRequest &request, bool image, vkpp::AccessBarrier &barrier)
+	{
+		bool layoutChange {image && state.layout != request.layout};
+
+		if (layoutChange || request.writeAccess != 0)
+		{
+			// writes and layout transitions wait for every earlier access, reads only need an execution dependency
+			barrier = {
+				state.writeStages | state.readStages, state.writeAccess,
+				request.stages, request.readAccess | request.writeAccess,
+				state.layout, image ? request.layout : VK_IMAGE_LAYOUT_UNDEFINED
+			};
+
+			if (barrier.srcStages == 0)
+				barrier.srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+			state = vkpp::getStateAfter(request, image);
+			return true;
+		}
+
+		state.readStages |= request.stages;
+
+		if (state.writeStages == 0
+			|| ((request.stages & ~state.visibleStages) == 0 && (request.readAccess & ~state.visibleAccess) == 0))
+			return false;
+
+		barrier = {state.writeStages, state.writeAccess, request.stages, request.readAccess, state.layout, state.layout};
+		state.visibleStages |= request.stages;
+		state.visibleAccess |= request.readAccess;
+		return true;
+	}
+
+
+
+	vkpp::AccessState getStateAfter(const vkpp::AccessRequest &request, bool image)
+	{
+		// a layout transition is a write made visible to the requesting stages
+		return {
+			request.stages, request.writeAccess,
+			request.writeAccess != 0 ? 0 : request.stages,
+			request.stages, request.readAccess | request.writeAccess,
+			image ? request.layout : VK_IMAGE_LAYOUT_UNDEFINED
+		};
+	}
+
+
+
+	VkImageAspectFlags getImageAspect(VkFormat format)
+	{
+		switch (format)
+		{
+			case VK_FORMAT_D16_UNORM:
+			case VK_FORMAT_D32_SFLOAT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+			default:
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include "scheduler.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	namespace
+	{
+		// the arrays one VkSubmitInfo points to, kept alive until vkQueueSubmit returns
+		struct SubmitStorage
+		{
+			std::vector<VkSemaphore> waitSemaphores;
+			std::vector<uint64_t> waitValues;
+			std::vector<VkPipelineStageFlags> waitStages;
+			std::vector<VkSemaphore> signalSemaphores;
+			std::vector<uint64_t> signalValues;
+			VkTimelineSemaphoreSubmitInfo timelineInfo;
+		};
+	}
+
+
+
+	Scheduler::Scheduler(vkpp::Device &device) :
+		m_device {device},
+		m_timelines {},
+		m_statistics {}
+	{
+		VkSemaphoreTypeCreateInfo typeCreateInfo {};
+		typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeCreateInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo {};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreCreateInfo.pNext = &typeCreateInfo;
+
+		for (const auto &queue : m_device.getQueues())
+		{
+			// present only runs vkQueuePresentKHR, which can't signal a timeline
+			if (queue.first == vkpp::QueueType::present)
+				continue;
+
+			vkpp::Timeline timeline {};
+			if (m_device.getDispatch().vkCreateSemaphore(m_device.get(), &semaphoreCreateInfo, nullptr, &timeline.semaphore) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create a timeline semaphore");
+
+			m_timelines[queue.first] = std::move(timeline);
+		}
+	}
+
+
+
+	Scheduler::~Scheduler()
+	{
+		this->waitIdle();
+
+		for (auto &timeline : m_timelines)
+			m_device.getDispatch().vkDestroySemaphore(m_device.get(), timeline.second.semaphore, nullptr);
+	}
+
+
+
+	vkpp::TimelinePoint Scheduler::submit(vkpp::QueueType queue, vkpp::ScheduledSubmit submit)
+	{
+		if (submit.waitSemaphores.size() != submit.waitStages.size())
+			throw std::runtime_error("VKPP : Scheduled submits need one wait stage per binary semaphore");
+
+		vkpp::Timeline &timeline {s_getTimeline(queue)};
+		timeline.pending.push_back(std::move(submit));
+		++m_statistics.submitCount;
+		return {queue, ++timeline.lastValue};
+	}
+
+
+
+	void Scheduler::flush()
+	{
+		for (auto &timeline : m_timelines)
+			this->flush(timeline.first);
+	}
+
+
+
+	void Scheduler::flush(vkpp::QueueType queue, VkFence fence)
+	{
+		vkpp::Timeline &timeline {s_getTimeline(queue)};
+
+		// a queue already being flushed waits on this one : the cycle is left to wait-before-signal
+		if (timeline.flushing)
+			return;
+
+		if (timeline.pending.empty())
+		{
+			if (fence != VK_NULL_HANDLE && m_device.getDispatch().vkQueueSubmit(m_device.getQueue(queue), 0, nullptr, fence) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't submit a fence");
+			return;
+		}
+
+		timeline.flushing = true;
+
+		std::vector<SubmitStorage> storages (timeline.pending.size());
+		std::vector<VkSubmitInfo> submitInfos (timeline.pending.size());
+		uint64_t value {timeline.submittedValue};
+
+		for (size_t i {0}; i < timeline.pending.size(); i++)
+		{
+			vkpp::ScheduledSubmit &submit {timeline.pending[i]};
+			SubmitStorage &storage {storages[i]};
+
+			// only the highest point of each timeline needs waiting on, and none that the GPU already reached
+			std::map<vkpp::QueueType, std::pair<uint64_t, VkPipelineStageFlags>> waits {};
+			for (const auto &wait : submit.waits)
+			{
+				auto &merged {waits[wait.point.queue]};
+				if (merged.first != 0)
+					++m_statistics.skippedWaitCount;
+				merged.first = std::max(merged.first, wait.point.value);
+				merged.second |= wait.stage;
+			}
+
+			for (const auto &wait : waits)
+			{
+				vkpp::Timeline &waited {s_getTimeline(wait.first)};
+				if (wait.second.first <= waited.completedValue)
+				{
+					++m_statistics.skippedWaitCount;
+					continue;
+				}
+
+				// the signaling submit goes first, so that the driver never holds a wait-before-signal
+				if (wait.first != queue && wait.second.first > waited.submittedValue)
+					this->flush(wait.first);
+
+				storage.waitSemaphores.push_back(waited.semaphore);
+				storage.waitValues.push_back(wait.second.first);
+				storage.waitStages.push_back(wait.second.second);
+			}
+
+			for (size_t j {0}; j < submit.waitSemaphores.size(); j++)
+			{
+				storage.waitSemaphores.push_back(submit.waitSemaphores[j]);
+				storage.waitValues.push_back(0);
+				storage.waitStages.push_back(submit.waitStages[j]);
+			}
+
+			storage.signalSemaphores.push_back(timeline.semaphore);
+			storage.signalValues.push_back(++value);
+
+			for (auto semaphore : submit.signalSemaphores)
+			{
+				storage.signalSemaphores.push_back(semaphore);
+				storage.signalValues.push_back(0);
+			}
+
+			storage.timelineInfo = {};
+			storage.timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			storage.timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t> (storage.waitValues.size());
+			storage.timelineInfo.pWaitSemaphoreValues = storage.waitValues.data();
+			storage.timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t> (storage.signalValues.size());
+			storage.timelineInfo.pSignalSemaphoreValues = storage.signalValues.data();
+
+			VkSubmitInfo &submitInfo {submitInfos[i]};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.pNext = &storage.timelineInfo;
+			submitInfo.waitSemaphoreCount = static_cast<uint32_t> (storage.waitSemaphores.size());
+			submitInfo.pWaitSemaphores = storage.waitSemaphores.data();
+			submitInfo.pWaitDstStageMask = storage.waitStages.data();
+			submitInfo.commandBufferCount = static_cast<uint32_t> (submit.commandBuffers.size());
+			submitInfo.pCommandBuffers = submit.commandBuffers.data();
+			submitInfo.signalSemaphoreCount = static_cast<uint32_t> (storage.signalSemaphores.size());
+			submitInfo.pSignalSemaphores = storage.signalSemaphores.data();
+		}
+
+		VkResult result {m_device.getDispatch().vkQueueSubmit(
+			m_device.getQueue(queue), static_cast<uint32_t> (submitInfos.size()), submitInfos.data(), fence
+		)};
+
+		timeline.flushing = false;
+
+		if (result != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't submit " + std::to_string(submitInfos.size()) + " scheduled submits");
+
+		timeline.submittedValue = value;
+		timeline.pending.clear();
+		++m_statistics.batchCount;
+	}
+
+
+
+	bool Scheduler::isComplete(const vkpp::TimelinePoint &point)
+	{
+		if (point.value <= s_getTimeline(point.queue).completedValue)
+			return true;
+
+		return point.value <= this->getCompletedValue(point.queue);
+	}
+
+
+
+	bool Scheduler::wait(const vkpp::TimelinePoint &point, uint64_t timeout)
+	{
+		return this->wait(std::vector<vkpp::TimelinePoint> {point}, true, timeout);
+	}
+
+
+
+	bool Scheduler::wait(const std::vector<vkpp::TimelinePoint> &points, bool waitAll, uint64_t timeout)
+	{
+		std::vector<VkSemaphore> semaphores {};
+		std::vector<uint64_t> values {};
+		semaphores.reserve(points.size());
+		values.reserve(points.size());
+
+		for (const auto &point : points)
+		{
+			vkpp::Timeline &timeline {s_getTimeline(point.queue)};
+			if (point.value > timeline.lastValue)
+				throw std::runtime_error("VKPP : Can't wait for a timeline value that was never submitted");
+
+			if (point.value <= timeline.completedValue)
+			{
+				if (!waitAll)
+					return true;
+				continue;
+			}
+
+			if (point.value > timeline.submittedValue)
+				this->flush(point.queue);
+
+			semaphores.push_back(timeline.semaphore);
+			values.push_back(point.value);
+		}
+
+		if (semaphores.empty())
+			return true;
+
+		VkSemaphoreWaitInfo waitInfo {};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.flags = waitAll ? 0 : VK_SEMAPHORE_WAIT_ANY_BIT;
+		waitInfo.semaphoreCount = static_cast<uint32_t> (semaphores.size());
+		waitInfo.pSemaphores = semaphores.data();
+		waitInfo.pValues = values.data();
+
+		auto start {std::chrono::steady_clock::now()};
+		VkResult result {m_device.getDispatch().vkWaitSemaphores(m_device.get(), &waitInfo, timeout)};
+		m_statistics.hostWaitTime += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+		++m_statistics.hostWaitCount;
+
+		if (result == VK_TIMEOUT)
+			return false;
+
+		if (result != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't wait for timeline semaphores");
+
+		if (waitAll)
+		{
+			for (const auto &point : points)
+			{
+				vkpp::Timeline &timeline {s_getTimeline(point.queue)};
+				timeline.completedValue = std::max(timeline.completedValue, point.value);
+			}
+		}
+
+		return true;
+	}
+
+
+
+	void Scheduler::waitIdle()
+	{
+		std::vector<vkpp::TimelinePoint> points {};
+		for (const auto &timeline : m_timelines)
+			points.push_back({timeline.first, timeline.second.lastValue});
+
+		this->wait(points);
+	}
+
+
+
+	uint64_t Scheduler::getCompletedValue(vkpp::QueueType queue)
+	{
+		vkpp::Timeline &timeline {s_getTimeline(queue)};
+
+		uint64_t value {0};
+		if (m_device.getDispatch().vkGetSemaphoreCounterValue(m_device.get(), timeline.semaphore, &value) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't get a timeline semaphore value");
+
+		timeline.completedValue = std::max(timeline.completedValue, value);
+		return timeline.completedValue;
+	}
+
+
+
+	void Scheduler::resetStatistics() noexcept
+	{
+		m_statistics = {};
+	}
+
+
+
+	vkpp::Timeline &Scheduler::s_getTimeline(vkpp::QueueType queue)
+	{
+		auto timeline {m_timelines.find(queue)};
+		if (timeline == m_timelines.end())
+			throw std::runtime_error("VKPP : Can't schedule work on a queue without timeline");
+
+		return timeline->second;
+	}
+
+
+
+} // namespace vkpp
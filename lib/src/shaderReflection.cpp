@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "shaderReflection.hpp"
+
+
+
+namespace vkpp
+{
+	vkpp::ShaderReflection reflectSpirv(std::span<const uint32_t> code)
+	{
+		constexpr uint32_t SPIRV_MAGIC {0x07230203};
+		constexpr uint32_t SPIRV_HEADER_SIZE {5};
+
+		constexpr uint32_t OP_ENTRY_POINT {15};
+		constexpr uint32_t OP_TYPE_BOOL {20};
+		constexpr uint32_t OP_TYPE_INT {21};
+		constexpr uint32_t OP_TYPE_FLOAT {22};
+		constexpr uint32_t OP_TYPE_VECTOR {23};
+		constexpr uint32_t OP_TYPE_MATRIX {24};
+		constexpr uint32_t OP_TYPE_IMAGE {25};
+		constexpr uint32_t OP_TYPE_SAMPLER {26};
+		constexpr uint32_t OP_TYPE_SAMPLED_IMAGE {27};
+		constexpr uint32_t OP_TYPE_ARRAY {28};
+		constexpr uint32_t OP_TYPE_RUNTIME_ARRAY {29};
+		constexpr uint32_t OP_TYPE_STRUCT {30};
+		constexpr uint32_t OP_TYPE_POINTER {32};
+		constexpr uint32_t OP_CONSTANT {43};
+		constexpr uint32_t OP_SPEC_CONSTANT {50};
+		constexpr uint32_t OP_VARIABLE {59};
+		constexpr uint32_t OP_DECORATE {71};
+		constexpr uint32_t OP_MEMBER_DECORATE {72};
+		constexpr uint32_t OP_TYPE_ACCELERATION_STRUCTURE {5341};
+
+		constexpr uint32_t DECORATION_BUFFER_BLOCK {3};
+		constexpr uint32_t DECORATION_ARRAY_STRIDE {6};
+		constexpr uint32_t DECORATION_MATRIX_STRIDE {7};
+		constexpr uint32_t DECORATION_BUILT_IN {11};
+		constexpr uint32_t DECORATION_LOCATION {30};
+		constexpr uint32_t DECORATION_BINDING {33};
+		constexpr uint32_t DECORATION_DESCRIPTOR_SET {34};
+		constexpr uint32_t DECORATION_OFFSET {35};
+
+		constexpr uint32_t STORAGE_CLASS_INPUT {1};
+		constexpr uint32_t STORAGE_CLASS_UNIFORM {2};
+		constexpr uint32_t STORAGE_CLASS_PUSH_CONSTANT {9};
+		constexpr uint32_t STORAGE_CLASS_STORAGE_BUFFER {12};
+
+		constexpr uint32_t DIM_BUFFER {5};
+		constexpr uint32_t DIM_SUBPASS_DATA {6};
+		constexpr uint32_t NONE {std::numeric_limits<uint32_t>::max()};
+
+		if (code.size() < SPIRV_HEADER_SIZE || code[0] != SPIRV_MAGIC)
+			throw std::runtime_error("VKPP : Can't reflect a shader that isn't SPIR-V");
+
+		// a type or constant instruction's operands, its result id excluded
+		struct Type
+		{
+			uint32_t opcode;
+			std::span<const uint32_t> operands;
+		};
+
+		struct Decorations
+		{
+			uint32_t set {NONE};
+			uint32_t binding {NONE};
+			uint32_t location {NONE};
+			uint32_t arrayStride {0};
+			bool builtIn {false};
+			bool bufferBlock {false};
+			std::unordered_map<uint32_t, uint32_t> memberOffsets {};
+			std::unordered_map<uint32_t, uint32_t> memberMatrixStrides {};
+		};
+
+		struct Variable
+		{
+			uint32_t id;
+			uint32_t pointer;
+			uint32_t storageClass;
+		};
+
+		std::unordered_map<uint32_t, Type> types {};
+		std::unordered_map<uint32_t, Decorations> decorations {};
+		std::vector<Variable> variables {};
+		std::unordered_set<uint32_t> interface {};
+		uint32_t executionModel {NONE};
+		vkpp::ShaderReflection reflection {};
+
+		for (size_t i {SPIRV_HEADER_SIZE}; i < code.size();)
+		{
+			uint32_t wordCount {code[i] >> 16};
+			uint32_t opcode {code[i] & 0xffff};
+
+			if (wordCount == 0 || i + wordCount > code.size())
+				throw std::runtime_error("VKPP : Can't reflect SPIR-V, instruction at word " + std::to_string(i) + " is truncated");
+
+			std::span<const uint32_t> operands {code.subspan(i + 1, wordCount - 1)};
+			i += wordCount;
+
+			switch (opcode)
+			{
+				case OP_ENTRY_POINT:
+				{
+					if (operands.size() < 3)
+						break;
+
+					// the globals of a module aren't tied to an entry point, those of several would be credited to one
+					if (executionModel != NONE)
+						throw std::runtime_error("VKPP : Can't reflect SPIR-V with several entry points, compile one module per stage");
+
+					executionModel = operands[0];
+					reflection.entryPoint = std::string(
+						reinterpret_cast<const char*> (operands.data() + 2),
+						strnlen(reinterpret_cast<const char*> (operands.data() + 2), (operands.size() - 2) * sizeof(uint32_t))
+					);
+
+					// the name's words, its terminating null included, are followed by the interface's variables
+					size_t interfaceStart {std::min<size_t> (2 + reflection.entryPoint.size() / sizeof(uint32_t) + 1, operands.size())};
+					interface.insert(operands.begin() + static_cast<std::ptrdiff_t> (interfaceStart), operands.end());
+					break;
+				}
+
+				case OP_DECORATE:
+				{
+					if (operands.size() < 2)
+						break;
+
+					Decorations &target {decorations[operands[0]]};
+					uint32_t literal {operands.size() > 2 ? operands[2] : 0};
+
+					switch (operands[1])
+					{
+						case DECORATION_BUFFER_BLOCK: target.bufferBlock = true; break;
+						case DECORATION_ARRAY_STRIDE: target.arrayStride = literal; break;
+						case DECORATION_BUILT_IN: target.builtIn = true; break;
+						case DECORATION_LOCATION: target.location = literal; break;
+						case DECORATION_BINDING: target.binding = literal; break;
+						case DECORATION_DESCRIPTOR_SET: target.set = literal; break;
+						default: break;
+					}
+					break;
+				}
+
+				case OP_MEMBER_DECORATE:
+				{
+					if (operands.size() < 3)
+						break;
+
+					Decorations &target {decorations[operands[0]]};
+					uint32_t literal {operands.size() > 3 ? operands[3] : 0};
+
+					if (operands[2] == DECORATION_OFFSET)
+						target.memberOffsets[operands[1]] = literal;
+					else if (operands[2] == DECORATION_MATRIX_STRIDE)
+						target.memberMatrixStrides[operands[1]] = literal;
+					break;
+				}
+
+				case OP_TYPE_BOOL:
+				case OP_TYPE_INT:
+				case OP_TYPE_FLOAT:
+				case OP_TYPE_VECTOR:
+				case OP_TYPE_MATRIX:
+				case OP_TYPE_IMAGE:
+				case OP_TYPE_SAMPLER:
+				case OP_TYPE_SAMPLED_IMAGE:
+				case OP_TYPE_ARRAY:
+				case OP_TYPE_RUNTIME_ARRAY:
+				case OP_TYPE_STRUCT:
+				case OP_TYPE_POINTER:
+				case OP_TYPE_ACCELERATION_STRUCTURE:
+					if (!operands.empty())
+						types[operands[0]] = {opcode, operands.subspan(1)};
+					break;
+
+				// the result type first, then the result id. Specialization constants count with their default value
+				case OP_CONSTANT:
+				case OP_SPEC_CONSTANT:
+					if (operands.size() >= 3)
+						types[operands[1]] = {opcode, operands.subspan(2)};
+					break;
+
+				case OP_VARIABLE:
+					if (operands.size() >= 3)
+						variables.push_back({operands[1], operands[0], operands[2]});
+					break;
+
+				default:
+					break;
+			}
+		}
+
+
+		switch (executionModel)
+		{
+			case 0: reflection.stage = VK_SHADER_STAGE_VERTEX_BIT; break;
+			case 1: reflection.stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; break;
+			case 2: reflection.stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; break;
+			case 3: reflection.stage = VK_SHADER_STAGE_GEOMETRY_BIT; break;
+			case 4: reflection.stage = VK_SHADER_STAGE_FRAGMENT_BIT; break;
+			case 5: reflection.stage = VK_SHADER_STAGE_COMPUTE_BIT; break;
+			default:
+				throw std::runtime_error("VKPP : Can't reflect SPIR-V of execution model " + std::to_string(executionModel));
+		}
+
+		auto getType = [&types](uint32_t id) -> const Type& {
+			auto found {types.find(id)};
+			if (found == types.end())
+				throw std::runtime_error("VKPP : Can't reflect SPIR-V, type " + std::to_string(id) + " is undefined");
+
+			return found->second;
+		};
+
+		auto getDecorations = [&decorations](uint32_t id) -> const Decorations& {
+			static const Decorations none {};
+			auto found {decorations.find(id)};
+			return found == decorations.end() ? none : found->second;
+		};
+
+		// std140 / std430 byte size, as the decorations laid the type out
+		auto getSize = [&](auto &self, uint32_t id) -> uint32_t {
+			const Type &type {getType(id)};
+
+			switch (type.opcode)
+			{
+				case OP_TYPE_BOOL: return 4;
+				case OP_TYPE_INT:
+				case OP_TYPE_FLOAT: return type.operands[0] / 8;
+				case OP_TYPE_VECTOR:
+				case OP_TYPE_MATRIX: return type.operands[1] * self(self, type.operands[0]);
+
+				case OP_TYPE_ARRAY:
+				{
+					uint32_t stride {getDecorations(id).arrayStride};
+					uint32_t length {getType(type.operands[1]).operands[0]};
+					return length * (stride != 0 ? stride : self(self, type.operands[0]));
+				}
+
+				case OP_TYPE_STRUCT:
+				{
+					const Decorations &members {getDecorations(id)};
+					uint32_t size {0};
+
+					for (uint32_t member {0}; member < type.operands.size(); member++)
+					{
+						auto offset {members.memberOffsets.find(member)};
+						auto matrixStride {members.memberMatrixStrides.find(member)};
+						const Type &memberType {getType(type.operands[member])};
+
+						uint32_t memberSize {matrixStride != members.memberMatrixStrides.end() && memberType.opcode == OP_TYPE_MATRIX
+							? memberType.operands[1] * matrixStride->second
+							: self(self, type.operands[member])};
+
+						size = std::max(size, (offset == members.memberOffsets.end() ? size : offset->second) + memberSize);
+					}
+
+					return size;
+				}
+
+				default: return 0;
+			}
+		};
+
+		auto getFormat = [&](uint32_t id) -> VkFormat {
+			const Type *type {&getType(id)};
+			uint32_t components {1};
+
+			if (type->opcode == OP_TYPE_VECTOR)
+			{
+				components = type->operands[1];
+				type = &getType(type->operands[0]);
+			}
+
+			if (components < 1 || components > 4 || type->operands.empty() || type->operands[0] != 32)
+				return VK_FORMAT_UNDEFINED;
+
+			constexpr VkFormat FLOATS[] {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+			constexpr VkFormat SIGNED[] {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+			constexpr VkFormat UNSIGNED[] {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+
+			if (type->opcode == OP_TYPE_FLOAT)
+				return FLOATS[components - 1];
+
+			if (type->opcode == OP_TYPE_INT)
+				return type->operands[1] != 0 ? SIGNED[components - 1] : UNSIGNED[components - 1];
+
+			return VK_FORMAT_UNDEFINED;
+		};
+
+
+		for (const auto &variable : variables)
+		{
+			const Type &pointer {getType(variable.pointer)};
+			if (pointer.opcode != OP_TYPE_POINTER || pointer.operands.size() < 2)
+				continue;
+
+			uint32_t typeId {pointer.operands[1]};
+			const Decorations &variableDecorations {getDecorations(variable.id)};
+
+			if (variable.storageClass == STORAGE_CLASS_PUSH_CONSTANT)
+			{
+				const Decorations &members {getDecorations(typeId)};
+				uint32_t offset {members.memberOffsets.empty() ? 0 : std::numeric_limits<uint32_t>::max()};
+				for (const auto &member : members.memberOffsets)
+					offset = std::min(offset, member.second);
+
+				// the range starts at the block's first member, so that stages can share the block in slices
+				uint32_t size {getSize(getSize, typeId)};
+				if (size > offset)
+					reflection.pushConstants.push_back({static_cast<VkShaderStageFlags> (reflection.stage), offset, size - offset});
+				continue;
+			}
+
+			if (variable.storageClass == STORAGE_CLASS_INPUT)
+			{
+				if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || !interface.contains(variable.id)
+					|| variableDecorations.builtIn || variableDecorations.location == NONE)
+					continue;
+
+				reflection.vertexInputs.push_back({variableDecorations.location, getFormat(typeId)});
+				continue;
+			}
+
+			if (variableDecorations.set == NONE || variableDecorations.binding == NONE)
+				continue;
+
+			// arrays of descriptors multiply their lengths, a runtime sized one makes the whole binding unbounded
+			uint32_t count {1};
+			const Type *type {&getType(typeId)};
+
+			while (type->opcode == OP_TYPE_ARRAY || type->opcode == OP_TYPE_RUNTIME_ARRAY)
+			{
+				count = type->opcode == OP_TYPE_RUNTIME_ARRAY ? 0 : count * getType(type->operands[1]).operands[0];
+				typeId = type->operands[0];
+				type = &getType(typeId);
+			}
+
+			VkDescriptorType descriptorType {};
+
+			switch (type->opcode)
+			{
+				case OP_TYPE_SAMPLER:
+					descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+					break;
+
+				case OP_TYPE_SAMPLED_IMAGE:
+					descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					break;
+
+				// sampled type, dim, depth, arrayed, multisampled, sampled, format
+				case OP_TYPE_IMAGE:
+					if (type->operands[1] == DIM_BUFFER)
+						descriptorType = type->operands[5] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					else if (type->operands[1] == DIM_SUBPASS_DATA)
+						descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					else
+						descriptorType = type->operands[5] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					break;
+
+				case OP_TYPE_STRUCT:
+					if (variable.storageClass == STORAGE_CLASS_STORAGE_BUFFER
+						|| (variable.storageClass == STORAGE_CLASS_UNIFORM && getDecorations(typeId).bufferBlock))
+						descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					else
+						descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					break;
+
+				case OP_TYPE_ACCELERATION_STRUCTURE:
+					descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+					break;
+
+				default:
+					throw std::runtime_error(
+						"VKPP : Can't reflect the descriptor type of set " + std::to_string(variableDecorations.set)
+						+ " binding " + std::to_string(variableDecorations.binding)
+					);
+			}
+
+			reflection.bindings.push_back({variableDecorations.set, variableDecorations.binding, descriptorType, count});
+		}
+
+		std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto &first, const auto &second) {
+			return first.set != second.set ? first.set < second.set : first.binding < second.binding;
+		});
+
+		std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const auto &first, const auto &second) {
+			return first.location < second.location;
+		});
+
+		return reflection;
+	}
+
+
+
+	void saveShaderReflection(const std::filesystem::path &path, const vkpp::ShaderReflection &reflection, uint64_t codeHash)
+	{
+		vkpp::ShaderReflectionFileHeader header {};
+		header.magic = vkpp::SHADER_REFLECTION_FILE_MAGIC;
+		header.version = vkpp::SHADER_REFLECTION_FILE_VERSION;
+		header.codeHash = codeHash;
+		header.stage = static_cast<uint32_t> (reflection.stage);
+		header.entryPointSize = static_cast<uint32_t> (reflection.entryPoint.size());
+		header.bindingCount = static_cast<uint32_t> (reflection.bindings.size());
+		header.pushConstantCount = static_cast<uint32_t> (reflection.pushConstants.size());
+		header.vertexInputCount = static_cast<uint32_t> (reflection.vertexInputs.size());
+
+		std::filesystem::path temporary {path};
+		temporary += ".tmp";
+
+		{
+			std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+			file.write(reinterpret_cast<const char*> (&header), sizeof(header));
+			file.write(reflection.entryPoint.data(), static_cast<std::streamsize> (reflection.entryPoint.size()));
+			file.write(
+				reinterpret_cast<const char*> (reflection.bindings.data()),
+				static_cast<std::streamsize> (reflection.bindings.size() * sizeof(vkpp::ReflectedBinding))
+			);
+			file.write(
+				reinterpret_cast<const char*> (reflection.pushConstants.data()),
+				static_cast<std::streamsize> (reflection.pushConstants.size() * sizeof(VkPushConstantRange))
+			);
+			file.write(
+				reinterpret_cast<const char*> (reflection.vertexInputs.data()),
+				static_cast<std::streamsize> (reflection.vertexInputs.size() * sizeof(vkpp::ReflectedVertexInput))
+			);
+
+			if (!file)
+				throw std::runtime_error("VKPP : Can't write shader reflection to " + temporary.string());
+		}
+
+		std::error_code error {};
+		std::filesystem::rename(temporary, path, error);
+		if (error)
+			throw std::runtime_error("VKPP : Can't replace shader reflection " + path.string() + " : " + error.message());
+	}
+
+
+
+	std::optional<vkpp::ShaderReflection> loadShaderReflection(const std::filesystem::path &path, uint64_t codeHash)
+	{
+		std::ifstream file {path, std::ios::binary};
+		if (!file)
+			return std::nullopt;
+
+		vkpp::ShaderReflectionFileHeader header {};
+		if (!file.read(reinterpret_cast<char*> (&header), sizeof(header))
+			|| header.magic != vkpp::SHADER_REFLECTION_FILE_MAGIC
+			|| header.version != vkpp::SHADER_REFLECTION_FILE_VERSION
+			|| header.codeHash != codeHash)
+			return std::nullopt;
+
+		// counts bounded by the file's size, so that a corrupted header doesn't allocate gigabytes
+		std::error_code error {};
+		uintmax_t fileSize {std::filesystem::file_size(path, error)};
+		uintmax_t expectedSize {sizeof(header) + uintmax_t {header.entryPointSize}
+			+ uintmax_t {header.bindingCount} * sizeof(vkpp::ReflectedBinding)
+			+ uintmax_t {header.pushConstantCount} * sizeof(VkPushConstantRange)
+			+ uintmax_t {header.vertexInputCount} * sizeof(vkpp::ReflectedVertexInput)};
+
+		if (error || fileSize != expectedSize)
+			return std::nullopt;
+
+		vkpp::ShaderReflection reflection {};
+		reflection.stage = static_cast<VkShaderStageFlagBits> (header.stage);
+		reflection.entryPoint.resize(header.entryPointSize);
+		reflection.bindings.resize(header.bindingCount);
+		reflection.pushConstants.resize(header.pushConstantCount);
+		reflection.vertexInputs.resize(header.vertexInputCount);
+
+		file.read(reflection.entryPoint.data(), static_cast<std::streamsize> (reflection.entryPoint.size()));
+		file.read(
+			reinterpret_cast<char*> (reflection.bindings.data()),
+			static_cast<std::streamsize> (reflection.bindings.size() * sizeof(vkpp::ReflectedBinding))
+		);
+		file.read(
+			reinterpret_cast<char*> (reflection.pushConstants.data()),
+			static_cast<std::streamsize> (reflection.pushConstants.size() * sizeof(VkPushConstantRange))
+		);
+		file.read(
+			reinterpret_cast<char*> (reflection.vertexInputs.data()),
+			static_cast<std::streamsize> (reflection.vertexInputs.size() * sizeof(vkpp::ReflectedVertexInput))
+		);
+
+		if (!file)
+			return std::nullopt;
+
+		return reflection;
+	}
+
+
+
+} // namespace vkpp
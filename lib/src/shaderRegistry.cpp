@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "device.hpp"
+#include "shaderRegistry.hpp"
+#include "utils/hash.hpp"
+
+
+
+namespace vkpp
+{
+	uint64_t PipelineLayoutDescription::hash() const noexcept
+	{
+		uint64_t seed {vkpp::utils::FNV_OFFSET_BASIS};
+
+		for (auto layout : setLayouts)
+			vkpp::utils::hashCombine(seed, layout);
+
+		for (const auto &range : pushConstants)
+		{
+			vkpp::utils::hashCombine(seed, static_cast<uint32_t> (range.stageFlags));
+			vkpp::utils::hashCombine(seed, range.offset);
+			vkpp::utils::hashCombine(seed, range.size);
+		}
+
+		return seed;
+	}
+
+
+
+	bool PipelineLayoutDescription::operator==(const vkpp::PipelineLayoutDescription &other) const noexcept
+	{
+		return setLayouts == other.setLayouts && std::equal(
+			pushConstants.begin(), pushConstants.end(), other.pushConstants.begin(), other.pushConstants.end(),
+			[](const VkPushConstantRange &first, const VkPushConstantRange &second) {
+				return first.stageFlags == second.stageFlags && first.offset == second.offset && first.size == second.size;
+			}
+		);
+	}
+
+
+
+	ShaderRegistry::ShaderRegistry(vkpp::Device &device) :
+		m_device {device},
+		m_mutex {},
+		m_shaders {},
+		m_externalLayouts {},
+		m_pipelineLayouts {},
+		m_statistics {}
+	{
+
+	}
+
+
+
+	ShaderRegistry::~ShaderRegistry()
+	{
+		for (const auto &layout : m_pipelineLayouts)
+			m_device.getDispatch().vkDestroyPipelineLayout(m_device.get(), layout.second, nullptr);
+
+		for (const auto &shader : m_shaders)
+			m_device.getDispatch().vkDestroyShaderModule(m_device.get(), shader.second.module, nullptr);
+	}
+
+
+
+	const vkpp::Shader &ShaderRegistry::load(const std::filesystem::path &path)
+	{
+		std::ifstream file {path, std::ios::binary | std::ios::ate};
+		if (!file)
+			throw std::runtime_error("VKPP : Can't open shader " + path.string());
+
+		size_t size {static_cast<size_t> (file.tellg())};
+		if (size == 0 || size % sizeof(uint32_t) != 0)
+			throw std::runtime_error("VKPP : Shader " + path.string() + " isn't SPIR-V, its size isn't a whole number of words");
+
+		std::vector<uint32_t> code (size / sizeof(uint32_t));
+		file.seekg(0);
+		if (!file.read(reinterpret_cast<char*> (code.data()), static_cast<std::streamsize> (size)))
+			throw std::runtime_error("VKPP : Can't read shader " + path.string());
+
+		std::filesystem::path reflectionPath {path};
+		reflectionPath += ".reflect";
+		return s_load(code, reflectionPath);
+	}
+
+
+
+	const vkpp::Shader &ShaderRegistry::load(std::span<const uint32_t> code)
+	{
+		return s_load(code, {});
+	}
+
+
+
+	vkpp::ShaderLayout ShaderRegistry::getLayout(std::span<const vkpp::Shader* const> shaders)
+	{
+		// bindings of a same set and number merge their stages, sorted so that the key doesn't depend on the stages' order
+		std::map<uint32_t, std::map<uint32_t, vkpp::DescriptorBindingDescription>> sets {};
+		std::vector<VkPushConstantRange> pushConstants {};
+
+		for (const auto *shader : shaders)
+		{
+			for (const auto &binding : shader->reflection.bindings)
+			{
+				auto [description, inserted] {sets[binding.set].try_emplace(
+					binding.binding, vkpp::DescriptorBindingDescription {binding.binding, binding.type, binding.count, 0}
+				)};
+
+				if (!inserted && description->second.type != binding.type)
+				{
+					throw std::runtime_error(
+						"VKPP : Stages disagree on the descriptor type of set " + std::to_string(binding.set)
+						+ " binding " + std::to_string(binding.binding)
+					);
+				}
+
+				description->second.stages |= shader->reflection.stage;
+				if (binding.count == 0 || description->second.count == 0)
+					description->second.count = 0;
+				else
+					description->second.count = std::max(description->second.count, binding.count);
+			}
+
+			// stages sharing a block share a range
+			for (const auto &range : shader->reflection.pushConstants)
+			{
+				auto found {std::find_if(pushConstants.begin(), pushConstants.end(), [&range](const VkPushConstantRange &other) {
+					return other.offset == range.offset && other.size == range.size;
+				})};
+
+				if (found != pushConstants.end())
+					found->stageFlags |= range.stageFlags;
+				else
+					pushConstants.push_back(range);
+			}
+		}
+
+		std::sort(pushConstants.begin(), pushConstants.end(), [](const auto &first, const auto &second) {
+			return first.offset != second.offset ? first.offset < second.offset : first.size < second.size;
+		});
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+		++m_statistics.layoutRequestCount;
+
+		uint32_t setCount {sets.empty() ? 0 : sets.rbegin()->first + 1};
+		for (const auto &external : m_externalLayouts)
+		{
+			if (sets.contains(external.first))
+				setCount = std::max(setCount, external.first + 1);
+		}
+
+		vkpp::PipelineLayoutDescription description {};
+		description.pushConstants = std::move(pushConstants);
+
+		for (uint32_t set {0}; set < setCount; set++)
+		{
+			auto external {m_externalLayouts.find(set)};
+			if (external != m_externalLayouts.end())
+			{
+				description.setLayouts.push_back(external->second);
+				continue;
+			}
+
+			vkpp::DescriptorLayoutDescription setDescription {};
+			for (auto &binding : sets[set])
+			{
+				if (binding.second.count == 0)
+				{
+					throw std::runtime_error(
+						"VKPP : Set " + std::to_string(set) + " binding " + std::to_string(binding.first)
+						+ " is a runtime sized array, its layout must be given through ShaderRegistry::setExternalLayout()"
+					);
+				}
+
+				setDescription.bindings.push_back(std::move(binding.second));
+			}
+
+			description.setLayouts.push_back(m_device.getDescriptorLayoutCache().get(setDescription));
+		}
+
+		std::vector<VkDescriptorSetLayout> setLayouts {description.setLayouts};
+		return {std::move(setLayouts), s_getPipelineLayout(std::move(description))};
+	}
+
+
+
+	void ShaderRegistry::setExternalLayout(uint32_t set, VkDescriptorSetLayout layout)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_externalLayouts[set] = layout;
+	}
+
+
+
+	void ShaderRegistry::resetStatistics() noexcept
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		m_statistics = {};
+	}
+
+
+
+	size_t ShaderRegistry::getModuleCount() const
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return m_shaders.size();
+	}
+
+
+
+	vkpp::ShaderRegistryStatistics ShaderRegistry::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return m_statistics;
+	}
+
+
+
+	const vkpp::Shader &ShaderRegistry::s_load(std::span<const uint32_t> code, const std::filesystem::path &reflectionPath)
+	{
+		uint64_t hash {vkpp::utils::hash(code.data(), code.size_bytes())};
+
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			++m_statistics.moduleRequestCount;
+
+			auto found {m_shaders.find(hash)};
+			if (found != m_shaders.end())
+				return found->second;
+		}
+
+		// reflected and created outside the lock, a thread loading the same code at once only wastes its module
+		std::optional<vkpp::ShaderReflection> reflection {};
+		if (!reflectionPath.empty())
+			reflection = vkpp::loadShaderReflection(reflectionPath, hash);
+
+		bool loaded {reflection.has_value()};
+		if (!loaded)
+		{
+			reflection = vkpp::reflectSpirv(code);
+
+			// a failed save only costs the next startup its parsing
+			if (!reflectionPath.empty())
+			{
+				try
+				{
+					vkpp::saveShaderReflection(reflectionPath, *reflection, hash);
+				}
+
+				catch (const std::exception &exception)
+				{
+					std::cerr << exception.what() << std::endl;
+				}
+			}
+		}
+
+		VkShaderModuleCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size_bytes();
+		createInfo.pCode = code.data();
+
+		VkShaderModule module {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateShaderModule(m_device.get(), &createInfo, nullptr, &module) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create shader module");
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto [shader, inserted] {m_shaders.try_emplace(hash, vkpp::Shader {module, hash, std::move(*reflection)})};
+		if (!inserted)
+		{
+			m_device.getDispatch().vkDestroyShaderModule(m_device.get(), module, nullptr);
+			return shader->second;
+		}
+
+		++m_statistics.moduleCreatedCount;
+		if (loaded)
+			++m_statistics.reflectionLoadCount;
+		else
+			++m_statistics.reflectionParseCount;
+
+		return shader->second;
+	}
+
+
+
+	VkPipelineLayout ShaderRegistry::s_getPipelineLayout(vkpp::PipelineLayoutDescription description)
+	{
+		auto found {m_pipelineLayouts.find(description)};
+		if (found != m_pipelineLayouts.end())
+			return found->second;
+
+		VkPipelineLayoutCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		createInfo.setLayoutCount = static_cast<uint32_t> (description.setLayouts.size());
+		createInfo.pSetLayouts = description.setLayouts.data();
+		createInfo.pushConstantRangeCount = static_cast<uint32_t> (description.pushConstants.size());
+		createInfo.pPushConstantRanges = description.pushConstants.data();
+
+		VkPipelineLayout layout {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreatePipelineLayout(m_device.get(), &createInfo, nullptr, &layout) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create a pipeline layout");
+
+		m_pipelineLayouts.emplace(std::move(description), layout);
+		++m_statistics.pipelineLayoutCreatedCount;
+		return layout;
+	}
+
+
+
+} // namespace vkpp
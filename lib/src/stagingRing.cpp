@@ -0,0 +1,531 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "device.hpp"
+#include "stagingRing.hpp"
+#include "utils/format.hpp"
+
+
+
+namespace vkpp
+{
+	StagingRing::StagingRing(vkpp::Device &device, VkDeviceSize size, vkpp::QueueType queue, vkpp::QueueType consumer) :
+		m_device {device},
+		m_queue {queue},
+		m_consumer {consumer},
+		m_buffer {},
+		m_alignment {std::max<VkDeviceSize> (16, device.getPhysicalDevice().getProperties().limits.optimalBufferCopyOffsetAlignment)},
+		m_head {0},
+		m_used {0},
+		m_pendingBytes {0},
+		m_bufferCopies {},
+		m_imageCopies {},
+		m_inFlight {},
+		m_freeSubmissions {},
+		m_bufferAcquires {},
+		m_imageAcquires {},
+		m_nextSubmission {1},
+		m_completedSubmission {0},
+		m_mutex {},
+		m_statistics {}
+	{
+		m_buffer = m_device.getAllocator().createBuffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+	}
+
+
+
+	StagingRing::~StagingRing()
+	{
+		for (auto &submission : m_inFlight)
+			m_device.getDispatch().vkWaitForFences(m_device.get(), 1, &submission.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+		for (auto &submission : m_inFlight)
+			m_freeSubmissions.push_back(std::move(submission));
+
+		for (auto &submission : m_freeSubmissions)
+		{
+			m_device.getDispatch().vkDestroyFence(m_device.get(), submission.fence, nullptr);
+			m_device.getDispatch().vkDestroyCommandPool(m_device.get(), submission.pool, nullptr);
+		}
+
+		m_device.getAllocator().destroyBuffer(m_buffer);
+	}
+
+
+
+	void StagingRing::upload(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		VkDeviceSize staging {s_reserve(size, m_alignment)};
+		std::memcpy(static_cast<std::byte*> (m_buffer.allocation.mapped) + staging, data, size);
+
+		m_bufferCopies[buffer].push_back({staging, offset, size});
+		++m_statistics.uploadCount;
+		m_statistics.uploadedBytes += size;
+	}
+
+
+
+	void StagingRing::upload(
+		VkImage image,
+		const VkImageSubresourceLayers &subresource,
+		VkOffset3D offset,
+		VkExtent3D extent,
+		const void *data,
+		VkDeviceSize size,
+		VkImageLayout finalLayout,
+		VkImageLayout oldLayout
+	)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		VkDeviceSize staging {s_reserve(size, m_alignment)};
+		std::memcpy(static_cast<std::byte*> (m_buffer.allocation.mapped) + staging, data, size);
+
+		m_imageCopies[image].push_back({oldLayout, finalLayout, false, {staging, 0, 0, subresource, offset, extent}});
+		++m_statistics.uploadCount;
+		m_statistics.uploadedBytes += size;
+	}
+
+
+
+	void StagingRing::upload(
+		VkImage image,
+		VkFormat format,
+		VkExtent3D extent,
+		uint32_t arrayLayers,
+		std::span<const std::span<const std::byte>> mips,
+		VkImageLayout finalLayout
+	)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		// the whole image is recorded under the lock, a flush in between bands only comes from the ring running full
+		VkExtent2D blockExtent {vkpp::utils::getBlockExtent(format)};
+		VkDeviceSize maxBand {std::max<VkDeviceSize> (m_buffer.size / 4, 1)};
+
+		for (uint32_t mip {0}; mip < mips.size(); mip++)
+		{
+			uint32_t width {std::max(extent.width >> mip, 1u)};
+			uint32_t height {std::max(extent.height >> mip, 1u)};
+			uint32_t depth {std::max(extent.depth >> mip, 1u)};
+			uint32_t blockRows {(height + blockExtent.height - 1) / blockExtent.height};
+			VkDeviceSize layerSize {mips[mip].size() / arrayLayers};
+
+			if (mips[mip].size() % arrayLayers != 0 || layerSize % blockRows != 0)
+			{
+				throw std::runtime_error(
+					"VKPP : Can't upload mip " + std::to_string(mip) + " of " + std::to_string(mips[mip].size())
+					+ " bytes, it isn't a whole number of texel block rows per layer"
+				);
+			}
+
+			// the slices of a 3D layer interleave their rows, they go whole
+			VkDeviceSize blockRowSize {layerSize / blockRows};
+			uint32_t bandRows {blockRows};
+			if (layerSize > maxBand && depth == 1)
+				bandRows = static_cast<uint32_t> (std::clamp<VkDeviceSize> (maxBand / blockRowSize, 1, blockRows));
+
+			for (uint32_t layer {0}; layer < arrayLayers; layer++)
+			{
+				const std::byte *layerData {mips[mip].data() + layer * layerSize};
+
+				for (uint32_t blockRow {0}; blockRow < blockRows; blockRow += bandRows)
+				{
+					uint32_t rows {std::min(bandRows, blockRows - blockRow)};
+					uint32_t row {blockRow * blockExtent.height};
+					VkDeviceSize size {rows * blockRowSize};
+					bool last {blockRow + rows == blockRows};
+
+					VkDeviceSize staging {s_reserve(size, m_alignment)};
+					std::memcpy(static_cast<std::byte*> (m_buffer.allocation.mapped) + staging, layerData + blockRow * blockRowSize, size);
+
+					m_imageCopies[image].push_back({
+						blockRow == 0 ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						last ? finalLayout : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						!last,
+						{
+							staging, 0, 0, {VK_IMAGE_ASPECT_COLOR_BIT, mip, layer, 1},
+							{0, static_cast<int32_t> (row), 0}, {width, std::min(rows * blockExtent.height, height - row), depth}
+						}
+					});
+
+					++m_statistics.uploadCount;
+					m_statistics.uploadedBytes += size;
+				}
+			}
+		}
+	}
+
+
+
+	uint64_t StagingRing::flush()
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return s_flush();
+	}
+
+
+
+	uint64_t StagingRing::poll()
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return s_poll();
+	}
+
+
+
+	void StagingRing::wait(uint64_t submission)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		if (submission >= m_nextSubmission)
+			s_flush();
+
+		while (m_completedSubmission < submission && !m_inFlight.empty())
+			s_waitOldest();
+	}
+
+
+
+	void StagingRing::recordAcquires(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		s_poll();
+
+		if (m_bufferAcquires.empty() && m_imageAcquires.empty())
+			return;
+
+		for (auto &barrier : m_bufferAcquires)
+			barrier.dstAccessMask = dstAccess;
+
+		for (auto &barrier : m_imageAcquires)
+			barrier.dstAccessMask = dstAccess;
+
+		m_device.getDispatch().vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage,
+			0, 0, nullptr,
+			static_cast<uint32_t> (m_bufferAcquires.size()), m_bufferAcquires.data(),
+			static_cast<uint32_t> (m_imageAcquires.size()), m_imageAcquires.data()
+		);
+
+		m_bufferAcquires.clear();
+		m_imageAcquires.clear();
+	}
+
+
+
+	VkDeviceSize StagingRing::s_reserve(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (size > m_buffer.size)
+			throw std::runtime_error("VKPP : Can't stage " + std::to_string(size) + " bytes in a ring of " + std::to_string(m_buffer.size) + " bytes");
+
+		for (;;)
+		{
+			VkDeviceSize offset {(m_head + alignment - 1) / alignment * alignment};
+			if (offset + size > m_buffer.size)
+				offset = 0;
+
+			// bytes skipped at the end of the ring or for alignment are consumed as well
+			VkDeviceSize consumed {(offset >= m_head ? offset - m_head : m_buffer.size - m_head) + size};
+
+			if (m_used + consumed <= m_buffer.size)
+			{
+				m_head = (offset + size) % m_buffer.size;
+				m_used += consumed;
+				m_pendingBytes += consumed;
+				return offset;
+			}
+
+			s_poll();
+			if (m_used + consumed <= m_buffer.size)
+				continue;
+
+			++m_statistics.stallCount;
+			if (m_inFlight.empty())
+				s_flush();
+
+			if (m_inFlight.empty())
+				throw std::runtime_error("VKPP : Staging ring is full without any submission in flight");
+
+			s_waitOldest();
+		}
+	}
+
+
+
+	uint64_t StagingRing::s_flush()
+	{
+		if (m_bufferCopies.empty() && m_imageCopies.empty())
+			return m_nextSubmission - 1;
+
+		vkpp::StagingSubmission submission {s_getSubmission()};
+		submission.id = m_nextSubmission++;
+		submission.consumedBytes = m_pendingBytes;
+		m_pendingBytes = 0;
+
+		bool ownershipTransfer {!m_device.isSameQueueFamily(m_queue, m_consumer)};
+		uint32_t srcFamily {ownershipTransfer ? m_device.getQueueFamily(m_queue) : VK_QUEUE_FAMILY_IGNORED};
+		uint32_t dstFamily {ownershipTransfer ? m_device.getQueueFamily(m_consumer) : VK_QUEUE_FAMILY_IGNORED};
+
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (m_device.getDispatch().vkBeginCommandBuffer(submission.commandBuffer, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't begin staging command buffer");
+
+
+		std::vector<VkImageMemoryBarrier> preBarriers {};
+		std::vector<VkImageMemoryBarrier> postImageBarriers {};
+		std::vector<VkBufferMemoryBarrier> postBufferBarriers {};
+
+		for (const auto &image : m_imageCopies)
+		{
+			// one barrier pair per subresource range the copies cover, from the layout its first copy expects to the
+			// one its last copy asks for : mips and layers no copy touches keep their layout and contents
+			std::map<std::tuple<VkImageAspectFlags, uint32_t, uint32_t, uint32_t>, std::pair<size_t, size_t>> ranges {};
+			for (size_t i {0}; i < image.second.size(); i++)
+			{
+				const VkImageSubresourceLayers &subresource {image.second[i].region.imageSubresource};
+				auto [range, inserted] {ranges.try_emplace(
+					{subresource.aspectMask, subresource.mipLevel, subresource.baseArrayLayer, subresource.layerCount},
+					i, i
+				)};
+
+				range->second.second = i;
+			}
+
+			for (const auto &range : ranges)
+			{
+				const vkpp::StagingImageCopy &first {image.second[range.second.first]};
+				const vkpp::StagingImageCopy &last {image.second[range.second.second]};
+
+				VkImageMemoryBarrier barrier {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = first.oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.oldLayout = first.oldLayout;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = image.first;
+				barrier.subresourceRange = {
+					std::get<0> (range.first), std::get<1> (range.first), 1, std::get<2> (range.first), std::get<3> (range.first)
+				};
+				preBarriers.push_back(barrier);
+
+				// a subresource whose remaining copies come in a later submission stays on the ring's queue
+				if (last.pending)
+					continue;
+
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = ownershipTransfer ? 0 : VK_ACCESS_MEMORY_READ_BIT;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.newLayout = last.finalLayout;
+				barrier.srcQueueFamilyIndex = srcFamily;
+				barrier.dstQueueFamilyIndex = dstFamily;
+				postImageBarriers.push_back(barrier);
+			}
+		}
+
+		if (!preBarriers.empty())
+		{
+			m_device.getDispatch().vkCmdPipelineBarrier(
+				submission.commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 0, nullptr,
+				static_cast<uint32_t> (preBarriers.size()), preBarriers.data()
+			);
+		}
+
+
+		for (const auto &buffer : m_bufferCopies)
+		{
+			m_device.getDispatch().vkCmdCopyBuffer(
+				submission.commandBuffer,
+				m_buffer.buffer, buffer.first,
+				static_cast<uint32_t> (buffer.second.size()), buffer.second.data()
+			);
+
+			if (!ownershipTransfer)
+				continue;
+
+			VkBufferMemoryBarrier barrier {};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = srcFamily;
+			barrier.dstQueueFamilyIndex = dstFamily;
+			barrier.buffer = buffer.first;
+			barrier.offset = 0;
+			barrier.size = VK_WHOLE_SIZE;
+			postBufferBarriers.push_back(barrier);
+		}
+
+		std::vector<VkBufferImageCopy> regions {};
+
+		for (const auto &image : m_imageCopies)
+		{
+			regions.clear();
+			for (const auto &copy : image.second)
+				regions.push_back(copy.region);
+
+			m_device.getDispatch().vkCmdCopyBufferToImage(
+				submission.commandBuffer,
+				m_buffer.buffer, image.first, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				static_cast<uint32_t> (regions.size()), regions.data()
+			);
+		}
+
+
+		VkMemoryBarrier memoryBarrier {};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+		m_device.getDispatch().vkCmdPipelineBarrier(
+			submission.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			ownershipTransfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			ownershipTransfer ? 0 : 1, &memoryBarrier,
+			static_cast<uint32_t> (postBufferBarriers.size()), postBufferBarriers.data(),
+			static_cast<uint32_t> (postImageBarriers.size()), postImageBarriers.data()
+		);
+
+		if (m_device.getDispatch().vkEndCommandBuffer(submission.commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't end staging command buffer");
+
+
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &submission.commandBuffer;
+
+		if (m_device.getDispatch().vkQueueSubmit(m_device.getQueue(m_queue), 1, &submitInfo, submission.fence) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't submit staging copies");
+
+		if (ownershipTransfer)
+		{
+			submission.bufferAcquires = std::move(postBufferBarriers);
+			submission.imageAcquires = std::move(postImageBarriers);
+		}
+
+		m_bufferCopies.clear();
+		m_imageCopies.clear();
+		m_inFlight.push_back(std::move(submission));
+		++m_statistics.flushCount;
+		return m_inFlight.back().id;
+	}
+
+
+
+	uint64_t StagingRing::s_poll()
+	{
+		while (!m_inFlight.empty() && m_device.getDispatch().vkGetFenceStatus(m_device.get(), m_inFlight.front().fence) == VK_SUCCESS)
+		{
+			vkpp::StagingSubmission &submission {m_inFlight.front()};
+
+			m_used -= submission.consumedBytes;
+			m_completedSubmission = submission.id;
+
+			// the release barriers become acquire barriers on the consumer queue, with the very same layouts
+			for (auto barrier : submission.bufferAcquires)
+			{
+				barrier.srcAccessMask = 0;
+				m_bufferAcquires.push_back(barrier);
+			}
+
+			for (auto barrier : submission.imageAcquires)
+			{
+				barrier.srcAccessMask = 0;
+				m_imageAcquires.push_back(barrier);
+			}
+
+			submission.bufferAcquires.clear();
+			submission.imageAcquires.clear();
+			m_freeSubmissions.push_back(std::move(submission));
+			m_inFlight.pop_front();
+		}
+
+		if (m_inFlight.empty() && m_pendingBytes == 0)
+		{
+			m_head = 0;
+			m_used = 0;
+		}
+
+		return m_completedSubmission;
+	}
+
+
+
+	void StagingRing::s_waitOldest()
+	{
+		if (m_device.getDispatch().vkWaitForFences(m_device.get(), 1, &m_inFlight.front().fence, VK_TRUE, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't wait for staging submission " + std::to_string(m_inFlight.front().id));
+
+		s_poll();
+	}
+
+
+
+	vkpp::StagingSubmission StagingRing::s_getSubmission()
+	{
+		if (!m_freeSubmissions.empty())
+		{
+			vkpp::StagingSubmission submission {std::move(m_freeSubmissions.back())};
+			m_freeSubmissions.pop_back();
+
+			if (m_device.getDispatch().vkResetFences(m_device.get(), 1, &submission.fence) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't reset staging fence");
+
+			if (m_device.getDispatch().vkResetCommandPool(m_device.get(), submission.pool, 0) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't reset staging command pool");
+
+			return submission;
+		}
+
+		vkpp::StagingSubmission submission {};
+
+		VkCommandPoolCreateInfo poolCreateInfo {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolCreateInfo.queueFamilyIndex = m_device.getQueueFamily(m_queue);
+
+		if (m_device.getDispatch().vkCreateCommandPool(m_device.get(), &poolCreateInfo, nullptr, &submission.pool) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create staging command pool");
+
+		VkCommandBufferAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = submission.pool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		if (m_device.getDispatch().vkAllocateCommandBuffers(m_device.get(), &allocateInfo, &submission.commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't allocate staging command buffer");
+
+		VkFenceCreateInfo fenceCreateInfo {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (m_device.getDispatch().vkCreateFence(m_device.get(), &fenceCreateInfo, nullptr, &submission.fence) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create staging fence");
+
+		return submission;
+	}
+
+
+
+} // namespace vkpp
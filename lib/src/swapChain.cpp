@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <stdexcept>
+#include <string>
 
 #include "instance.hpp"
 #include "swapChain.hpp"
@@ -12,22 +14,44 @@ namespace vkpp
 	SwapChain::SwapChain(vkpp::Instance &instance) : 
 		m_instance {instance},
 		m_swapChain {VK_NULL_HANDLE},
-		m_images {}
+		m_images {},
+		m_frames {},
+		m_renderFinished {},
+		m_imagesInFlight {},
+		m_recreateRequested {false},
+		m_measureRecreateLatency {false},
+		m_recreateRequestTime {},
+		m_currentFrame {0},
+		m_frameNumber {0},
+		m_lastSubmitted {VK_NULL_HANDLE},
+		m_lastBeginFrame {},
+		m_statistics {}
 	{
 		this->recreate();
+		s_createFrames(m_instance.getParameters().framesInFlight);
 	}
 
 
 
 	SwapChain::~SwapChain()
 	{
-		vkDestroySwapchainKHR(m_instance.getDevice().get(), m_swapChain, nullptr);
+		m_instance.getDevice().getDispatch().vkDeviceWaitIdle(m_instance.getDevice().get());
+
+		s_destroyFrames();
+		s_destroyImageSemaphores();
+		for (auto image : m_images)
+			m_instance.getDevice().getImageTracker().remove(image);
+
+		m_instance.getDevice().getDeletionQueue().flush();
+		m_instance.getDevice().getDispatch().vkDestroySwapchainKHR(m_instance.getDevice().get(), m_swapChain, nullptr);
 	}
 
 
 
 	void SwapChain::recreate()
 	{
+		m_instance.getPhysicalDevice().refreshSurfaceCapabilities();
+
 		VkSurfaceFormatKHR format {s_chooseFormat(m_instance.getPhysicalDevice().getSwapChainInfos().formats)};
 		VkPresentModeKHR presentMode {s_choosePresentMode(m_instance.getPhysicalDevice().getSwapChainInfos().presentModes)};
 		VkExtent2D extent {s_chooseExtent(m_instance, m_instance.getPhysicalDevice().getSwapChainInfos().capabilities)};
@@ -50,20 +74,22 @@ namespace vkpp
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		createInfo.oldSwapchain = m_swapChain;
 
 		std::vector<uint32_t> independentQueueIndices {};
 
-		for (auto queue : m_instance.getPhysicalDevice().getQueues().get())
+		// only the graphics and present queues ever touch swap chain images
+		for (auto type : {vkpp::QueueType::graphics, vkpp::QueueType::present})
 		{
-			if (!queue.second.index.has_value())
+			const vkpp::QueueInfos &queue {m_instance.getPhysicalDevice().getQueues().get(type)};
+			if (!queue.index.has_value())
 				continue;
 
 			bool found {false};
 
 			for (auto independent : independentQueueIndices)
 			{
-				if (independent == queue.second.index.value())
+				if (independent == queue.index.value())
 				{
 					found = true;
 					break;
@@ -71,7 +97,7 @@ namespace vkpp
 			}
 
 			if (!found)
-				independentQueueIndices.push_back(queue.second.index.value());
+				independentQueueIndices.push_back(queue.index.value());
 		}
 
 		if (independentQueueIndices.size() == 1)
@@ -88,20 +114,202 @@ namespace vkpp
 			createInfo.pQueueFamilyIndices = independentQueueIndices.data();
 		}
 
+		VkSwapchainKHR newSwapChain {VK_NULL_HANDLE};
+		if (m_instance.getDevice().getDispatch().vkCreateSwapchainKHR(m_instance.getDevice().get(), &createInfo, nullptr, &newSwapChain) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create (or recreate) a swap chain");
+
+		// the old swap chain may still be read by frames in flight, it is destroyed once they retired
 		if (m_swapChain != VK_NULL_HANDLE)
-			vkDestroySwapchainKHR(m_instance.getDevice().get(), m_swapChain, nullptr);
+		{
+			m_instance.getDevice().getDeletionQueue().retire([&device = m_instance.getDevice(), swapChain = m_swapChain, semaphores = std::move(m_renderFinished)] {
+				for (auto semaphore : semaphores)
+					device.getDispatch().vkDestroySemaphore(device.get(), semaphore, nullptr);
+
+				device.getDispatch().vkDestroySwapchainKHR(device.get(), swapChain, nullptr);
+			});
+		}
 
+		for (auto image : m_images)
+			m_instance.getDevice().getImageTracker().remove(image);
 
-		if (vkCreateSwapchainKHR(m_instance.getDevice().get(), &createInfo, nullptr, &m_swapChain) != VK_SUCCESS)
-			throw std::runtime_error("VKPP : Can't create (or recreate) a swap chain");
+		m_swapChain = newSwapChain;
+		m_renderFinished.clear();
+		m_recreateRequested = false;
+		++m_statistics.recreateCount;
 
 		uint32_t imagesCount {};
-		if (vkGetSwapchainImagesKHR(m_instance.getDevice().get(), m_swapChain, &imagesCount, nullptr) != VK_SUCCESS)
+		if (m_instance.getDevice().getDispatch().vkGetSwapchainImagesKHR(m_instance.getDevice().get(), m_swapChain, &imagesCount, nullptr) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get swap chain images count");
 
 		m_images.resize(imagesCount);
-		if (vkGetSwapchainImagesKHR(m_instance.getDevice().get(), m_swapChain, &imagesCount, m_images.data()) != VK_SUCCESS)
+		if (m_instance.getDevice().getDispatch().vkGetSwapchainImagesKHR(m_instance.getDevice().get(), m_swapChain, &imagesCount, m_images.data()) != VK_SUCCESS)
 			throw std::runtime_error("VKPP : Can't get swap chain images");
+
+		for (auto image : m_images)
+			m_instance.getDevice().getImageTracker().add(image, format.format, 1, 1);
+
+		s_createImageSemaphores();
+		m_imagesInFlight.assign(m_images.size(), VK_NULL_HANDLE);
+	}
+
+
+
+	void SwapChain::requestRecreate() noexcept
+	{
+		m_recreateRequested = true;
+		m_measureRecreateLatency = true;
+		m_recreateRequestTime = std::chrono::steady_clock::now();
+	}
+
+
+
+	const vkpp::FrameContext &SwapChain::beginFrame()
+	{
+		VkDevice device {m_instance.getDevice().get()};
+		vkpp::FrameContext &frame {m_frames[m_currentFrame]};
+
+		auto start {std::chrono::steady_clock::now()};
+		if (m_statistics.frameCount != 0)
+			m_statistics.cpuFrameTime += std::chrono::duration<double, std::milli> (start - m_lastBeginFrame).count();
+		m_lastBeginFrame = start;
+
+		if (m_instance.getDevice().getDispatch().vkWaitForFences(device, 1, &frame.inFlight, VK_TRUE, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't wait for frame " + std::to_string(m_currentFrame) + " fence");
+
+		m_statistics.fenceWaitTime += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+		m_instance.getDevice().getDeletionQueue().beginFrame(m_frameNumber, static_cast<uint32_t> (m_frames.size()));
+		m_instance.getDevice().getResidencyManager().beginFrame(m_frameNumber, static_cast<uint32_t> (m_frames.size()));
+
+		if (m_recreateRequested)
+			this->recreate();
+
+		VkResult result {m_instance.getDevice().getDispatch().vkAcquireNextImageKHR(
+			device, m_swapChain, std::numeric_limits<uint64_t>::max(), frame.imageAvailable, VK_NULL_HANDLE, &frame.imageIndex
+		)};
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			this->recreate();
+			result = m_instance.getDevice().getDispatch().vkAcquireNextImageKHR(
+				device, m_swapChain, std::numeric_limits<uint64_t>::max(), frame.imageAvailable, VK_NULL_HANDLE, &frame.imageIndex
+			);
+		}
+
+		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			throw std::runtime_error("VKPP : Can't acquire next swap chain image");
+
+		// the image may still be used by an older frame slot when there are more frames in flight than images
+		VkFence imageFence {m_imagesInFlight[frame.imageIndex]};
+		if (imageFence != VK_NULL_HANDLE && imageFence != frame.inFlight)
+		{
+			if (m_instance.getDevice().getDispatch().vkWaitForFences(device, 1, &imageFence, VK_TRUE, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't wait for swap chain image " + std::to_string(frame.imageIndex) + " fence");
+		}
+
+		m_imagesInFlight[frame.imageIndex] = frame.inFlight;
+		m_instance.getDevice().getImageTracker().acquire(m_images[frame.imageIndex], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+		frame.number = m_frameNumber;
+		frame.image = m_images[frame.imageIndex];
+		frame.renderFinished = m_renderFinished[frame.imageIndex];
+		return frame;
+	}
+
+
+
+	void SwapChain::endFrame(const std::vector<VkCommandBuffer> &commandBuffers)
+	{
+		VkDevice device {m_instance.getDevice().get()};
+		vkpp::FrameContext &frame {m_frames[m_currentFrame]};
+
+		if (m_lastSubmitted != VK_NULL_HANDLE && m_instance.getDevice().getDispatch().vkGetFenceStatus(device, m_lastSubmitted) == VK_SUCCESS)
+			++m_statistics.gpuStarvedFrames;
+
+		// descriptors written while recording must reach the set before the GPU reads it
+		if (m_instance.getDevice().hasBindless())
+			m_instance.getDevice().getBindlessHeap().flush();
+
+		if (m_instance.getDevice().getDispatch().vkResetFences(device, 1, &frame.inFlight) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't reset frame " + std::to_string(m_currentFrame) + " fence");
+
+		VkPipelineStageFlags waitStage {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+
+		// with a scheduler the frame goes out in the same batch as the work queued before it on the graphics queue,
+		// the swap chain semaphores staying binary
+		if (m_instance.getDevice().hasScheduler())
+		{
+			vkpp::Scheduler &scheduler {m_instance.getDevice().getScheduler()};
+			scheduler.submit(vkpp::QueueType::graphics, {commandBuffers, {}, {frame.imageAvailable}, {waitStage}, {frame.renderFinished}});
+			scheduler.flush(vkpp::QueueType::graphics, frame.inFlight);
+		}
+
+		else
+		{
+			VkSubmitInfo submitInfo {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &frame.imageAvailable;
+			submitInfo.pWaitDstStageMask = &waitStage;
+			submitInfo.commandBufferCount = static_cast<uint32_t> (commandBuffers.size());
+			submitInfo.pCommandBuffers = commandBuffers.data();
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &frame.renderFinished;
+
+			if (m_instance.getDevice().getDispatch().vkQueueSubmit(m_instance.getDevice().getQueues().at(vkpp::QueueType::graphics), 1, &submitInfo, frame.inFlight) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't submit frame " + std::to_string(m_frameNumber));
+		}
+
+		VkPresentInfoKHR presentInfo {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &frame.renderFinished;
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &m_swapChain;
+		presentInfo.pImageIndices = &frame.imageIndex;
+
+		VkResult result {m_instance.getDevice().getDispatch().vkQueuePresentKHR(m_instance.getDevice().getQueues().at(vkpp::QueueType::present), &presentInfo)};
+
+		m_lastSubmitted = frame.inFlight;
+		m_currentFrame = (m_currentFrame + 1) % static_cast<uint32_t> (m_frames.size());
+		++m_frameNumber;
+		++m_statistics.frameCount;
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+			m_recreateRequested = true;
+
+		else if (result != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't present frame " + std::to_string(frame.number));
+
+		else if (m_measureRecreateLatency && !m_recreateRequested)
+		{
+			m_statistics.lastRecreateLatency = std::chrono::duration<double, std::milli> (
+				std::chrono::steady_clock::now() - m_recreateRequestTime
+			).count();
+			m_measureRecreateLatency = false;
+		}
+	}
+
+
+
+	void SwapChain::setFramesInFlight(uint32_t framesInFlight)
+	{
+		if (framesInFlight == 0)
+			throw std::runtime_error("VKPP : A swap chain needs at least one frame in flight");
+
+		m_instance.getDevice().getDispatch().vkDeviceWaitIdle(m_instance.getDevice().get());
+
+		m_instance.getDevice().getDeletionQueue().flush();
+		s_destroyFrames();
+		s_createFrames(framesInFlight);
+		m_imagesInFlight.assign(m_images.size(), VK_NULL_HANDLE);
+	}
+
+
+
+	void SwapChain::resetStatistics() noexcept
+	{
+		m_statistics = {};
 	}
 
 
@@ -151,4 +359,76 @@ namespace vkpp
 
 
 
+	void SwapChain::s_createFrames(uint32_t framesInFlight)
+	{
+		VkDevice device {m_instance.getDevice().get()};
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo {};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		VkFenceCreateInfo fenceCreateInfo {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		m_frames.resize(framesInFlight);
+
+		for (uint32_t i {0}; i < framesInFlight; i++)
+		{
+			m_frames[i] = {};
+			m_frames[i].index = i;
+			m_frames[i].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+			if (m_instance.getDevice().getDispatch().vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &m_frames[i].imageAvailable) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create image available semaphore of frame " + std::to_string(i));
+
+			if (m_instance.getDevice().getDispatch().vkCreateFence(device, &fenceCreateInfo, nullptr, &m_frames[i].inFlight) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create in flight fence of frame " + std::to_string(i));
+		}
+
+		m_currentFrame = 0;
+		m_lastSubmitted = VK_NULL_HANDLE;
+	}
+
+
+
+	void SwapChain::s_destroyFrames()
+	{
+		for (auto &frame : m_frames)
+		{
+			m_instance.getDevice().getDispatch().vkDestroySemaphore(m_instance.getDevice().get(), frame.imageAvailable, nullptr);
+			m_instance.getDevice().getDispatch().vkDestroyFence(m_instance.getDevice().get(), frame.inFlight, nullptr);
+		}
+
+		m_frames.clear();
+	}
+
+
+
+	void SwapChain::s_createImageSemaphores()
+	{
+		VkSemaphoreCreateInfo semaphoreCreateInfo {};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		// one per image rather than per frame : the presentation engine may hold on to it until the image is acquired again
+		m_renderFinished.resize(m_images.size());
+
+		for (size_t i {0}; i < m_renderFinished.size(); i++)
+		{
+			if (m_instance.getDevice().getDispatch().vkCreateSemaphore(m_instance.getDevice().get(), &semaphoreCreateInfo, nullptr, &m_renderFinished[i]) != VK_SUCCESS)
+				throw std::runtime_error("VKPP : Can't create render finished semaphore of image " + std::to_string(i));
+		}
+	}
+
+
+
+	void SwapChain::s_destroyImageSemaphores()
+	{
+		for (auto semaphore : m_renderFinished)
+			m_instance.getDevice().getDispatch().vkDestroySemaphore(m_instance.getDevice().get(), semaphore, nullptr);
+
+		m_renderFinished.clear();
+	}
+
+
+
 } // namespace vkpp
@@ -0,0 +1,560 @@
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "device.hpp"
+#include "textureStreamer.hpp"
+
+
+
+namespace vkpp
+{
+	TextureStreamer::TextureStreamer(vkpp::Device &device, const vkpp::TextureStreamerParameters &parameters) :
+		m_device {device},
+		m_parameters {parameters},
+		m_stagingRing {device, parameters.stagingSize, vkpp::QueueType::transfer, vkpp::QueueType::graphics},
+		m_acquires {!device.isSameQueueFamily(vkpp::QueueType::transfer, vkpp::QueueType::graphics)},
+		m_acquirePool {VK_NULL_HANDLE},
+		m_acquireCommandBuffer {VK_NULL_HANDLE},
+		m_acquireFence {VK_NULL_HANDLE},
+		m_mutex {},
+		m_textures {},
+		m_requests {},
+		m_loaded {},
+		m_uploads {},
+		m_requestTimes {},
+		m_nextHandle {1},
+		m_loadingCount {0},
+		m_statistics {},
+		m_workers {std::max(parameters.workerCount, 1u)}
+	{
+		if (!m_device.hasBindless())
+			throw std::runtime_error("VKPP : Can't stream textures on a device without bindless heap");
+
+		if (!m_acquires)
+			return;
+
+		VkCommandPoolCreateInfo poolCreateInfo {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolCreateInfo.queueFamilyIndex = m_device.getQueueFamily(vkpp::QueueType::graphics);
+
+		if (m_device.getDispatch().vkCreateCommandPool(m_device.get(), &poolCreateInfo, nullptr, &m_acquirePool) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create texture streamer acquire command pool");
+
+		VkCommandBufferAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = m_acquirePool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		if (m_device.getDispatch().vkAllocateCommandBuffers(m_device.get(), &allocateInfo, &m_acquireCommandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't allocate texture streamer acquire command buffer");
+
+		VkFenceCreateInfo fenceCreateInfo {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (m_device.getDispatch().vkCreateFence(m_device.get(), &fenceCreateInfo, nullptr, &m_acquireFence) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create texture streamer acquire fence");
+	}
+
+
+
+	TextureStreamer::~TextureStreamer()
+	{
+		// a loader's exception was already counted, there is nobody left to hand it to
+		try
+		{
+			m_workers.wait();
+		}
+
+		catch (...)
+		{
+
+		}
+
+		m_stagingRing.wait(m_stagingRing.getLastSubmission());
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		for (const auto &upload : m_uploads)
+			s_retire(upload.image, VK_NULL_HANDLE);
+
+		std::vector<vkpp::StreamedTextureHandle> handles {};
+		for (const auto &texture : m_textures)
+			handles.push_back(texture.first);
+
+		for (auto handle : handles)
+			s_erase(handle);
+
+		if (m_acquires)
+		{
+			m_device.getDispatch().vkDestroyFence(m_device.get(), m_acquireFence, nullptr);
+			m_device.getDispatch().vkDestroyCommandPool(m_device.get(), m_acquirePool, nullptr);
+		}
+	}
+
+
+
+	vkpp::StreamedTextureHandle TextureStreamer::add(vkpp::StreamedTextureDescription description)
+	{
+		if (description.mipLevels == 0 || !description.loader)
+			throw std::runtime_error("VKPP : Can't stream a texture without mip levels or loader");
+
+		// first mip level fitting in the tail size
+		uint32_t tailMip {0};
+		while (tailMip + 1 < description.mipLevels
+			&& std::max(description.extent.width >> tailMip, description.extent.height >> tailMip) > m_parameters.tailSize)
+			++tailMip;
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+		vkpp::StreamedTextureHandle handle {m_nextHandle++};
+		float priority {std::numeric_limits<float>::max()};
+		uint32_t mipLevels {description.mipLevels};
+
+		m_textures[handle] = {
+			std::move(description), {}, VK_NULL_HANDLE, vkpp::BINDLESS_INVALID_INDEX, mipLevels, tailMip, priority, true, false, false
+		};
+		m_requests.push({priority, handle});
+		m_requestTimes[handle] = std::chrono::steady_clock::now();
+		return handle;
+	}
+
+
+
+	void TextureStreamer::request(vkpp::StreamedTextureHandle handle, uint32_t mipLevel, float priority)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto found {m_textures.find(handle)};
+		if (found == m_textures.end())
+			throw std::runtime_error("VKPP : Can't request mips of streamed texture " + std::to_string(handle) + ", it doesn't exist");
+
+		vkpp::StreamedTexture &texture {found->second};
+		if (texture.removed)
+			return;
+
+		mipLevel = std::min(mipLevel, texture.description.mipLevels - 1);
+		if (mipLevel < texture.requestedMip)
+		{
+			texture.requestedMip = mipLevel;
+			m_requestTimes.try_emplace(handle, std::chrono::steady_clock::now());
+		}
+
+		// a texture being loaded is queued again once swapped, if it still lacks mips
+		if (texture.requestedMip >= texture.residentMip || texture.loading)
+			return;
+
+		// a higher priority queues another entry, the stale one is skipped once popped
+		if (texture.queued && priority <= texture.priority)
+			return;
+
+		texture.priority = priority;
+		texture.queued = true;
+		m_requests.push({priority, handle});
+	}
+
+
+
+	void TextureStreamer::remove(vkpp::StreamedTextureHandle handle)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto found {m_textures.find(handle)};
+		if (found == m_textures.end())
+			return;
+
+		// the load or upload in flight erases it once done
+		if (found->second.loading)
+		{
+			found->second.removed = true;
+			return;
+		}
+
+		s_erase(handle);
+	}
+
+
+
+	void TextureStreamer::update()
+	{
+		this->update(VK_NULL_HANDLE);
+	}
+
+
+
+	void TextureStreamer::update(VkCommandBuffer commandBuffer)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		s_dispatchLoads();
+
+		// the oldest loads first, within the frame's upload budget
+		VkDeviceSize uploadBytes {0};
+		size_t uploadCount {0};
+
+		for (auto &loaded : m_loaded)
+		{
+			VkDeviceSize size {0};
+			for (const auto &mip : loaded.mips)
+				size += mip.size();
+
+			if (uploadCount != 0 && uploadBytes + size > m_parameters.maxUploadBytesPerFrame)
+				break;
+
+			s_upload(loaded);
+			uploadBytes += size;
+			++uploadCount;
+		}
+
+		m_loaded.erase(m_loaded.begin(), m_loaded.begin() + static_cast<std::ptrdiff_t> (uploadCount));
+
+		if (uploadBytes != 0)
+		{
+			uint64_t submission {m_stagingRing.flush()};
+			for (auto &upload : m_uploads)
+			{
+				if (upload.submission == 0)
+					upload.submission = submission;
+			}
+		}
+
+		// the images the ring released are the graphics queue's once acquired : their indices are published after
+		// the acquires are recorded, into a command buffer submitted before any frame sampling them
+		if (m_acquires && commandBuffer == VK_NULL_HANDLE)
+			return;
+
+		uint64_t completed {m_stagingRing.poll()};
+		if (commandBuffer != VK_NULL_HANDLE)
+		{
+			m_stagingRing.recordAcquires(
+				commandBuffer,
+				VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT
+			);
+		}
+
+		std::erase_if(m_uploads, [this, completed](vkpp::StreamingUpload &upload) {
+			if (upload.submission == 0 || upload.submission > completed)
+				return false;
+
+			s_swap(upload);
+			return true;
+		});
+	}
+
+
+
+	void TextureStreamer::flush()
+	{
+		for (;;)
+		{
+			this->update();
+
+			bool uploading {false};
+
+			{
+				std::lock_guard<std::mutex> lock {m_mutex};
+				if (m_requests.empty() && m_loadingCount == 0)
+					return;
+
+				uploading = !m_uploads.empty();
+			}
+
+			// either the GPU or the workers have something to finish
+			if (uploading)
+			{
+				m_stagingRing.wait(m_stagingRing.getLastSubmission());
+				if (m_acquires)
+					s_updateImmediate();
+			}
+			else
+				std::this_thread::yield();
+		}
+	}
+
+
+
+	void TextureStreamer::resetStatistics() noexcept
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		VkDeviceSize residentBytes {m_statistics.residentBytes};
+		m_statistics = {};
+		m_statistics.residentBytes = residentBytes;
+		m_statistics.peakResidentBytes = residentBytes;
+	}
+
+
+
+	vkpp::BindlessIndex TextureStreamer::getBindlessIndex(vkpp::StreamedTextureHandle handle)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto found {m_textures.find(handle)};
+		if (found == m_textures.end())
+			throw std::runtime_error("VKPP : Streamed texture " + std::to_string(handle) + " doesn't exist");
+
+		return found->second.index;
+	}
+
+
+
+	uint32_t TextureStreamer::getResidentMip(vkpp::StreamedTextureHandle handle)
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto found {m_textures.find(handle)};
+		if (found == m_textures.end())
+			throw std::runtime_error("VKPP : Streamed texture " + std::to_string(handle) + " doesn't exist");
+
+		return found->second.residentMip;
+	}
+
+
+
+	void TextureStreamer::s_dispatchLoads()
+	{
+		while (m_loadingCount < m_parameters.maxConcurrentLoads && !m_requests.empty())
+		{
+			vkpp::StreamingRequest request {m_requests.top()};
+			m_requests.pop();
+
+			auto found {m_textures.find(request.handle)};
+			if (found == m_textures.end())
+				continue;
+
+			vkpp::StreamedTexture &texture {found->second};
+			if (!texture.queued || texture.priority != request.priority || texture.loading || texture.removed)
+				continue;
+
+			texture.queued = false;
+			if (texture.requestedMip >= texture.residentMip)
+				continue;
+
+			texture.loading = true;
+			++m_loadingCount;
+
+			m_workers.submit([this, handle = request.handle, firstMip = texture.requestedMip, mipLevels = texture.description.mipLevels,
+				loader = texture.description.loader](uint32_t)
+			{
+				auto start {std::chrono::steady_clock::now()};
+				vkpp::LoadedMips loaded {handle, firstMip, {}};
+				VkDeviceSize size {0};
+
+				try
+				{
+					for (uint32_t mip {firstMip}; mip < mipLevels; mip++)
+					{
+						loaded.mips.push_back(loader(mip));
+						size += loaded.mips.back().size();
+					}
+				}
+
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock {m_mutex};
+					++m_statistics.failedLoadCount;
+					m_loaded.push_back({handle, firstMip, {}});
+					throw;
+				}
+
+				std::lock_guard<std::mutex> lock {m_mutex};
+				++m_statistics.loadCount;
+				m_statistics.loadedBytes += size;
+				m_statistics.loadTime += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+				m_loaded.push_back(std::move(loaded));
+			});
+		}
+	}
+
+
+
+	void TextureStreamer::s_upload(vkpp::LoadedMips &loaded)
+	{
+		auto found {m_textures.find(loaded.handle)};
+		if (found == m_textures.end())
+			return;
+
+		vkpp::StreamedTexture &texture {found->second};
+
+		if (texture.removed || loaded.mips.empty())
+		{
+			texture.loading = false;
+			--m_loadingCount;
+
+			if (texture.removed)
+				s_erase(loaded.handle);
+
+			return;
+		}
+
+		const vkpp::StreamedTextureDescription &description {texture.description};
+		VkExtent2D extent {std::max(description.extent.width >> loaded.firstMip, 1u), std::max(description.extent.height >> loaded.firstMip, 1u)};
+
+		VkImageCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		createInfo.imageType = VK_IMAGE_TYPE_2D;
+		createInfo.format = description.format;
+		createInfo.extent = {extent.width, extent.height, 1};
+		createInfo.mipLevels = description.mipLevels - loaded.firstMip;
+		createInfo.arrayLayers = 1;
+		createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		createInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		vkpp::Image image {m_device.getAllocator().createImage(createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)};
+		m_statistics.residentBytes += image.allocation.size;
+		m_statistics.peakResidentBytes = std::max(m_statistics.peakResidentBytes, m_statistics.residentBytes);
+
+		// large mips go in bands, so that a single one never stalls the whole ring
+		std::vector<std::span<const std::byte>> mips {loaded.mips.begin(), loaded.mips.end()};
+		m_stagingRing.upload(image.image, description.format, createInfo.extent, 1, mips, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		m_uploads.push_back({loaded.handle, loaded.firstMip, image, 0});
+	}
+
+
+
+	void TextureStreamer::s_swap(vkpp::StreamingUpload &upload)
+	{
+		auto found {m_textures.find(upload.handle)};
+		if (found == m_textures.end())
+		{
+			s_retire(upload.image, VK_NULL_HANDLE);
+			return;
+		}
+
+		vkpp::StreamedTexture &texture {found->second};
+		texture.loading = false;
+		--m_loadingCount;
+
+		if (texture.removed)
+		{
+			s_retire(upload.image, VK_NULL_HANDLE);
+			s_erase(upload.handle);
+			return;
+		}
+
+		uint32_t mipLevels {texture.description.mipLevels - upload.firstMip};
+
+		VkImageViewCreateInfo viewCreateInfo {};
+		viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewCreateInfo.image = upload.image.image;
+		viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewCreateInfo.format = texture.description.format;
+		viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+
+		VkImageView view {VK_NULL_HANDLE};
+		if (m_device.getDispatch().vkCreateImageView(m_device.get(), &viewCreateInfo, nullptr, &view) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't create the view of streamed texture " + std::to_string(upload.handle));
+
+		// the staging ring left the image ready to sample, behind the tracker's back
+		m_device.getImageTracker().remove(upload.image.image);
+		m_device.getImageTracker().add(upload.image.image, texture.description.format, mipLevels, 1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// the frames in flight may still sample the old index : the new image gets an index of its own, and the old
+		// one is recycled along with its image once those frames retired
+		vkpp::BindlessHeap &heap {m_device.getBindlessHeap()};
+		vkpp::BindlessIndex index {heap.addSampledImage(view)};
+		if (texture.index != vkpp::BINDLESS_INVALID_INDEX)
+			heap.release(vkpp::BindlessType::sampledImage, texture.index);
+
+		s_retire(texture.image, texture.view);
+		texture.image = upload.image;
+		texture.view = view;
+		texture.index = index;
+		texture.residentMip = upload.firstMip;
+		++m_statistics.swapCount;
+
+		if (texture.requestedMip < texture.residentMip)
+		{
+			texture.queued = true;
+			m_requests.push({texture.priority, upload.handle});
+			return;
+		}
+
+		auto requestTime {m_requestTimes.find(upload.handle)};
+		if (requestTime != m_requestTimes.end())
+		{
+			double latency {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - requestTime->second).count()};
+			m_statistics.maxLatency = std::max(m_statistics.maxLatency, latency);
+			m_requestTimes.erase(requestTime);
+		}
+	}
+
+
+
+	void TextureStreamer::s_retire(const vkpp::Image &image, VkImageView view)
+	{
+		if (image.image == VK_NULL_HANDLE)
+			return;
+
+		m_statistics.residentBytes -= image.allocation.size;
+
+		m_device.getDeletionQueue().retire([&device = m_device, image = image, view]() mutable {
+			if (view != VK_NULL_HANDLE)
+				device.getDispatch().vkDestroyImageView(device.get(), view, nullptr);
+
+			device.getAllocator().destroyImage(image);
+		});
+	}
+
+
+
+	void TextureStreamer::s_erase(vkpp::StreamedTextureHandle handle)
+	{
+		auto found {m_textures.find(handle)};
+		if (found == m_textures.end())
+			return;
+
+		if (found->second.index != vkpp::BINDLESS_INVALID_INDEX)
+			m_device.getBindlessHeap().release(vkpp::BindlessType::sampledImage, found->second.index);
+
+		s_retire(found->second.image, found->second.view);
+		m_textures.erase(found);
+		m_requestTimes.erase(handle);
+	}
+
+
+
+	void TextureStreamer::s_updateImmediate()
+	{
+		if (m_device.getDispatch().vkResetCommandPool(m_device.get(), m_acquirePool, 0) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't reset texture streamer acquire command pool");
+
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (m_device.getDispatch().vkBeginCommandBuffer(m_acquireCommandBuffer, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't begin texture streamer acquire command buffer");
+
+		this->update(m_acquireCommandBuffer);
+
+		if (m_device.getDispatch().vkEndCommandBuffer(m_acquireCommandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't end texture streamer acquire command buffer");
+
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_acquireCommandBuffer;
+
+		if (m_device.getDispatch().vkQueueSubmit(m_device.getQueue(vkpp::QueueType::graphics), 1, &submitInfo, m_acquireFence) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't submit texture streamer acquires");
+
+		// the swapped indices may be used as soon as flush() returns
+		if (m_device.getDispatch().vkWaitForFences(m_device.get(), 1, &m_acquireFence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+			throw std::runtime_error("VKPP : Can't wait for texture streamer acquires");
+
+		m_device.getDispatch().vkResetFences(m_device.get(), 1, &m_acquireFence);
+	}
+
+
+
+} // namespace vkpp
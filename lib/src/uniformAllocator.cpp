@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "uniformAllocator.hpp"
+#include "device.hpp"
+
+
+
+namespace vkpp
+{
+	UniformAllocator::UniformAllocator(vkpp::Device &device, uint32_t framesInFlight, VkDeviceSize frameSize, VkBufferUsageFlags usage) :
+		m_device {device},
+		m_alignment {device.getPhysicalDevice().getProperties().limits.minUniformBufferOffsetAlignment},
+		m_frameSize {0},
+		m_framesInFlight {framesInFlight},
+		m_buffer {},
+		m_deviceLocal {false},
+		m_frameOffset {0},
+		m_head {0},
+		m_allocationCount {0},
+		m_statistics {}
+	{
+		if (framesInFlight == 0)
+			throw std::runtime_error("VKPP : Uniform allocator needs at least one frame");
+
+		if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+			m_alignment = std::max(m_alignment, m_device.getPhysicalDevice().getProperties().limits.minStorageBufferOffsetAlignment);
+
+		// Vulkan alignments are powers of two
+		m_alignment = std::max<VkDeviceSize> (m_alignment, 16);
+		m_frameSize = (frameSize + m_alignment - 1) & ~(m_alignment - 1);
+
+		if (m_frameSize * framesInFlight > std::numeric_limits<uint32_t>::max())
+			throw std::runtime_error("VKPP : Uniform allocator can't exceed the 4 GiB dynamic offsets can reach");
+
+		VkMemoryPropertyFlags required {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+		VkMemoryPropertyFlags preferred {m_device.getPhysicalDevice().hasResizableBar() ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0u};
+		m_buffer = m_device.getAllocator().createBuffer(m_frameSize * framesInFlight, usage, required, preferred);
+
+		const VkPhysicalDeviceMemoryProperties &memoryProperties {m_device.getPhysicalDevice().getMemoryProperties()};
+		m_deviceLocal = memoryProperties.memoryTypes[m_buffer.allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	}
+
+
+
+	UniformAllocator::~UniformAllocator()
+	{
+		m_device.getAllocator().destroyBuffer(m_buffer);
+	}
+
+
+
+	void UniformAllocator::beginFrame(uint32_t frameIndex)
+	{
+		if (frameIndex >= m_framesInFlight)
+			throw std::runtime_error("VKPP : Uniform allocator has no frame " + std::to_string(frameIndex));
+
+		VkDeviceSize used {std::min(m_head.load(std::memory_order_relaxed), m_frameSize)};
+		m_statistics.allocationCount += m_allocationCount.exchange(0, std::memory_order_relaxed);
+		m_statistics.allocatedBytes += used;
+		m_statistics.peakFrameBytes = std::max(m_statistics.peakFrameBytes, used);
+
+		m_frameOffset = frameIndex * m_frameSize;
+		m_head.store(0, std::memory_order_relaxed);
+	}
+
+
+
+	vkpp::UniformAllocation UniformAllocator::allocate(VkDeviceSize size)
+	{
+		VkDeviceSize alignedSize {(size + m_alignment - 1) & ~(m_alignment - 1)};
+		VkDeviceSize offset {m_head.fetch_add(alignedSize, std::memory_order_relaxed)};
+
+		if (offset + alignedSize > m_frameSize)
+			throw std::runtime_error("VKPP : Uniform allocator's " + std::to_string(m_frameSize) + " bytes frame region is full");
+
+		m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+		VkDeviceSize bufferOffset {m_frameOffset + offset};
+		return {m_buffer.buffer, static_cast<uint32_t> (bufferOffset), static_cast<std::byte*> (m_buffer.allocation.mapped) + bufferOffset};
+	}
+
+
+
+	vkpp::UniformAllocation UniformAllocator::push(const void *data, VkDeviceSize size)
+	{
+		vkpp::UniformAllocation allocation {this->allocate(size)};
+		std::memcpy(allocation.data, data, size);
+		return allocation;
+	}
+
+
+
+	void UniformAllocator::resetStatistics() noexcept
+	{
+		m_statistics = {};
+	}
+
+
+
+} // namespace vkpp
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <utility>
+
+#include "utils/threadPool.hpp"
+
+
+
+namespace vkpp::utils
+{
+	namespace
+	{
+		// lets submit() know whether it runs on one of the pool's workers
+		thread_local const vkpp::utils::ThreadPool *currentPool {nullptr};
+		thread_local uint32_t currentWorker {0};
+	}
+
+
+
+	ThreadPool::ThreadPool(uint32_t threadCount) :
+		m_threads {},
+		m_queues {},
+		m_nextQueue {0},
+		m_queued {0},
+		m_pending {0},
+		m_stealCount {0},
+		m_mutex {},
+		m_jobAvailable {},
+		m_idle {},
+		m_stop {false},
+		m_exception {}
+	{
+		threadCount = std::max<uint32_t> (threadCount, 1);
+		m_threads.reserve(threadCount);
+		m_queues.reserve(threadCount);
+
+		for (uint32_t i {0}; i < threadCount; i++)
+			m_queues.push_back(std::make_unique<vkpp::utils::WorkQueue> ());
+
+		for (uint32_t i {0}; i < threadCount; i++)
+			m_threads.emplace_back(&ThreadPool::s_work, this, i);
+	}
+
+
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			m_stop = true;
+		}
+
+		m_jobAvailable.notify_all();
+
+		for (auto &thread : m_threads)
+			thread.join();
+	}
+
+
+
+	void ThreadPool::submit(vkpp::utils::ThreadPool::Job job)
+	{
+		uint32_t queue {currentPool == this
+			? currentWorker
+			: m_nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t> (m_queues.size())
+		};
+
+		++m_pending;
+
+		{
+			// counted before being pushed so that a worker popping it never sees the count underflow, and under
+			// the lock so that a worker can't miss the notification between its check and its wait
+			std::lock_guard<std::mutex> lock {m_mutex};
+			++m_queued;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock {m_queues[queue]->mutex};
+			m_queues[queue]->jobs.push_back(std::move(job));
+		}
+
+		m_jobAvailable.notify_one();
+	}
+
+
+
+	void ThreadPool::wait()
+	{
+		std::unique_lock<std::mutex> lock {m_mutex};
+		m_idle.wait(lock, [this] {return m_pending == 0;});
+
+		if (m_exception)
+			std::rethrow_exception(std::exchange(m_exception, nullptr));
+	}
+
+
+
+	void ThreadPool::s_work(uint32_t index)
+	{
+		currentPool = this;
+		currentWorker = index;
+
+		vkpp::utils::ThreadPool::Job job {};
+
+		for (;;)
+		{
+			if (!s_pop(index, job))
+			{
+				std::unique_lock<std::mutex> lock {m_mutex};
+				m_jobAvailable.wait(lock, [this] {return m_stop || m_queued != 0;});
+
+				if (m_stop && m_queued == 0)
+					return;
+
+				continue;
+			}
+
+			try
+			{
+				job(index);
+			}
+
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock {m_mutex};
+				if (!m_exception)
+					m_exception = std::current_exception();
+			}
+
+			job = nullptr;
+
+			if (--m_pending == 0)
+			{
+				std::lock_guard<std::mutex> lock {m_mutex};
+				m_idle.notify_all();
+			}
+		}
+	}
+
+
+
+	bool ThreadPool::s_pop(uint32_t index, vkpp::utils::ThreadPool::Job &job)
+	{
+		uint32_t count {static_cast<uint32_t> (m_queues.size())};
+
+		for (uint32_t i {0}; i < count; i++)
+		{
+			vkpp::utils::WorkQueue &queue {*m_queues[(index + i) % count]};
+			std::lock_guard<std::mutex> lock {queue.mutex};
+
+			if (queue.jobs.empty())
+				continue;
+
+			// the owner takes its most recent job, thieves the oldest one
+			if (i == 0)
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+			}
+
+			else
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				++m_stealCount;
+			}
+
+			--m_queued;
+			return true;
+		}
+
+		return false;
+	}
+
+
+
+} // namespace vkpp::utils
@@ -1,6 +1,11 @@
 workspace "NickelLib"
 	configurations {"debug", "release"}
 
+newoption {
+	trigger = "dynamic-vulkan",
+	description = "Load libvulkan at runtime through SDL instead of linking vulkan-1"
+}
+
 
 project "lib"
 	kind "StaticLib"
@@ -37,6 +42,9 @@ project "lib"
 		defines {"NDEBUG", "VKPP_NO_DEBUG", "VKPP_RELEASE"}
 		optimize "On"
 
+	filter "options:dynamic-vulkan"
+		defines {"VKPP_DYNAMIC_VULKAN", "VK_NO_PROTOTYPES"}
+
 	filter "system:Windows"
 		defines {"VKPP_PLATEFORM_WINDOWS"}
 
@@ -96,6 +104,10 @@ project "Sandbox"
 	filter {"system:Windows", "toolset:gcc"}
 		links "mingw32"
 
+	filter "options:dynamic-vulkan"
+		defines {"VKPP_DYNAMIC_VULKAN", "VK_NO_PROTOTYPES"}
+		removelinks "vulkan-1"
+
 	filter "configurations:debug"
 		defines {"DEBUG", "PL_DEBUG"}
 		symbols "On"
@@ -114,5 +126,37 @@ project "Sandbox"
 		defines {"PL_PLATEFORM_MACOS"}
 
 
+project "Packer"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "c++20"
+	targetdir "tools/packer/bin"
+	objdir "tools/packer/obj"
+	targetname "packer"
+	warnings "Extra"
 
+	files {
+		"tools/packer/src/**.cpp"
+	}
 
+	includedirs {
+		"lib/include",
+		"vendors/vulkan/include",
+	}
+
+	libdirs {
+		"lib/bin"
+	}
+
+	-- the writer makes no Vulkan call, the pack format only needs the headers
+	links {
+		"vulkanpp"
+	}
+
+	filter "configurations:debug"
+		defines {"DEBUG"}
+		symbols "On"
+
+	filter "configurations:release"
+		defines {"NDEBUG"}
+		optimize "On"
@@ -1,6 +1,20 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #define SDL_MAIN_HANDLED
 #include <SDL2/SDL.h>
@@ -10,33 +24,1133 @@
 
 
 
-int main(int, char *[])
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT {3};
+constexpr uint32_t BENCHMARK_FRAMES {300};
+/// Below the 4096 device memory allocations most drivers allow at once, for the one allocation per buffer reference
+constexpr uint32_t BENCHMARK_ALLOCATIONS {2048};
+constexpr VkDeviceSize BENCHMARK_ALLOCATION_SIZE {16 * 1024};
+constexpr uint32_t BENCHMARK_MESHES {10000};
+constexpr VkDeviceSize BENCHMARK_MESH_SIZE {4 * 1024};
+constexpr uint32_t BENCHMARK_DRAWS {100000};
+constexpr uint32_t BENCHMARK_RECORD_JOBS {256};
+constexpr uint32_t BENCHMARK_DISPATCH_CALLS {1000000};
+constexpr uint32_t BENCHMARK_SUBMITS {10000};
+constexpr uint32_t BENCHMARK_SUBMITS_PER_BATCH {16};
+constexpr uint32_t BENCHMARK_GRAPH_IMAGES {8};
+constexpr uint32_t BENCHMARK_GRAPH_IMAGE_SIZE {1024};
+constexpr uint32_t BENCHMARK_TRACKER_IMAGES {64};
+constexpr uint32_t BENCHMARK_BINDLESS_DESCRIPTORS {50000};
+constexpr uint32_t BENCHMARK_DESCRIPTOR_SETS {50000};
+constexpr uint32_t BENCHMARK_DESCRIPTOR_FRAMES {30};
+constexpr VkDeviceSize BENCHMARK_UNIFORM_FRAME_SIZE {32 * 1024 * 1024};
+/// Dedicated allocations and suballocations of the allocator's blocks
+constexpr VkDeviceSize BENCHMARK_RESIDENCY_BUFFER_SIZES[] {64 * 1024 * 1024, 1024 * 1024};
+constexpr VkDeviceSize BENCHMARK_RESIDENCY_FRAME_BYTES {64 * 1024 * 1024};
+constexpr uint32_t BENCHMARK_RESIDENCY_MAX_FRAMES {1000};
+/// Frames whose buffers stay in use
+constexpr uint32_t BENCHMARK_RESIDENCY_WORKING_SET {4};
+constexpr uint32_t BENCHMARK_DEFRAG_BUFFERS {8192};
+constexpr VkDeviceSize BENCHMARK_DEFRAG_BUFFER_SIZE {64 * 1024};
+constexpr uint32_t BENCHMARK_STREAMED_TEXTURES {64};
+constexpr uint32_t BENCHMARK_STREAMED_TEXTURE_SIZE {1024};
+/// Simulated disk throughput, in bytes per millisecond
+constexpr uint64_t BENCHMARK_STREAMING_DISK_SPEED {500 * 1024};
+constexpr uint32_t BENCHMARK_STREAMING_MAX_FRAMES {10000};
+constexpr uint32_t BENCHMARK_ASSETS {256};
+constexpr size_t BENCHMARK_ASSET_SIZE {1024 * 1024};
+
+
+VkCommandBuffer recordFrame(vkpp::CommandContext &commands, vkpp::GpuProfiler &profiler, const vkpp::FrameContext &frame)
+{
+	VkCommandBuffer commandBuffer {commands.beginFrame(frame.index)};
+	profiler.beginFrame(commandBuffer, frame.index, frame.number);
+
+	{
+		vkpp::ScopedMarker marker {profiler, commandBuffer, "present barrier"};
+
+		VkImageMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = frame.finalLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = frame.image;
+		barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+		commands.getDevice().getDispatch().vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier
+		);
+	}
+
+	return commands.endFrame();
+}
+
+
+void benchmarkFramesInFlight(vkpp::Instance &instance, vkpp::CommandContext &commands, vkpp::GpuProfiler &profiler)
+{
+	vkpp::SwapChain &swapChain {instance.getSwapChain()};
+	SDL_Event event {};
+
+	for (uint32_t framesInFlight {1}; framesInFlight <= MAX_FRAMES_IN_FLIGHT; framesInFlight++)
+	{
+		swapChain.setFramesInFlight(framesInFlight);
+		swapChain.resetStatistics();
+
+		for (uint32_t i {0}; i < BENCHMARK_FRAMES; i++)
+		{
+			while (SDL_PollEvent(&event));
+
+			const vkpp::FrameContext &frame {swapChain.beginFrame()};
+			swapChain.endFrame({recordFrame(commands, profiler, frame)});
+		}
+
+		const vkpp::FrameStatistics &statistics {swapChain.getStatistics()};
+		std::clog << framesInFlight << " frame(s) in flight : "
+			<< "cpu frame " << statistics.cpuFrameTime / static_cast<double> (std::max<uint64_t> (statistics.frameCount, 2) - 1) << " ms, "
+			<< "fence wait " << statistics.fenceWaitTime / statistics.frameCount << " ms, "
+			<< "gpu starved on " << 100.0 * statistics.gpuStarvedFrames / statistics.frameCount << " % of frames"
+			<< std::endl;
+	}
+
+	swapChain.setFramesInFlight(instance.getParameters().framesInFlight);
+}
+
+
+void benchmarkAllocator(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	const vkpp::DeviceDispatch &dispatch {device.getDispatch()};
+	vkpp::Allocator &allocator {device.getAllocator()};
+
+	// the same buffers either way, only where their memory comes from differs
+	std::vector<vkpp::Buffer> buffers (BENCHMARK_ALLOCATIONS);
+
+	auto start {std::chrono::steady_clock::now()};
+	for (auto &buffer : buffers)
+		buffer = allocator.createBuffer(BENCHMARK_ALLOCATION_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	auto suballocatedCreate {std::chrono::steady_clock::now() - start};
+
+	vkpp::AllocatorStatistics statistics {allocator.getStatistics()};
+
+	start = std::chrono::steady_clock::now();
+	for (auto &buffer : buffers)
+		allocator.destroyBuffer(buffer);
+	auto suballocatedDestroy {std::chrono::steady_clock::now() - start};
+
+	VkBufferCreateInfo createInfo {};
+	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	createInfo.size = BENCHMARK_ALLOCATION_SIZE;
+	createInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	std::vector<VkBuffer> rawBuffers (BENCHMARK_ALLOCATIONS, VK_NULL_HANDLE);
+	std::vector<VkDeviceMemory> memories (BENCHMARK_ALLOCATIONS, VK_NULL_HANDLE);
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i {0}; i < BENCHMARK_ALLOCATIONS; i++)
+	{
+		if (dispatch.vkCreateBuffer(device.get(), &createInfo, nullptr, &rawBuffers[i]) != VK_SUCCESS)
+			throw std::runtime_error("Can't create an allocator benchmark buffer");
+
+		VkMemoryRequirements requirements {};
+		dispatch.vkGetBufferMemoryRequirements(device.get(), rawBuffers[i], &requirements);
+
+		VkMemoryAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = requirements.size;
+		allocateInfo.memoryTypeIndex = allocator.findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (dispatch.vkAllocateMemory(device.get(), &allocateInfo, nullptr, &memories[i]) != VK_SUCCESS)
+			throw std::runtime_error("Can't allocate allocator benchmark memory");
+
+		if (dispatch.vkBindBufferMemory(device.get(), rawBuffers[i], memories[i], 0) != VK_SUCCESS)
+			throw std::runtime_error("Can't bind allocator benchmark memory");
+	}
+	auto rawCreate {std::chrono::steady_clock::now() - start};
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i {0}; i < BENCHMARK_ALLOCATIONS; i++)
+	{
+		dispatch.vkDestroyBuffer(device.get(), rawBuffers[i], nullptr);
+		dispatch.vkFreeMemory(device.get(), memories[i], nullptr);
+	}
+	auto rawDestroy {std::chrono::steady_clock::now() - start};
+
+	std::clog << BENCHMARK_ALLOCATIONS << " buffers of " << BENCHMARK_ALLOCATION_SIZE << " bytes : "
+		<< "suballocated " << std::chrono::duration<double, std::milli> (suballocatedCreate).count() << " ms to create, "
+		<< std::chrono::duration<double, std::milli> (suballocatedDestroy).count() << " ms to destroy, in "
+		<< statistics.blockCount << " block(s) ; one vkAllocateMemory each "
+		<< std::chrono::duration<double, std::milli> (rawCreate).count() << " ms to create, "
+		<< std::chrono::duration<double, std::milli> (rawDestroy).count() << " ms to destroy"
+		<< std::endl;
+}
+
+
+void benchmarkUploads(vkpp::Instance &instance)
 {
+	vkpp::Device &device {instance.getDevice()};
+	// the ring consumes its own uploads so that no ownership transfer is left pending once the meshes are destroyed
+	vkpp::StagingRing ring {device, instance.getParameters().stagingRingSize, vkpp::QueueType::transfer, vkpp::QueueType::transfer};
+
+	std::vector<std::byte> data(BENCHMARK_MESH_SIZE, std::byte {0x2a});
+	std::vector<vkpp::Buffer> meshes {};
+	meshes.reserve(BENCHMARK_MESHES);
+
+	for (uint32_t i {0}; i < BENCHMARK_MESHES; i++)
+	{
+		meshes.push_back(device.getAllocator().createBuffer(
+			BENCHMARK_MESH_SIZE,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		));
+	}
+
+	auto start {std::chrono::steady_clock::now()};
+	for (auto &mesh : meshes)
+		ring.upload(mesh.buffer, 0, data.data(), data.size());
+	ring.wait(ring.flush());
+	auto batched {std::chrono::steady_clock::now() - start};
+
+	start = std::chrono::steady_clock::now();
+	for (auto &mesh : meshes)
+	{
+		ring.upload(mesh.buffer, 0, data.data(), data.size());
+		ring.wait(ring.flush());
+	}
+	auto perUpload {std::chrono::steady_clock::now() - start};
+
+	std::clog << BENCHMARK_MESHES << " uploads of " << BENCHMARK_MESH_SIZE << " bytes : "
+		<< "batched " << std::chrono::duration<double, std::milli> (batched).count() << " ms, "
+		<< "one submission per upload " << std::chrono::duration<double, std::milli> (perUpload).count() << " ms"
+		<< std::endl;
+
+	for (auto &mesh : meshes)
+		device.getAllocator().destroyBuffer(mesh);
+}
+
+
+void benchmarkRecording(vkpp::Instance &instance)
+{
+	// no pipeline exists yet, so every synthetic draw records its dynamic viewport and scissor instead
+	VkViewport viewport {0.f, 0.f, 16.f * 70.f, 9.f * 70.f, 0.f, 1.f};
+	VkRect2D scissor {{0, 0}, {16 * 70, 9 * 70}};
+	const vkpp::DeviceDispatch &dispatch {instance.getDevice().getDispatch()};
+	double singleThreaded {0.0};
+
+	for (uint32_t threadCount {1}; threadCount <= std::thread::hardware_concurrency(); threadCount *= 2)
+	{
+		vkpp::CommandContext context {instance.getDevice(), vkpp::QueueType::graphics, 1, threadCount};
+
+		// the first frame allocates the secondaries, the measured one only reuses them
+		std::chrono::steady_clock::duration elapsed {};
+		for (uint32_t run {0}; run < 2; run++)
+		{
+			auto start {std::chrono::steady_clock::now()};
+
+			context.beginFrame(0);
+			context.recordParallel(BENCHMARK_RECORD_JOBS, [&](VkCommandBuffer commandBuffer, uint32_t job) {
+				uint32_t first {BENCHMARK_DRAWS * job / BENCHMARK_RECORD_JOBS};
+				uint32_t last {BENCHMARK_DRAWS * (job + 1) / BENCHMARK_RECORD_JOBS};
+
+				for (uint32_t draw {first}; draw < last; draw++)
+				{
+					dispatch.vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+					dispatch.vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+				}
+			});
+			context.endFrame();
+
+			elapsed = std::chrono::steady_clock::now() - start;
+		}
+
+		double milliseconds {std::chrono::duration<double, std::milli> (elapsed).count()};
+		if (threadCount == 1)
+			singleThreaded = milliseconds;
+
+		std::clog << BENCHMARK_DRAWS << " draws recorded on " << threadCount << " thread(s) : "
+			<< milliseconds << " ms, speedup x" << singleThreaded / milliseconds << std::endl;
+	}
+}
+
+
+void benchmarkDispatch(vkpp::Instance &instance)
+{
+	vkpp::CommandContext context {instance.getDevice(), vkpp::QueueType::graphics, 1, 1};
+	const vkpp::DeviceDispatch &dispatch {instance.getDevice().getDispatch()};
+	VkViewport viewport {0.f, 0.f, 16.f * 70.f, 9.f * 70.f, 0.f, 1.f};
+
+	auto record = [&](auto &&setViewport) {
+		VkCommandBuffer commandBuffer {context.beginFrame(0)};
+		auto start {std::chrono::steady_clock::now()};
+
+		for (uint32_t i {0}; i < BENCHMARK_DISPATCH_CALLS; i++)
+			setViewport(commandBuffer, 0, 1, &viewport);
+
+		auto elapsed {std::chrono::steady_clock::now() - start};
+		context.endFrame();
+		return std::chrono::duration<double, std::milli> (elapsed).count();
+	};
+
+	double direct {record(dispatch.vkCmdSetViewport)};
+	std::clog << BENCHMARK_DISPATCH_CALLS << " vkCmdSetViewport through the device dispatch table : " << direct << " ms" << std::endl;
+
+	#ifndef VKPP_DYNAMIC_VULKAN
+		double trampoline {record(vkCmdSetViewport)};
+		std::clog << BENCHMARK_DISPATCH_CALLS << " vkCmdSetViewport through the loader trampoline : " << trampoline << " ms ("
+			<< 100.0 * (trampoline - direct) / direct << " % overhead)" << std::endl;
+	#endif
+}
+
+
+void benchmarkScheduler(vkpp::Instance &instance)
+{
+	if (!instance.getDevice().hasScheduler())
+	{
+		std::clog << "Scheduler benchmark skipped : the device doesn't run Vulkan 1.2" << std::endl;
+		return;
+	}
+
+	vkpp::Scheduler &scheduler {instance.getDevice().getScheduler()};
+
+	// every submit of a batch waits on the previous one of the transfer queue, as uploads feeding a frame would
+	auto run = [&](uint32_t submitsPerFlush) {
+		scheduler.waitIdle();
+		scheduler.resetStatistics();
+		auto start {std::chrono::steady_clock::now()};
+
+		for (uint32_t i {0}; i < BENCHMARK_SUBMITS; i++)
+		{
+			vkpp::TimelinePoint upload {scheduler.submit(vkpp::QueueType::transfer, {})};
+			scheduler.submit(vkpp::QueueType::graphics, {{}, {{upload, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT}}});
+
+			if ((i + 1) % submitsPerFlush == 0)
+				scheduler.flush();
+		}
+
+		scheduler.waitIdle();
+		return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+	};
+
+	for (uint32_t submitsPerFlush : {1u, BENCHMARK_SUBMITS_PER_BATCH})
+	{
+		double elapsed {run(submitsPerFlush)};
+		std::clog << 2 * BENCHMARK_SUBMITS << " dependent submits, " << submitsPerFlush << " per flush : " << elapsed << " ms, "
+			<< scheduler.getStatistics().batchCount << " vkQueueSubmit calls" << std::endl;
+	}
+}
+
+
+void benchmarkRenderGraph(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	const vkpp::DeviceDispatch &dispatch {device.getDispatch()};
+	vkpp::CommandContext context {device, vkpp::QueueType::graphics, 1, 1};
+
+	VkExtent3D extent {BENCHMARK_GRAPH_IMAGE_SIZE, BENCHMARK_GRAPH_IMAGE_SIZE, 1};
+	VkDeviceSize imageSize {4ull * BENCHMARK_GRAPH_IMAGE_SIZE * BENCHMARK_GRAPH_IMAGE_SIZE};
+	vkpp::Buffer output {device.getAllocator().createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)};
+
+	VkBufferImageCopy region {};
+	region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.imageExtent = extent;
+	VkClearColorValue clearColor {{0.2f, 0.4f, 0.8f, 1.f}};
+	VkImageSubresourceRange range {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+	// a chain of images bounced through a buffer, no pipeline being available yet, and a pass nothing reads
+	auto declare = [&](vkpp::RenderGraph &graph) {
+		std::vector<vkpp::RenderGraphResource> images {};
+		for (uint32_t i {0}; i < BENCHMARK_GRAPH_IMAGES; i++)
+			images.push_back(graph.createImage("chain " + std::to_string(i), {VK_FORMAT_R8G8B8A8_UNORM, extent}));
+
+		vkpp::RenderGraphResource bounce {graph.createBuffer("bounce", {imageSize})};
+		vkpp::RenderGraphResource unused {graph.createImage("unused", {VK_FORMAT_R8G8B8A8_UNORM, extent})};
+		vkpp::RenderGraphResource result {graph.importBuffer("output", output.buffer, imageSize)};
+
+		graph.addPass("clear", [&](vkpp::RenderGraphPassBuilder &builder) {
+			builder.write(images[0], vkpp::ResourceUsage::transferDestination);
+		}, [=, &dispatch](VkCommandBuffer commandBuffer, const vkpp::RenderGraph &graph) {
+			dispatch.vkCmdClearColorImage(commandBuffer, graph.getImage(images[0]), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
+		});
+
+		graph.addPass("unused", [&](vkpp::RenderGraphPassBuilder &builder) {
+			builder.write(unused, vkpp::ResourceUsage::transferDestination);
+		}, [=, &dispatch](VkCommandBuffer commandBuffer, const vkpp::RenderGraph &graph) {
+			dispatch.vkCmdClearColorImage(commandBuffer, graph.getImage(unused), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
+		});
+
+		for (uint32_t i {0}; i + 1 < BENCHMARK_GRAPH_IMAGES; i++)
+		{
+			graph.addPass("download " + std::to_string(i), [&](vkpp::RenderGraphPassBuilder &builder) {
+				builder.read(images[i], vkpp::ResourceUsage::transferSource);
+				builder.write(bounce, vkpp::ResourceUsage::transferDestination);
+			}, [=, &dispatch](VkCommandBuffer commandBuffer, const vkpp::RenderGraph &graph) {
+				dispatch.vkCmdCopyImageToBuffer(commandBuffer, graph.getImage(images[i]), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, graph.getBuffer(bounce), 1, &region);
+			});
+
+			graph.addPass("upload " + std::to_string(i + 1), [&](vkpp::RenderGraphPassBuilder &builder) {
+				builder.read(bounce, vkpp::ResourceUsage::transferSource);
+				builder.write(images[i + 1], vkpp::ResourceUsage::transferDestination);
+			}, [=, &dispatch](VkCommandBuffer commandBuffer, const vkpp::RenderGraph &graph) {
+				dispatch.vkCmdCopyBufferToImage(commandBuffer, graph.getBuffer(bounce), graph.getImage(images[i + 1]), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			});
+		}
+
+		graph.addPass("output", [&](vkpp::RenderGraphPassBuilder &builder) {
+			builder.read(images.back(), vkpp::ResourceUsage::transferSource);
+			builder.write(result, vkpp::ResourceUsage::transferDestination);
+		}, [=, &dispatch](VkCommandBuffer commandBuffer, const vkpp::RenderGraph &graph) {
+			dispatch.vkCmdCopyImageToBuffer(commandBuffer, graph.getImage(images.back()), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, graph.getBuffer(result), 1, &region);
+		});
+	};
+
+	for (auto mode : {vkpp::BarrierMode::naive, vkpp::BarrierMode::merged})
+	{
+		vkpp::RenderGraph graph {device, mode};
+		double recordTime {0.0};
+		auto start {std::chrono::steady_clock::now()};
+
+		for (uint32_t i {0}; i < BENCHMARK_FRAMES; i++)
+		{
+			// redeclared every frame as an application would, the topology stays cached
+			auto recordStart {std::chrono::steady_clock::now()};
+			graph.reset();
+			declare(graph);
+
+			VkCommandBuffer commandBuffer {context.beginFrame(0)};
+			graph.execute(commandBuffer);
+			context.endFrame();
+			recordTime += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - recordStart).count();
+
+			VkSubmitInfo submitInfo {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &commandBuffer;
+
+			if (dispatch.vkQueueSubmit(device.getQueue(vkpp::QueueType::graphics), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+				throw std::runtime_error("Can't submit the render graph benchmark");
+			dispatch.vkDeviceWaitIdle(device.get());
+		}
+
+		double elapsed {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+		const vkpp::RenderGraphStatistics &statistics {graph.getStatistics()};
+
+		std::clog << "Render graph with " << (mode == vkpp::BarrierMode::naive ? "naive" : "merged") << " barriers : "
+			<< statistics.passCount << " passes (" << statistics.culledPassCount << " culled), "
+			<< statistics.pipelineBarrierCount << " vkCmdPipelineBarrier with " << statistics.imageBarrierCount << " image and "
+			<< statistics.memoryBarrierCount << " memory barriers, " << statistics.compileCount << " compilation(s), "
+			<< statistics.allocatedBytes / (1024 * 1024) << " MiB for " << statistics.transientBytes / (1024 * 1024) << " MiB of transients, "
+			<< elapsed / BENCHMARK_FRAMES << " ms per frame, " << recordTime / BENCHMARK_FRAMES << " ms recording" << std::endl;
+	}
+
+	device.getAllocator().destroyBuffer(output);
+}
+
+
+void benchmarkImageTracker(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	const vkpp::DeviceDispatch &dispatch {device.getDispatch()};
+	vkpp::CommandContext fixups {device, vkpp::QueueType::graphics, 1, 1};
+	vkpp::CommandContext context {device, vkpp::QueueType::graphics, 1, 1};
+	vkpp::LocalImageTracker local {device.getImageTracker()};
+
+	VkImageCreateInfo createInfo {};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+	createInfo.extent = {BENCHMARK_GRAPH_IMAGE_SIZE, BENCHMARK_GRAPH_IMAGE_SIZE, 1};
+	createInfo.mipLevels = 1;
+	createInfo.arrayLayers = 1;
+	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	createInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	std::vector<vkpp::Image> images (BENCHMARK_TRACKER_IMAGES);
+	for (auto &image : images)
+		image = device.getAllocator().createImage(createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// every image is rendered to, then sampled by three passes : a barrier per use without tracking, only the
+	// layout changes with it, the first of a frame resolved against the previous frame's state at submission
+	constexpr std::pair<vkpp::ResourceUsage, bool> PASSES[] {
+		{vkpp::ResourceUsage::colorAttachment, true},
+		{vkpp::ResourceUsage::sampled, false},
+		{vkpp::ResourceUsage::sampled, false},
+		{vkpp::ResourceUsage::sampled, false}
+	};
+
+	device.getImageTracker().resetStatistics();
+	uint64_t resolvedCount {0};
+	double recordTime {0.0};
+
+	for (uint32_t i {0}; i < BENCHMARK_FRAMES; i++)
+	{
+		auto start {std::chrono::steady_clock::now()};
+		VkCommandBuffer commandBuffer {context.beginFrame(0)};
+		for (const auto &[usage, write] : PASSES)
+		{
+			for (const auto &image : images)
+				local.use(image.image, usage, write);
+
+			local.flush(commandBuffer);
+		}
+		context.endFrame();
+
+		VkCommandBuffer fixup {fixups.beginFrame(0)};
+		resolvedCount += device.getImageTracker().resolve(local, fixup);
+		fixups.endFrame();
+		local.reset();
+		recordTime += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+		VkCommandBuffer commandBuffers[] {fixup, commandBuffer};
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 2;
+		submitInfo.pCommandBuffers = commandBuffers;
+
+		if (dispatch.vkQueueSubmit(device.getQueue(vkpp::QueueType::graphics), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("Can't submit the image tracker benchmark");
+		dispatch.vkDeviceWaitIdle(device.get());
+	}
+
+	const vkpp::ImageTrackerStatistics &statistics {local.getStatistics()};
+	uint64_t useCount {static_cast<uint64_t> (BENCHMARK_FRAMES) * BENCHMARK_TRACKER_IMAGES * std::size(PASSES)};
+	std::clog << "Image tracking of " << BENCHMARK_TRACKER_IMAGES << " images over " << BENCHMARK_FRAMES << " frames : "
+		<< statistics.barrierCount + resolvedCount << " barriers for " << useCount << " uses (" << statistics.skippedCount
+		<< " skipped while recording, " << device.getImageTracker().getStatistics().skippedCount << " at submission), "
+		<< statistics.pipelineBarrierCount + device.getImageTracker().getStatistics().pipelineBarrierCount
+		<< " vkCmdPipelineBarrier, " << recordTime / BENCHMARK_FRAMES << " ms recording per frame" << std::endl;
+
+	for (auto &image : images)
+		device.getAllocator().destroyImage(image);
+}
+
+
+void benchmarkBindless(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	if (!device.hasBindless())
+	{
+		std::clog << "Bindless benchmark skipped, the device lacks descriptor indexing" << std::endl;
+		return;
+	}
+
+	vkpp::BindlessHeap &heap {device.getBindlessHeap()};
+	VkDeviceSize sliceSize {256};
+	vkpp::Buffer buffer {device.getAllocator().createBuffer(
+		sliceSize * BENCHMARK_BINDLESS_DESCRIPTORS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+	)};
+
+	heap.resetStatistics();
+	std::vector<vkpp::BindlessIndex> indices {};
+	indices.reserve(BENCHMARK_BINDLESS_DESCRIPTORS);
+
+	// a slice per object, as a scene with that many draws would register its per object data
+	auto start {std::chrono::steady_clock::now()};
+	for (uint32_t i {0}; i < BENCHMARK_BINDLESS_DESCRIPTORS; i++)
+		indices.push_back(heap.addStorageBuffer(buffer.buffer, i * sliceSize, sliceSize));
+
+	heap.flush();
+	double elapsed {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+
+	const vkpp::BindlessStatistics &statistics {heap.getStatistics()};
+	std::clog << BENCHMARK_BINDLESS_DESCRIPTORS << " bindless storage buffers registered : " << elapsed << " ms, "
+		<< statistics.descriptorWriteCount << " descriptors in " << statistics.writeCount << " write(s) over "
+		<< statistics.flushCount << " vkUpdateDescriptorSets" << std::endl;
+
+	for (auto index : indices)
+		heap.release(vkpp::BindlessType::storageBuffer, index);
+
+	device.getAllocator().destroyBuffer(buffer);
+}
+
+
+void benchmarkDescriptors(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	const vkpp::DeviceDispatch &dispatch {device.getDispatch()};
+
+	// a material like set, declared twice in different orders to check the cache folds them
+	vkpp::DescriptorLayoutDescription description {{
+		{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL},
+		{1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, VK_SHADER_STAGE_ALL}
+	}};
+	vkpp::DescriptorLayoutDescription reversed {{description.bindings[1], description.bindings[0]}};
+
+	VkDescriptorSetLayout layout {device.getDescriptorLayoutCache().get(description)};
+	if (device.getDescriptorLayoutCache().get(reversed) != layout)
+		throw std::runtime_error("Descriptor layout cache didn't deduplicate identical layouts");
+
+	std::vector<VkDescriptorSet> sets (BENCHMARK_DESCRIPTOR_SETS);
+
+	// reference : sets freed one by one from a single pool, as a naive renderer would
+	VkDescriptorPoolSize poolSizes[] {
+		{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, BENCHMARK_DESCRIPTOR_SETS},
+		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 * BENCHMARK_DESCRIPTOR_SETS}
+	};
+
+	VkDescriptorPoolCreateInfo poolCreateInfo {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	poolCreateInfo.maxSets = BENCHMARK_DESCRIPTOR_SETS;
+	poolCreateInfo.poolSizeCount = 2;
+	poolCreateInfo.pPoolSizes = poolSizes;
+
+	VkDescriptorPool pool {VK_NULL_HANDLE};
+	if (dispatch.vkCreateDescriptorPool(device.get(), &poolCreateInfo, nullptr, &pool) != VK_SUCCESS)
+		throw std::runtime_error("Can't create the reference descriptor pool");
+
+	VkDescriptorSetAllocateInfo allocateInfo {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = pool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &layout;
+
+	auto start {std::chrono::steady_clock::now()};
+	for (uint32_t frame {0}; frame < BENCHMARK_DESCRIPTOR_FRAMES; frame++)
+	{
+		for (auto &set : sets)
+		{
+			if (dispatch.vkAllocateDescriptorSets(device.get(), &allocateInfo, &set) != VK_SUCCESS)
+				throw std::runtime_error("Can't allocate a reference descriptor set");
+		}
+
+		for (auto set : sets)
+			dispatch.vkFreeDescriptorSets(device.get(), pool, 1, &set);
+	}
+	double individual {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+	dispatch.vkDestroyDescriptorPool(device.get(), pool, nullptr);
+
+	// no GPU work is recorded, so every frame slot is retired as soon as it comes back
+	vkpp::DescriptorAllocator allocator {device, MAX_FRAMES_IN_FLIGHT};
+	start = std::chrono::steady_clock::now();
+	for (uint32_t frame {0}; frame < BENCHMARK_DESCRIPTOR_FRAMES; frame++)
+	{
+		allocator.beginFrame(frame % MAX_FRAMES_IN_FLIGHT);
+		for (auto &set : sets)
+			set = allocator.allocate(layout);
+	}
+	double linear {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+
+	const vkpp::DescriptorAllocatorStatistics &statistics {allocator.getStatistics()};
+	std::clog << BENCHMARK_DESCRIPTOR_SETS << " descriptor sets per frame : " << individual / BENCHMARK_DESCRIPTOR_FRAMES
+		<< " ms per frame freed one by one, " << linear / BENCHMARK_DESCRIPTOR_FRAMES << " ms per frame with pool resets ("
+		<< allocator.getPoolCount() << " pools, " << statistics.resetCount << " resets, " << statistics.overflowCount << " overflows), "
+		<< device.getDescriptorLayoutCache().getSize() << " cached layout(s)" << std::endl;
+}
+
+
+void benchmarkUniforms(vkpp::Instance &instance)
+{
+	struct DrawConstants
+	{
+		float model[16];
+		float color[4];
+	};
+
+	vkpp::UniformAllocator uniforms {instance.getDevice(), MAX_FRAMES_IN_FLIGHT, BENCHMARK_UNIFORM_FRAME_SIZE};
+	DrawConstants constants {};
+	uint64_t checksum {0};
+
+	// no GPU work is recorded, so every frame slot is retired as soon as it comes back
+	auto start {std::chrono::steady_clock::now()};
+	for (uint32_t frame {0}; frame < BENCHMARK_FRAMES; frame++)
+	{
+		uniforms.beginFrame(frame % MAX_FRAMES_IN_FLIGHT);
+
+		for (uint32_t i {0}; i < BENCHMARK_DRAWS; i++)
+		{
+			constants.color[0] = static_cast<float> (i);
+			checksum += uniforms.push(constants).offset;
+		}
+	}
+	double elapsed {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+	uniforms.beginFrame(0);
+
+	const vkpp::UniformAllocatorStatistics &statistics {uniforms.getStatistics()};
+	std::clog << BENCHMARK_DRAWS << " draw constants per frame in " << (uniforms.isDeviceLocal() ? "device local" : "host") << " memory : "
+		<< elapsed / BENCHMARK_FRAMES << " ms per frame, " << elapsed * 1e6 / (static_cast<double> (BENCHMARK_FRAMES) * BENCHMARK_DRAWS)
+		<< " ns per push, " << statistics.peakFrameBytes / 1024 << " KiB per frame with " << uniforms.getAlignment()
+		<< " bytes alignment (checksum " << checksum << ")" << std::endl;
+}
+
+
+void benchmarkResidency(vkpp::Instance &instance, VkDeviceSize bufferSize)
+{
+	vkpp::Device &device {instance.getDevice()};
+	vkpp::ResidencyManager &residency {device.getResidencyManager()};
+	vkpp::MemoryBudget &budget {device.getMemoryBudget()};
+
+	// streams new buffers in every frame, only the last few frames' stay in use, until 150% of the heap's budget
+	// went through it
+	std::unordered_map<vkpp::ResidencyHandle, vkpp::Buffer*> resident {};
+	std::vector<std::vector<vkpp::ResidencyHandle>> workingSet {};
+	VkDeviceSize streamedBytes {0};
+	uint32_t heap {0};
+	float peakRatio {0.f};
+	uint64_t frame {0};
+
+	// frame numbers carry on from the frame loops', the deletion queue and residency manager never go backwards
+	uint64_t firstFrame {device.getDeletionQueue().getCurrentFrame() + 1};
+
+	residency.resetStatistics();
+	budget.resetStatistics();
+
+	auto start {std::chrono::steady_clock::now()};
+	for (; frame < BENCHMARK_RESIDENCY_MAX_FRAMES; frame++)
+	{
+		// no GPU work is recorded, so every frame slot is retired as soon as it comes back
+		device.getDeletionQueue().beginFrame(firstFrame + frame, MAX_FRAMES_IN_FLIGHT);
+		residency.beginFrame(firstFrame + frame, MAX_FRAMES_IN_FLIGHT);
+
+		if (frame != 0)
+			peakRatio = std::max(peakRatio, budget.getUsageRatio(heap));
+
+		if (frame != 0 && streamedBytes > budget.getHeap(heap).budget * 3 / 2)
+			break;
+
+		std::vector<vkpp::ResidencyHandle> &frameHandles {workingSet.emplace_back()};
+		for (VkDeviceSize bytes {0}; bytes < BENCHMARK_RESIDENCY_FRAME_BYTES; bytes += bufferSize)
+		{
+			vkpp::Buffer *buffer {new vkpp::Buffer(device.getAllocator().createBuffer(
+				bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			))};
+			heap = device.getPhysicalDevice().getMemoryProperties().memoryTypes[buffer->allocation.memoryType].heapIndex;
+			streamedBytes += buffer->allocation.size;
+
+			vkpp::ResidencyHandle handle {residency.add(buffer->allocation, [&device, &resident, buffer] {
+				std::erase_if(resident, [buffer](const auto &it) {return it.second == buffer;});
+				device.getDeletionQueue().retire([&device, buffer] {
+					device.getAllocator().destroyBuffer(*buffer);
+					delete buffer;
+				});
+			})};
+			resident[handle] = buffer;
+			frameHandles.push_back(handle);
+		}
+
+		if (workingSet.size() > BENCHMARK_RESIDENCY_WORKING_SET)
+			workingSet.erase(workingSet.begin());
+
+		for (const auto &handles : workingSet)
+		{
+			for (auto handle : handles)
+				residency.touch(handle);
+		}
+	}
+	double elapsed {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+
+	const vkpp::ResidencyStatistics &statistics {residency.getStatistics()};
+	std::clog << "Streamed " << streamedBytes / (1024 * 1024) << " MiB in " << bufferSize / 1024 << " KiB buffers through a "
+		<< budget.getHeap(heap).budget / (1024 * 1024) << " MiB " << (budget.isDriverReported() ? "driver reported" : "estimated")
+		<< " budget in " << frame << " frames (" << elapsed / static_cast<double> (std::max<uint64_t> (frame, 1)) << " ms per frame) : "
+		<< statistics.evictedCount << " evictions (" << statistics.evictedBytes / (1024 * 1024) << " MiB), peak usage "
+		<< peakRatio * 100.f << "% of budget for a " << residency.getParameters().evictionThreshold * 100.f << "% threshold, "
+		<< statistics.starvedFrameCount << " starved frames" << std::endl;
+
+	for (const auto &[handle, buffer] : resident)
+	{
+		residency.remove(handle);
+		device.getAllocator().destroyBuffer(*buffer);
+		delete buffer;
+	}
+
+	device.getDeletionQueue().flush();
+
+	if (peakRatio > residency.getParameters().evictionThreshold)
+		throw std::runtime_error("Residency manager let the usage go over its eviction threshold");
+
+	// the working set stays far below the budget : starving means the evictions didn't bring the usage down
+	if (statistics.starvedFrameCount != 0)
+		throw std::runtime_error("Residency manager evictions didn't lower the heap's usage");
+}
+
+
+void benchmarkResidency(vkpp::Instance &instance)
+{
+	for (auto bufferSize : BENCHMARK_RESIDENCY_BUFFER_SIZES)
+		benchmarkResidency(instance, bufferSize);
+}
+
+
+void benchmarkDefragmentation(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	const vkpp::DeviceDispatch &dispatch {device.getDispatch()};
+	vkpp::CommandContext context {device, vkpp::QueueType::graphics, 1, 1};
+	vkpp::Defragmenter defragmenter {device};
+
+	// three buffers out of four freed, which leaves every block a quarter used
+	VkBufferUsageFlags usage {VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+	std::vector<vkpp::Buffer> buffers (BENCHMARK_DEFRAG_BUFFERS);
+	for (auto &buffer : buffers)
+		buffer = device.getAllocator().createBuffer(BENCHMARK_DEFRAG_BUFFER_SIZE, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	std::vector<vkpp::DefragmentationHandle> handles {};
+	uint64_t patchedCount {0};
+
+	for (uint32_t i {0}; i < BENCHMARK_DEFRAG_BUFFERS; i++)
+	{
+		if (i % 4 != 0)
+			device.getAllocator().destroyBuffer(buffers[i]);
+		else
+			handles.push_back(defragmenter.add(&buffers[i], usage, [&patchedCount] {++patchedCount;}));
+	}
+
+	vkpp::AllocatorStatistics before {device.getAllocator().getStatistics()};
+	double recordTime {0.0};
+	uint64_t frame {0};
+	uint64_t firstFrame {device.getDeletionQueue().getCurrentFrame() + 1};
+
+	// no frame in flight once the device is idle, every frame retires the previous one's old buffers
+	for (; frame < BENCHMARK_FRAMES; frame++)
+	{
+		device.getDeletionQueue().beginFrame(firstFrame + frame, 1);
+
+		VkCommandBuffer commandBuffer {context.beginFrame(0)};
+		const vkpp::DefragmentationFrame &moves {defragmenter.record(commandBuffer)};
+		context.endFrame();
+		recordTime += moves.time;
+
+		if (moves.moveCount == 0)
+			break;
+
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		if (dispatch.vkQueueSubmit(device.getQueue(vkpp::QueueType::graphics), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("Can't submit the defragmentation benchmark");
+		dispatch.vkDeviceWaitIdle(device.get());
+	}
+
+	device.getDeletionQueue().flush();
+	vkpp::AllocatorStatistics after {device.getAllocator().getStatistics()};
+	const vkpp::DefragmentationStatistics &statistics {defragmenter.getStatistics()};
+
+	auto fragmentation = [](const vkpp::AllocatorStatistics &statistics) {
+		return statistics.reservedBytes == 0 ? 0.0 : 100.0 * (1.0 - static_cast<double> (statistics.usedBytes) / static_cast<double> (statistics.reservedBytes));
+	};
+
+	std::clog << "Defragmentation of " << handles.size() << " buffers : " << statistics.movedBytes / (1024 * 1024) << " MiB moved in "
+		<< statistics.moveCount << " moves over " << frame << " frames (" << recordTime / static_cast<double> (std::max<uint64_t> (frame, 1))
+		<< " ms per frame), " << before.blockCount << " -> " << after.blockCount << " blocks, fragmentation " << fragmentation(before)
+		<< "% -> " << fragmentation(after) << "%, " << patchedCount << " owners patched, " << statistics.failedMoveCount
+		<< " failed moves" << std::endl;
+
+	for (auto handle : handles)
+		defragmenter.remove(handle);
+
+	for (auto &buffer : buffers)
+		device.getAllocator().destroyBuffer(buffer);
+}
+
+
+void benchmarkStreaming(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	if (!device.hasBindless())
+	{
+		std::clog << "Streaming benchmark skipped, the device lacks descriptor indexing" << std::endl;
+		return;
+	}
+
+	const vkpp::DeviceDispatch &dispatch {device.getDispatch()};
+	vkpp::CommandContext context {device, vkpp::QueueType::graphics, 1, 1};
+
+	uint32_t mipLevels {1};
+	while ((BENCHMARK_STREAMED_TEXTURE_SIZE >> mipLevels) != 0)
+		++mipLevels;
+
+	// RGBA8 mips generated on the fly, slowed down to the simulated disk's speed
+	auto loader = [](uint32_t mipLevel) {
+		uint64_t size {std::max(BENCHMARK_STREAMED_TEXTURE_SIZE >> mipLevel, 1u)};
+		std::vector<std::byte> data (4 * size * size, static_cast<std::byte> (mipLevel));
+		std::this_thread::sleep_for(std::chrono::microseconds(1000 * data.size() / BENCHMARK_STREAMING_DISK_SPEED));
+		return data;
+	};
+
+	// eager loads every mip of every texture before the first frame, streaming only the tails
+	for (bool eager : {true, false})
+	{
+		vkpp::TextureStreamer streamer {device};
+		std::vector<vkpp::StreamedTextureHandle> handles {};
+
+		auto start {std::chrono::steady_clock::now()};
+		for (uint32_t i {0}; i < BENCHMARK_STREAMED_TEXTURES; i++)
+		{
+			handles.push_back(streamer.add({
+				VK_FORMAT_R8G8B8A8_UNORM, {BENCHMARK_STREAMED_TEXTURE_SIZE, BENCHMARK_STREAMED_TEXTURE_SIZE}, mipLevels, loader
+			}));
+
+			if (eager)
+				streamer.request(handles.back(), 0, 1.0f);
+		}
+
+		streamer.flush();
+		device.getBindlessHeap().flush();
+		double firstFrame {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+
+		std::clog << BENCHMARK_STREAMED_TEXTURES << " textures of " << BENCHMARK_STREAMED_TEXTURE_SIZE << "x" << BENCHMARK_STREAMED_TEXTURE_SIZE
+			<< (eager ? " loaded eagerly" : " streamed") << " : " << firstFrame << " ms to the first frame, "
+			<< streamer.getStatistics().peakResidentBytes / (1024 * 1024) << " MiB peak resident";
+
+		if (!eager)
+		{
+			// a quarter of the scene in view asks for full detail, the closest first
+			for (uint32_t i {0}; i < BENCHMARK_STREAMED_TEXTURES / 4; i++)
+				streamer.request(handles[i], 0, static_cast<float> (BENCHMARK_STREAMED_TEXTURES - i));
+
+			// the frames acquire the uploads of the transfer queue before the new indices are published, the way
+			// a frame loop would
+			auto inView = [&streamer, &handles] {
+				return std::all_of(handles.begin(), handles.begin() + BENCHMARK_STREAMED_TEXTURES / 4, [&streamer](auto handle) {
+					return streamer.getResidentMip(handle) == 0;
+				});
+			};
+
+			uint64_t firstFrame {device.getDeletionQueue().getCurrentFrame() + 1};
+			uint32_t frame {0};
+			for (; frame < BENCHMARK_STREAMING_MAX_FRAMES && !inView(); frame++)
+			{
+				device.getDeletionQueue().beginFrame(firstFrame + frame, 1);
+
+				VkCommandBuffer commandBuffer {context.beginFrame(0)};
+				streamer.update(commandBuffer);
+				context.endFrame();
+				device.getBindlessHeap().flush();
+
+				VkSubmitInfo submitInfo {};
+				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &commandBuffer;
+
+				if (dispatch.vkQueueSubmit(device.getQueue(vkpp::QueueType::graphics), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+					throw std::runtime_error("Can't submit the streaming benchmark");
+				dispatch.vkDeviceWaitIdle(device.get());
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			if (!inView())
+				throw std::runtime_error("Can't stream the textures in view in " + std::to_string(BENCHMARK_STREAMING_MAX_FRAMES) + " frames");
+
+			device.getDeletionQueue().flush();
+			std::clog << ", " << streamer.getStatistics().residentBytes / (1024 * 1024) << " MiB once a quarter is in view after "
+				<< frame << " frames, " << streamer.getStatistics().maxLatency << " ms worst request latency";
+		}
+
+		std::clog << std::endl;
+
+		for (auto handle : handles)
+			streamer.remove(handle);
+	}
+
+	device.getDeletionQueue().flush();
+}
+
+
+void benchmarkAssets(vkpp::Instance &instance)
+{
+	vkpp::Device &device {instance.getDevice()};
+	std::filesystem::path directory {std::filesystem::temp_directory_path() / "vkpp_assets"};
+	std::filesystem::create_directories(directory);
+
+	// the same payloads as loose files and as a pack, both just written and so in the page cache
+	vkpp::AssetPackWriter writer {};
+	for (uint32_t i {0}; i < BENCHMARK_ASSETS; i++)
+	{
+		std::vector<std::byte> data (BENCHMARK_ASSET_SIZE, static_cast<std::byte> (i));
+		std::ofstream file {directory / (std::to_string(i) + ".bin"), std::ios::binary};
+		file.write(reinterpret_cast<const char*> (data.data()), static_cast<std::streamsize> (data.size()));
+		writer.addBuffer(std::to_string(i), std::move(data));
+	}
+
+	writer.write(directory / "assets.vkpack");
+
+	vkpp::StagingRing ring {device, 64 * 1024 * 1024};
+	std::vector<vkpp::Buffer> buffers {};
+	buffers.reserve(BENCHMARK_ASSETS);
+
+	// every file read into a vector of its own, then copied into the ring
+	auto start {std::chrono::steady_clock::now()};
+	for (uint32_t i {0}; i < BENCHMARK_ASSETS; i++)
+	{
+		std::ifstream file {directory / (std::to_string(i) + ".bin"), std::ios::binary | std::ios::ate};
+		std::vector<std::byte> data (static_cast<size_t> (file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*> (data.data()), static_cast<std::streamsize> (data.size()));
+
+		buffers.push_back(device.getAllocator().createBuffer(
+			data.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		));
+		ring.upload(buffers.back().buffer, 0, data.data(), data.size());
+	}
+
+	ring.wait(ring.flush());
+	double naive {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+
+	for (auto &buffer : buffers)
+		device.getAllocator().destroyBuffer(buffer);
+	buffers.clear();
+
+	// the pack mapped, every payload copied from the mapping into the ring
+	start = std::chrono::steady_clock::now();
+	{
+		vkpp::AssetPack pack {device, directory / "assets.vkpack"};
+		for (const auto &entry : pack.getEntries())
+			pack.prefetch(entry);
+
+		for (const auto &entry : pack.getEntries())
+			buffers.push_back(pack.loadBuffer(ring, entry, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+
+		ring.wait(ring.flush());
+	}
+	double packed {std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count()};
+
+	std::clog << BENCHMARK_ASSETS << " assets of " << BENCHMARK_ASSET_SIZE / 1024 << " KiB : " << naive << " ms from loose files, "
+		<< packed << " ms from a mapped pack" << std::endl;
+
+	for (auto &buffer : buffers)
+		device.getAllocator().destroyBuffer(buffer);
+
+	std::filesystem::remove_all(directory);
+}
+
+
+void runHeadless(vkpp::Instance &instance, vkpp::CommandContext &commands, vkpp::GpuProfiler &profiler, bool dump)
+{
+	vkpp::OffscreenTargets &targets {instance.getOffscreenTargets()};
+	std::atomic<uint64_t> checksum {0};
+
+	// reads the mapped memory in place, as a consumer encoding or streaming the frame would
+	vkpp::Readback::Callback consume {[&checksum](const vkpp::ReadbackResult &result) {
+		const uint8_t *bytes {static_cast<const uint8_t*> (result.data)};
+		uint64_t sum {0};
+		for (VkDeviceSize i {0}; i < result.size; i += 4096)
+			sum += bytes[i];
+		checksum += sum;
+	}};
+
+	auto start {std::chrono::steady_clock::now()};
+
+	for (uint32_t i {0}; i < BENCHMARK_FRAMES; i++)
+	{
+		const vkpp::FrameContext &frame {targets.beginFrame()};
+		bool last {i + 1 == BENCHMARK_FRAMES};
+		targets.endFrame({recordFrame(commands, profiler, frame)}, dump && last ? vkpp::Readback::writeToFile("frame_") : consume);
+	}
+
+	targets.getReadback()->flush();
+	double elapsed {std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count()};
+	vkpp::ReadbackStatistics statistics {targets.getReadback()->getStatistics()};
+
+	std::clog << BENCHMARK_FRAMES << " headless frames of " << targets.getExtent().width << "x" << targets.getExtent().height << " : "
+		<< BENCHMARK_FRAMES / elapsed << " frames/s rendered, "
+		<< statistics.completedCount * 1000.0 / statistics.activeTime << " frames/s read back, "
+		<< "submit to bytes available " << statistics.totalLatency / statistics.completedCount << " ms average, "
+		<< statistics.maxLatency << " ms max, " << statistics.droppedCount << " dropped" << std::endl;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	// benchmarks to run are named on the command line, e.g. `sandbox frames uploads`
+	std::set<std::string> benchmarks {argv + 1, argv + argc};
+
 	try
 	{
-		SDL_Init(SDL_INIT_VIDEO);
+		// `sandbox headless` renders offscreen, without any window, `dump` also writes its last frame to disk
+		bool headless {benchmarks.contains("headless")};
+
+		SDL_Init(headless ? 0 : SDL_INIT_VIDEO);
 		std::unique_ptr<
 			SDL_Window,
 			decltype([](SDL_Window *window){SDL_DestroyWindow(window);})
-		> window {SDL_CreateWindow(
+		> window {headless ? nullptr : SDL_CreateWindow(
 			"vulkanpp",
 			SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
 			16 * 70, 9 * 70,
-			SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN
+			SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE
 		)};
 
 		vkpp::InstanceParameter instanceParameter {};
 		instanceParameter.window = window.get();
 		instanceParameter.appName = "vulkanpp";
 		instanceParameter.appVersion = {1, 0, 0};
-		instanceParameter.vulkanVersion = vkpp::VulkanVersion::v10;
+		instanceParameter.vulkanVersion = vkpp::VulkanVersion::v12;
 		//instanceParameter.instanceExtensions = {"vk_this_is_not_a_valid_extension_haha"};
 
+		instanceParameter.pipelineCachePath = "vulkanpp.pipelines";
+
+		auto startupStart {std::chrono::steady_clock::now()};
 		vkpp::Instance instance {instanceParameter};
+		std::clog << "Startup with " << (instance.getDevice().getPipelineCache().isWarm() ? "warm" : "cold") << " pipeline cache ("
+			<< instance.getDevice().getPipelineCache().getLoadedSize() << " bytes loaded) : "
+			<< std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - startupStart).count() << " ms"
+			<< std::endl;
+		std::clog << "\tof which physical device selection : " << instance.getStartupTimings().physicalDeviceSelection << " ms, device creation : "
+			<< instance.getStartupTimings().deviceCreation << " ms" << std::endl;
+		vkpp::CommandContext commands {instance.getDevice(), vkpp::QueueType::graphics, MAX_FRAMES_IN_FLIGHT, 1};
+		vkpp::GpuProfiler profiler {instance.getDevice(), MAX_FRAMES_IN_FLIGHT};
+
+		if (headless)
+			runHeadless(instance, commands, profiler, benchmarks.contains("dump"));
+
+		if (benchmarks.contains("frames") && !headless)
+			benchmarkFramesInFlight(instance, commands, profiler);
+
+		if (benchmarks.contains("allocator"))
+			benchmarkAllocator(instance);
+
+		if (benchmarks.contains("uploads"))
+			benchmarkUploads(instance);
+
+		if (benchmarks.contains("commands"))
+			benchmarkRecording(instance);
 
-		
-		bool running {true};
+		if (benchmarks.contains("dispatch"))
+			benchmarkDispatch(instance);
+
+		if (benchmarks.contains("scheduler"))
+			benchmarkScheduler(instance);
+
+		if (benchmarks.contains("graph"))
+			benchmarkRenderGraph(instance);
+
+		if (benchmarks.contains("tracker"))
+			benchmarkImageTracker(instance);
+
+		if (benchmarks.contains("bindless"))
+			benchmarkBindless(instance);
+
+		if (benchmarks.contains("descriptors"))
+			benchmarkDescriptors(instance);
+
+		if (benchmarks.contains("uniforms"))
+			benchmarkUniforms(instance);
+
+		if (benchmarks.contains("residency"))
+			benchmarkResidency(instance);
+
+		if (benchmarks.contains("defrag"))
+			benchmarkDefragmentation(instance);
+
+		if (benchmarks.contains("streaming"))
+			benchmarkStreaming(instance);
+
+		if (benchmarks.contains("assets"))
+			benchmarkAssets(instance);
+
+
+		bool running {!headless};
 		SDL_Event event {};
+		uint64_t recreateCount {headless ? 0 : instance.getSwapChain().getStatistics().recreateCount};
 
 		while (running)
 		{
@@ -44,8 +1158,31 @@ int main(int, char *[])
 			{
 				if (event.type == SDL_QUIT || event.type == SDL_KEYDOWN)
 					running = false;
+
+				else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+					instance.getSwapChain().requestRecreate();
+			}
+
+			if (SDL_GetWindowFlags(window.get()) & SDL_WINDOW_MINIMIZED)
+				continue;
+
+			const vkpp::FrameContext &frame {instance.getSwapChain().beginFrame()};
+			instance.getSwapChain().endFrame({recordFrame(commands, profiler, frame)});
+
+			const vkpp::FrameStatistics &statistics {instance.getSwapChain().getStatistics()};
+			if (statistics.recreateCount != recreateCount)
+			{
+				recreateCount = statistics.recreateCount;
+				std::clog << "Swap chain rebuilt (" << recreateCount << " rebuilds), resize latency : "
+					<< statistics.lastRecreateLatency << " ms" << std::endl;
 			}
 		}
+
+		instance.getDevice().getDispatch().vkDeviceWaitIdle(instance.getDevice().get());
+
+		// `sandbox profile` dumps the GPU scopes of the whole run, to open in chrome://tracing
+		if (benchmarks.contains("profile"))
+			profiler.exportChromeTrace("vulkanpp.trace.json");
 	}
 
 	catch (const std::exception &exception)
@@ -56,4 +1193,4 @@ int main(int, char *[])
 	SDL_Quit();
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,123 @@
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vkpp/assetPackWriter.hpp"
+
+
+
+const std::unordered_map<std::string_view, VkFormat> FORMATS {
+	{"r8", VK_FORMAT_R8_UNORM},
+	{"rg8", VK_FORMAT_R8G8_UNORM},
+	{"rgba8", VK_FORMAT_R8G8B8A8_UNORM},
+	{"rgba8_srgb", VK_FORMAT_R8G8B8A8_SRGB},
+	{"rgba16f", VK_FORMAT_R16G16B16A16_SFLOAT},
+	{"rgba32f", VK_FORMAT_R32G32B32A32_SFLOAT},
+	{"bc1", VK_FORMAT_BC1_RGBA_UNORM_BLOCK},
+	{"bc1_srgb", VK_FORMAT_BC1_RGBA_SRGB_BLOCK},
+	{"bc3", VK_FORMAT_BC3_UNORM_BLOCK},
+	{"bc3_srgb", VK_FORMAT_BC3_SRGB_BLOCK},
+	{"bc4", VK_FORMAT_BC4_UNORM_BLOCK},
+	{"bc5", VK_FORMAT_BC5_UNORM_BLOCK},
+	{"bc7", VK_FORMAT_BC7_UNORM_BLOCK},
+	{"bc7_srgb", VK_FORMAT_BC7_SRGB_BLOCK}
+};
+
+
+std::vector<std::byte> readFile(const std::filesystem::path &path)
+{
+	std::ifstream file {path, std::ios::binary | std::ios::ate};
+	if (!file)
+		throw std::runtime_error("Can't open " + path.string());
+
+	std::vector<std::byte> data (static_cast<size_t> (file.tellg()));
+	file.seekg(0);
+
+	if (!file.read(reinterpret_cast<char*> (data.data()), static_cast<std::streamsize> (data.size())))
+		throw std::runtime_error("Can't read " + path.string());
+
+	return data;
+}
+
+
+VkFormat parseFormat(std::string_view name)
+{
+	auto found {FORMATS.find(name)};
+	if (found != FORMATS.end())
+		return found->second;
+
+	// any other format by its VkFormat value
+	return static_cast<VkFormat> (std::stoi(std::string(name)));
+}
+
+
+int main(int argc, char *argv[])
+{
+	// `packer out.vkpack --buffer mesh mesh.bin --image albedo bc7 1024 1024 1 albedo0.bin albedo1.bin ...`, every
+	// mip file holding its layers one after the other, already transcoded to the image's format
+	std::vector<std::string_view> arguments {argv + 1, argv + argc};
+	if (arguments.empty())
+	{
+		std::cerr << "Usage : packer <output> [--buffer <name> <file>] [--image <name> <format> <width> <height> <layers> <mip files>...]" << std::endl;
+		return 1;
+	}
+
+	try
+	{
+		vkpp::AssetPackWriter writer {};
+		size_t i {1};
+
+		while (i < arguments.size())
+		{
+			if (arguments[i] == "--buffer" && i + 2 < arguments.size())
+			{
+				writer.addBuffer(arguments[i + 1], readFile(arguments[i + 2]));
+				i += 3;
+				continue;
+			}
+
+			if (arguments[i] == "--image" && i + 6 < arguments.size())
+			{
+				std::string_view name {arguments[i + 1]};
+				VkFormat format {parseFormat(arguments[i + 2])};
+				VkExtent3D extent {
+					static_cast<uint32_t> (std::stoul(std::string(arguments[i + 3]))),
+					static_cast<uint32_t> (std::stoul(std::string(arguments[i + 4]))),
+					1
+				};
+				uint32_t layers {static_cast<uint32_t> (std::stoul(std::string(arguments[i + 5])))};
+
+				std::vector<std::vector<std::byte>> mips {};
+				for (i += 6; i < arguments.size() && !arguments[i].starts_with("--"); i++)
+					mips.push_back(readFile(arguments[i]));
+
+				writer.addImage(name, format, extent, layers, std::move(mips));
+				continue;
+			}
+
+			throw std::runtime_error("Unexpected argument " + std::string(arguments[i]));
+		}
+
+		writer.write(arguments[0]);
+		std::clog << writer.getAssetCount() << " asset(s) packed in " << arguments[0] << std::endl;
+	}
+
+	catch (const std::exception &exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}